@@ -70,12 +70,18 @@ VPATH += .
 SRC += startup_gcc.c
 SRC += main.c
 SRC += console_task.c
+SRC += console_task_cli.c
 SRC += application_task.c
 SRC += application_task_cli.c
+SRC += log_task.c
 
 
 DEFINES += -DSOFT_SE
+DEFINES += -DAES_BACKEND=AES_BACKEND_TTABLE
+# DEFINES += -DAES_BACKEND=AES_BACKEND_CONST_TIME
 DEFINES += -DCONTEXT_MANAGEMENT_ENABLED
+# Run-time statistics and the console top command, see rtos_stats.h
+# DEFINES += -DRTOS_STATS_ENABLED
 
 INCLUDES += -I./comms/lorawan/common/LmHandler/packages
 INCLUDES += -I./comms/lorawan/common/LmHandler
@@ -94,9 +100,13 @@ SRC += cmac.c
 SRC += soft-se.c
 SRC += lmh_callbacks.c
 SRC += lmhp_fragmentation.c
+SRC += lorawan_aggregate.c
+SRC += lorawan_rx_pool.c
 SRC += lorawan_se.c
 SRC += lorawan_task.c
 SRC += lorawan_task_cli.c
+SRC += lorawan_tx_pool.c
+SRC += lorawan_tx_scheduler.c
 
 INCLUDES += -I./comms/ble
 INCLUDES += -I./comms/ble/tag
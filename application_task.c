@@ -106,6 +106,7 @@ static void application_task(void *parameter)
                 am_util_stdio_printf("%02x ", packet.pui8Payload[i]);
             }
             am_util_stdio_printf("\n\r\n\r");
+            lorawan_receive_release(&packet);
         }
         am_hal_gpio_state_write(AM_BSP_GPIO_LED0, AM_HAL_GPIO_OUTPUT_TOGGLE);
     }
@@ -39,6 +39,7 @@
 #include <FreeRTOS_CLI.h>
 
 #include "application_task_cli.h"
+#include "lorawan.h"
 
 static portBASE_TYPE application_task_cli_entry(char *pui8OutBuffer,
                                                 size_t ui32OutBufferLength,
@@ -82,7 +83,10 @@ application_task_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, cons
     }
     else if (strcmp(argv[1], "reset") == 0)
     {
-        NVIC_SystemReset();
+        // The LoRaWAN task stores its pending context before resetting.
+        lorawan_command_t command;
+        command.eCommand = LORAWAN_RESET;
+        lorawan_send_command(&command);
     }
 
     return pdFALSE;
@@ -57,6 +57,8 @@
 #include "wdxs/wdxs_api.h"
 #include "tag/tag_api.h"
 
+#include <rtos_stats.h>
+
 #include "ble.h"
 #include "ble_stack.h"
 #include "ble_task.h"
@@ -71,7 +73,9 @@ static char wsf_trace_buffer[256];
 
 void am_ble_isr(void)
 {
+    rtos_stats_isr_enter(RTOS_STATS_ISR_BLE);
     HciDrvIntService();
+    rtos_stats_isr_exit(RTOS_STATS_ISR_BLE);
 }
 
 void WsfOsEventNotify(void)
@@ -68,6 +68,9 @@ enum
 /*! Read RSSI interval in seconds */
 #define TAG_READ_RSSI_INTERVAL      3
 
+/*! Time in ms by which an RSSI read may be delayed to share a wake-up */
+#define TAG_READ_RSSI_SLACK_MS      500
+
 /**************************************************************************************************
   Local Variables
 **************************************************************************************************/
@@ -1050,6 +1053,7 @@ void TagHandlerInit(wsfHandlerId_t handlerId)
   /* initialize control block */
   tagCb.rssiTimer.handlerId = handlerId;
   tagCb.rssiTimer.msg.event = TAG_RSSI_TIMER_IND;
+  WsfTimerSetSlackMs(&tagCb.rssiTimer, TAG_READ_RSSI_SLACK_MS);
   tagCb.inProgress = FALSE;
 
   /* Set configuration pointers */
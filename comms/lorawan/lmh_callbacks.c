@@ -32,22 +32,49 @@
 #include <am_mcu_apollo.h>
 #include <am_util.h>
 
+#include <string.h>
+
 #include <FreeRTOS.h>
-#include <list.h>
+#include <queue.h>
+#include <semphr.h>
+#include <task.h>
 
 #include <LmHandlerMsgDisplay.h>
 
+#include "deferred_log.h"
 #include "lorawan_config.h"
+#include "random_pool.h"
 
-#include "console_task.h"
 #include "lmh_callbacks.h"
 #include "lorawan.h"
+#include "lorawan_rx_pool.h"
 #include "lorawan_task.h"
 
-static List_t lorawan_receive_callback_list;
+#define LORAWAN_RX_PORTS    224
+
+// Consumers of the FPorts, several may share a port.  A queue is registered
+// as lorawan_receive_queue_send with the queue as context.
+typedef struct
+{
+    uint32_t ui32Port;
+    lorawan_receive_callback_t pfnCallback;
+    void *pvContext;
+} lorawan_rx_consumer_t;
+
+static lorawan_rx_consumer_t lorawan_rx_consumers[LORAWAN_RX_CONSUMERS];
+static SemaphoreHandle_t lorawan_rx_consumers_mutex;
+static uint32_t lorawan_rx_dispatched;
+static uint32_t lorawan_rx_no_buffer;
+static uint32_t lorawan_rx_queue_full;
+static uint32_t lorawan_rx_unclaimed;
 
 static void lmh_rx_callback_service(LmHandlerAppData_t *appData, LmHandlerRxParams_t *params);
 
+static uint32_t lmh_get_random_seed(void)
+{
+    return random_pool_get_u32();
+}
+
 static void lmh_on_mac_process(void)
 {
     lorawan_task_wake();
@@ -55,34 +82,42 @@ static void lmh_on_mac_process(void)
 
 static void lmh_on_nvm_data_change(LmHandlerNvmContextStates_t state, uint16_t size)
 {
-    am_util_stdio_printf("\r\n");
+    DEFERRED_LOG("\r\n");
     DisplayNvmDataChange(state, size);
-    console_print_prompt();
 }
 
 static void lmh_on_network_parameters_change(CommissioningParams_t *params)
 {
-    am_util_stdio_printf("\r\n");
+    DEFERRED_LOG("\r\n");
     DisplayNetworkParametersUpdate(params);
-    console_print_prompt();
 }
 
 static void
 lmh_on_mac_mcps_request(LoRaMacStatus_t status, McpsReq_t *mcpsReq, TimerTime_t nextTxDelay)
 {
-    am_util_stdio_printf("\r\n");
+    if (status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED)
+    {
+        lorawan_task_uplink_holdoff(nextTxDelay);
+    }
+
+    DEFERRED_LOG("\r\n");
     DisplayMacMcpsRequestUpdate(status, mcpsReq, nextTxDelay);
-    am_util_stdio_printf("FPORT       : %d\r\n", mcpsReq->Req.Unconfirmed.fPort);
-    am_util_stdio_printf("BUFFERSIZE  : %d\r\n\r\n", mcpsReq->Req.Unconfirmed.fBufferSize);
-    console_print_prompt();
+    DEFERRED_LOG("FPORT       : %d\r\n"
+                 "BUFFERSIZE  : %d\r\n\r\n",
+                 mcpsReq->Req.Unconfirmed.fPort,
+                 mcpsReq->Req.Unconfirmed.fBufferSize);
 }
 
 static void
 lmh_on_mac_mlme_request(LoRaMacStatus_t status, MlmeReq_t *mlmeReq, TimerTime_t nextTxDelay)
 {
-    am_util_stdio_printf("\r\n");
+    if (status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED)
+    {
+        lorawan_task_uplink_holdoff(nextTxDelay);
+    }
+
+    DEFERRED_LOG("\r\n");
     DisplayMacMlmeRequestUpdate(status, mlmeReq, nextTxDelay);
-    console_print_prompt();
 }
 
 static void lmh_on_join_request(LmHandlerJoinParams_t *params)
@@ -93,7 +128,7 @@ static void lmh_on_join_request(LmHandlerJoinParams_t *params)
     }
     else
     {
-        am_util_stdio_printf("\r\n");
+        DEFERRED_LOG("\r\n");
         DisplayJoinRequestUpdate(params);
 
         LmHandlerRequestClass(LORAWAN_DEFAULT_CLASS);
@@ -103,16 +138,14 @@ static void lmh_on_join_request(LmHandlerJoinParams_t *params)
 
 static void lmh_on_tx_data(LmHandlerTxParams_t *params)
 {
-    am_util_stdio_printf("\r\n");
+    DEFERRED_LOG("\r\n");
     DisplayTxUpdate(params);
-    console_print_prompt();
 }
 
 static void lmh_on_rx_data(LmHandlerAppData_t *appData, LmHandlerRxParams_t *params)
 {
-    am_util_stdio_printf("\r\n");
+    DEFERRED_LOG("\r\n");
     DisplayRxUpdate(appData, params);
-    console_print_prompt();
 
     lmh_rx_callback_service(appData, params);
 }
@@ -120,29 +153,28 @@ static void lmh_on_rx_data(LmHandlerAppData_t *appData, LmHandlerRxParams_t *par
 static void lmh_on_class_change(DeviceClass_t deviceClass)
 {
     DisplayClassUpdate(deviceClass);
-    console_print_prompt();
 }
 
 static void lmh_on_beacon_status_change(LoRaMacHandlerBeaconParams_t *params)
 {
     DisplayBeaconUpdate(params);
-    console_print_prompt();
 }
 
 static void lmh_on_sys_time_update(bool isSynchronized, int32_t timeCorrection)
 {
-    am_util_stdio_printf("\r\n");
-    am_util_stdio_printf("Clock Synchronized: %d\r\n", isSynchronized);
-    am_util_stdio_printf("Correction: %d\r\n", timeCorrection);
-    am_util_stdio_printf("\r\n");
-    console_print_prompt();
+    DEFERRED_LOG("\r\n"
+                 "Clock Synchronized: %d\r\n"
+                 "Correction: %d\r\n"
+                 "\r\n",
+                 isSynchronized,
+                 timeCorrection);
 }
 
 void lmh_callbacks_setup(LmHandlerCallbacks_t *cb)
 {
     cb->GetBatteryLevel = NULL;
     cb->GetTemperature = NULL;
-    cb->GetRandomSeed = NULL;
+    cb->GetRandomSeed = lmh_get_random_seed;
     cb->OnMacProcess = lmh_on_mac_process;
     cb->OnNvmDataChange = lmh_on_nvm_data_change;
     cb->OnNetworkParametersChange = lmh_on_network_parameters_change;
@@ -155,62 +187,184 @@ void lmh_callbacks_setup(LmHandlerCallbacks_t *cb)
     cb->OnBeaconStatusChange = lmh_on_beacon_status_change;
     cb->OnSysTimeUpdate = lmh_on_sys_time_update;
 
-    vListInitialise(&lorawan_receive_callback_list);
+    // Recursive, so that a callback can unregister itself.
+    lorawan_rx_consumers_mutex = xSemaphoreCreateRecursiveMutex();
+    lorawan_rx_pool_init();
+}
+
+static void lorawan_receive_queue_send(lorawan_rx_packet_t *pPacket, void *pvContext)
+{
+    if (xQueueSend((QueueHandle_t)pvContext, pPacket, 0) != pdPASS)
+    {
+        lorawan_receive_release(pPacket);
+        lorawan_rx_queue_full++;
+    }
+}
+
+bool lorawan_receive_register_callback(uint32_t ui32Port, lorawan_receive_callback_t pfnCallback,
+                                       void *pvContext)
+{
+    bool bRegistered = false;
+
+    if ((ui32Port >= LORAWAN_RX_PORTS) || (pfnCallback == NULL))
+    {
+        return false;
+    }
+
+    xSemaphoreTakeRecursive(lorawan_rx_consumers_mutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < LORAWAN_RX_CONSUMERS; i++)
+    {
+        if (lorawan_rx_consumers[i].pfnCallback == NULL)
+        {
+            lorawan_rx_consumers[i].ui32Port = ui32Port;
+            lorawan_rx_consumers[i].pvContext = pvContext;
+            lorawan_rx_consumers[i].pfnCallback = pfnCallback;
+            bRegistered = true;
+            break;
+        }
+    }
+    xSemaphoreGiveRecursive(lorawan_rx_consumers_mutex);
+
+    return bRegistered;
+}
+
+void lorawan_receive_unregister_callback(uint32_t ui32Port, lorawan_receive_callback_t pfnCallback,
+                                         void *pvContext)
+{
+    // Once the mutex is taken no dispatch is under way, the callback is not
+    // called after this returns.
+    xSemaphoreTakeRecursive(lorawan_rx_consumers_mutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < LORAWAN_RX_CONSUMERS; i++)
+    {
+        if ((lorawan_rx_consumers[i].ui32Port == ui32Port) &&
+            (lorawan_rx_consumers[i].pfnCallback == pfnCallback) &&
+            (lorawan_rx_consumers[i].pvContext == pvContext))
+        {
+            lorawan_rx_consumers[i].pfnCallback = NULL;
+            break;
+        }
+    }
+    xSemaphoreGiveRecursive(lorawan_rx_consumers_mutex);
 }
 
 QueueHandle_t lorawan_receive_register(uint32_t ui32Port, uint32_t elements)
 {
-    QueueHandle_t queue = xQueueCreate(elements, sizeof(lorawan_rx_packet_t));
-    ListItem_t *list_item = pvPortMalloc(sizeof(ListItem_t));
-    vListInitialiseItem(list_item);
+    QueueHandle_t queue;
+
+    if (ui32Port >= LORAWAN_RX_PORTS)
+    {
+        return NULL;
+    }
 
-    list_item->xItemValue = ui32Port;
-    list_item->pvOwner = queue;
+    queue = xQueueCreate(elements, sizeof(lorawan_rx_packet_t));
+    if (queue && !lorawan_receive_register_callback(ui32Port, lorawan_receive_queue_send, queue))
+    {
+        vQueueDelete(queue);
+        queue = NULL;
+    }
 
-    vListInsertEnd(&lorawan_receive_callback_list, list_item);
-    
     return queue;
 }
 
 void lorawan_receive_unregister(QueueHandle_t handle)
 {
-    ListItem_t *pItem = listGET_HEAD_ENTRY(&lorawan_receive_callback_list);
+    lorawan_rx_packet_t packet;
 
-    while (pItem != listGET_END_MARKER(&lorawan_receive_callback_list))
+    xSemaphoreTakeRecursive(lorawan_rx_consumers_mutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < LORAWAN_RX_CONSUMERS; i++)
     {
-        if (pItem->pvOwner == handle)
+        if ((lorawan_rx_consumers[i].pfnCallback == lorawan_receive_queue_send) &&
+            (lorawan_rx_consumers[i].pvContext == handle))
         {
-            listREMOVE_ITEM(pItem);
-            vPortFree(pItem);
-            vQueueDelete(handle);
-            return;
+            lorawan_rx_consumers[i].pfnCallback = NULL;
         }
+    }
+    xSemaphoreGiveRecursive(lorawan_rx_consumers_mutex);
+
+    while (xQueueReceive(handle, &packet, 0) == pdPASS)
+    {
+        lorawan_receive_release(&packet);
+    }
+    vQueueDelete(handle);
+}
 
-        pItem = listGET_NEXT(pItem);
+void lorawan_receive_release(lorawan_rx_packet_t *pPacket)
+{
+    if (pPacket->pui8Payload)
+    {
+        lorawan_rx_pool_free(pPacket->pui8Payload);
+        pPacket->pui8Payload = NULL;
     }
 }
 
+void lorawan_receive_stats(lorawan_rx_stats_t *pStats)
+{
+    lorawan_rx_pool_stats(pStats);
+
+    taskENTER_CRITICAL();
+    pStats->ui32Dispatched = lorawan_rx_dispatched;
+    pStats->ui32NoBuffer = lorawan_rx_no_buffer;
+    pStats->ui32QueueFull = lorawan_rx_queue_full;
+    pStats->ui32Unclaimed = lorawan_rx_unclaimed;
+    taskEXIT_CRITICAL();
+}
+
+// The payload is copied out of the MAC, whose receive buffer the next
+// downlink overwrites, into a pool buffer per consumer that the consumer then
+// owns.  The callbacks run with the scheduler running, so that they may block
+// or transmit; the mutex only keeps the table from changing meanwhile.
 void lmh_rx_callback_service(LmHandlerAppData_t *appData, LmHandlerRxParams_t *params)
 {
-    ListItem_t *pItem = listGET_HEAD_ENTRY(&lorawan_receive_callback_list);
+    lorawan_rx_consumer_t *pConsumer;
+    lorawan_rx_packet_t packet;
+    bool bClaimed = false;
+
+    // MLME indications come without data.
+    if ((appData == NULL) || (appData->Port >= LORAWAN_RX_PORTS))
+    {
+        return;
+    }
 
-    while (pItem != listGET_END_MARKER(&lorawan_receive_callback_list))
+    xSemaphoreTakeRecursive(lorawan_rx_consumers_mutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < LORAWAN_RX_CONSUMERS; i++)
     {
-        if ((pItem->pvOwner) && (pItem->xItemValue == appData->Port))
+        pConsumer = &lorawan_rx_consumers[i];
+        if ((pConsumer->pfnCallback == NULL) || (pConsumer->ui32Port != appData->Port))
         {
-            lorawan_rx_packet_t packet;
-            packet.ui32DownlinkCounter = params->DownlinkCounter;
-            packet.i16DataRate = params->Datarate;
-            packet.i16ReceiveSlot = params->RxSlot;
-            packet.i16RSSI = params->Rssi;
-            packet.i16SNR = params->Snr;
-            packet.ui32Port = appData->Port;
-            packet.ui32Length = appData->BufferSize;
-            packet.pui8Payload = appData->Buffer;
-
-            xQueueSend(pItem->pvOwner, &packet, 0);
+            continue;
         }
+        bClaimed = true;
 
-        pItem = listGET_NEXT(pItem);
+        packet.pui8Payload = NULL;
+        if (appData->BufferSize)
+        {
+            if (appData->BufferSize <= LORAWAN_RX_BLOCK_SIZE)
+            {
+                packet.pui8Payload = lorawan_rx_pool_alloc();
+            }
+            if (packet.pui8Payload == NULL)
+            {
+                lorawan_rx_no_buffer++;
+                continue;
+            }
+            memcpy(packet.pui8Payload, appData->Buffer, appData->BufferSize);
+        }
+
+        packet.ui32DownlinkCounter = params->DownlinkCounter;
+        packet.i16DataRate = params->Datarate;
+        packet.i16ReceiveSlot = params->RxSlot;
+        packet.i16RSSI = params->Rssi;
+        packet.i16SNR = params->Snr;
+        packet.ui32Port = appData->Port;
+        packet.ui32Length = appData->BufferSize;
+
+        pConsumer->pfnCallback(&packet, pConsumer->pvContext);
+        lorawan_rx_dispatched++;
     }
-}
\ No newline at end of file
+    xSemaphoreGiveRecursive(lorawan_rx_consumers_mutex);
+
+    if (!bClaimed)
+    {
+        lorawan_rx_unclaimed++;
+    }
+}
@@ -40,6 +40,7 @@
 
 #include <LmhpFragmentation.h>
 
+#include "deferred_log.h"
 #include "ota_config.h"
 
 #include "lmhp_fragmentation.h"
@@ -51,13 +52,18 @@ static uint8_t auth_req_buffer[AUTH_REQ_BUFFER_SIZE];
 
 static void on_frag_progress(uint16_t counter, uint16_t blocks, uint8_t size, uint16_t lost)
 {
-    am_util_stdio_printf("\r\n");
-    am_util_stdio_printf("###### =========== FRAG_DECODER ============ ######\r\n");
-    am_util_stdio_printf("######               PROGRESS                ######\r\n");
-    am_util_stdio_printf("###### ===================================== ######\r\n");
-    am_util_stdio_printf("RECEIVED    : %5d / %5d Fragments\r\n", counter, blocks);
-    am_util_stdio_printf("              %5d / %5d Bytes\r\n", counter * size, blocks * size);
-    am_util_stdio_printf("LOST        :       %7d Fragments\r\n\r\n", lost);
+    DEFERRED_LOG("\r\n"
+                 "###### =========== FRAG_DECODER ============ ######\r\n"
+                 "######               PROGRESS                ######\r\n"
+                 "###### ===================================== ######\r\n"
+                 "RECEIVED    : %5d / %5d Fragments\r\n"
+                 "              %5d / %5d Bytes\r\n"
+                 "LOST        :       %7d Fragments\r\n\r\n",
+                 counter,
+                 blocks,
+                 counter * size,
+                 blocks * size,
+                 lost);
 }
 
 static void on_frag_done(int32_t status, uint32_t size)
@@ -73,13 +79,16 @@ static void on_frag_done(int32_t status, uint32_t size)
     lorawan_transmit(
         FRAGMENTATION_PORT, LORAMAC_HANDLER_UNCONFIRMED_MSG, AUTH_REQ_BUFFER_SIZE, auth_req_buffer);
 
-    am_util_stdio_printf("\r\n");
-    am_util_stdio_printf("###### =========== FRAG_DECODER ============ ######\r\n");
-    am_util_stdio_printf("######               FINISHED                ######\r\n");
-    am_util_stdio_printf("###### ===================================== ######\r\n");
-    am_util_stdio_printf("STATUS : %ld\r\n", status);
-    am_util_stdio_printf("SIZE   : %ld\r\n", size);
-    am_util_stdio_printf("CRC    : %08lX\n\n", rx_crc);
+    DEFERRED_LOG("\r\n"
+                 "###### =========== FRAG_DECODER ============ ######\r\n"
+                 "######               FINISHED                ######\r\n"
+                 "###### ===================================== ######\r\n"
+                 "STATUS : %ld\r\n"
+                 "SIZE   : %ld\r\n"
+                 "CRC    : %08lX\n\n",
+                 status,
+                 size,
+                 rx_crc);
 }
 
 static int8_t frag_decoder_write(uint32_t offset, uint8_t *data, uint32_t size)
@@ -88,7 +97,7 @@ static int8_t frag_decoder_write(uint32_t offset, uint8_t *data, uint32_t size)
     uint32_t source[64];
     uint32_t length = size >> 2;
 
-    am_util_stdio_printf(
+    DEFERRED_LOG(
         "\r\nDecoder Write: 0x%x, 0x%x, %d\r\n", (uint32_t)destination, (uint32_t)source, length);
     memcpy(source, data, size);
 
@@ -115,14 +124,14 @@ static int8_t frag_decoder_erase(uint32_t offset, uint32_t size)
     uint32_t totalPage = (size >> 13) + 1;
     uint32_t address = OTA_FLASH_ADDRESS;
 
-    am_util_stdio_printf("\r\nErasing %d pages at 0x%x\r\n", totalPage, address);
+    DEFERRED_LOG("\r\nErasing %d pages at 0x%x\r\n", totalPage, address);
 
     for (int i = 0; i < totalPage; i++)
     {
         address += AM_HAL_FLASH_PAGE_SIZE;
-        am_util_stdio_printf("Instance: %d, Page: %d\r\n",
-                             AM_HAL_FLASH_ADDR2INST(address),
-                             AM_HAL_FLASH_ADDR2PAGE(address));
+        DEFERRED_LOG("Instance: %d, Page: %d\r\n",
+                     AM_HAL_FLASH_ADDR2INST(address),
+                     AM_HAL_FLASH_ADDR2PAGE(address));
 
         taskENTER_CRITICAL();
 
@@ -32,6 +32,7 @@
 #ifndef _LORAWAN_H_
 #define _LORAWAN_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <FreeRTOS.h>
 #include <queue.h>
@@ -46,6 +47,7 @@ typedef enum
     LORAWAN_SYNC_APP,
     LORAWAN_SYNC_MAC,
     LORAWAN_CLASS_SET,
+    LORAWAN_CLEAR,
 } lorawan_command_e;
 
 typedef struct
@@ -63,17 +65,75 @@ typedef struct
     int16_t  i16ReceiveSlot;
     uint32_t ui32Port;
     int32_t  ui32Length;
-    uint8_t *pui8Payload;
+    uint8_t *pui8Payload;   // owned by the consumer until lorawan_receive_release()
 } lorawan_rx_packet_t;
 
+// Called from the LoRaWAN task, once for each consumer registered on the
+// port and each with its own payload.  It may block or transmit, but holds up
+// the LoRaWAN task meanwhile.  The packet is only valid during the call, the
+// payload until it is released.
+typedef void (*lorawan_receive_callback_t)(lorawan_rx_packet_t *pPacket, void *pvContext);
+
+typedef struct
+{
+    uint32_t ui32Blocks;
+    uint32_t ui32BlockSize;
+    uint32_t ui32Free;
+    uint32_t ui32MinFree;
+    uint32_t ui32Dispatched;
+    uint32_t ui32NoBuffer;
+    uint32_t ui32QueueFull;
+    uint32_t ui32Unclaimed;     // no consumer registered on the port
+} lorawan_rx_stats_t;
+
+// Uplinks of a higher class are sent first, within a class the one with the
+// earliest deadline and then the oldest one.
+typedef enum
+{
+    LORAWAN_TX_PRIORITY_LOW,     // bulk telemetry
+    LORAWAN_TX_PRIORITY_NORMAL,
+    LORAWAN_TX_PRIORITY_HIGH,    // alarms
+} lorawan_tx_priority_e;
+
 typedef struct 
 {
     LmHandlerMsgTypes_t tType;
     uint32_t    ui32Port;
     uint32_t    ui32Length;
     uint8_t    *pui8Data;
+    lorawan_tx_priority_e ePriority;
+    uint32_t    ui32Sequence;
+    bool        bExpires;
+    uint32_t    ui32Deadline;   // in ticks, dropped if not sent by then
+    uint32_t    ui32Time;       // commit time in ticks, of the oldest message in a container
+    bool        bContainer;     // pui8Data already holds a lorawan_aggregate.h container
 } lorawan_tx_packet_t;
 
+typedef enum
+{
+    LORAWAN_TX_OK,
+    LORAWAN_TX_NO_BUFFER,   // every uplink buffer is reserved, queued or in flight
+    LORAWAN_TX_QUEUE_FULL,  // the buffer stays reserved, commit again or release it
+    LORAWAN_TX_INVALID,     // not a reserved buffer, or length too large
+} lorawan_tx_status_e;
+
+typedef struct
+{
+    uint32_t ui32Blocks;
+    uint32_t ui32BlockSize;
+    uint32_t ui32Free;
+    uint32_t ui32MinFree;
+    uint32_t ui32Reserved;
+    uint32_t ui32NoBuffer;
+    uint32_t ui32Committed;
+    uint32_t ui32Sent;
+    uint32_t ui32SendErrors;
+    uint32_t ui32Deferred;
+    uint32_t ui32Expired;
+    uint32_t ui32Aggregated;    // messages sent in the frame of another one
+    uint32_t ui32Rejected;      // too long for the container of their aggregation port
+} lorawan_tx_stats_t;
+
 typedef enum
 {
     LORAWAN_PM_SLEEP,
@@ -100,9 +160,46 @@ extern void lorawan_set_nwk_key_by_str(const char *pcNwkKey);
 extern void lorawan_set_nwk_key_by_bytes(const uint8_t *pui8NwkKey);
 extern void lorawan_get_nwk_key(uint8_t *pui8NwkKey);
 
-extern void lorawan_transmit(uint32_t ui32Port, uint32_t ui32Ack, uint32_t ui32Length, uint8_t *pui8Data);
+// Zero-copy uplinks: reserve a buffer of LORAWAN_TX_BLOCK_SIZE bytes, fill it
+// and commit it.  The buffer belongs to the LoRaWAN task from a successful
+// commit on and returns to the pool once the uplink is done.
+extern lorawan_tx_status_e lorawan_tx_reserve(uint8_t **ppui8Buffer);
+extern lorawan_tx_status_e lorawan_tx_commit(uint8_t *pui8Buffer, uint32_t ui32Port, uint32_t ui32Ack, uint32_t ui32Length);
+// As lorawan_tx_commit(), which commits at normal priority without deadline.
+// An uplink not sent within ui32Lifetime ms, or that the duty cycle keeps from
+// being sent in time, is dropped; a lifetime of 0 never expires.
+extern lorawan_tx_status_e lorawan_tx_commit_priority(uint8_t *pui8Buffer, uint32_t ui32Port, uint32_t ui32Ack,
+                                                      uint32_t ui32Length, lorawan_tx_priority_e ePriority,
+                                                      uint32_t ui32Lifetime);
+extern lorawan_tx_status_e lorawan_tx_release(uint8_t *pui8Buffer);
+extern void lorawan_tx_stats(lorawan_tx_stats_t *pStats);
+
+// Uplinks on an aggregation port are packed into the length prefixed
+// containers of lorawan_aggregate.h, as many as fit the maximum payload of the
+// current data rate.  A message is held back for up to ui32Budget ms while
+// the frame is not full, unless it is of high priority.  Messages on such a
+// port are at most LORAWAN_TX_BLOCK_SIZE - 1 bytes; longer ones committed
+// before the port was enabled are dropped and counted as rejected.
+extern lorawan_tx_status_e lorawan_tx_aggregation_enable(uint32_t ui32Port, uint32_t ui32Budget);
+extern lorawan_tx_status_e lorawan_tx_aggregation_disable(uint32_t ui32Port);
+
+// Copies pui8Data into a reserved buffer and commits it.
+extern lorawan_tx_status_e lorawan_transmit(uint32_t ui32Port, uint32_t ui32Ack, uint32_t ui32Length, uint8_t *pui8Data);
+extern lorawan_tx_status_e lorawan_transmit_priority(uint32_t ui32Port, uint32_t ui32Ack, uint32_t ui32Length,
+                                                     uint8_t *pui8Data, lorawan_tx_priority_e ePriority,
+                                                     uint32_t ui32Lifetime);
+
+// Downlinks are copied into a buffer of the downlink pool and handed to each
+// consumer of their port, through a queue or a direct callback.  A consumer
+// releases each packet it gets.  Ports are 0 to 223.
 extern QueueHandle_t lorawan_receive_register(uint32_t ui32Port, uint32_t elements);
 extern void lorawan_receive_unregister(QueueHandle_t handle);
+extern bool lorawan_receive_register_callback(uint32_t ui32Port, lorawan_receive_callback_t pfnCallback,
+                                              void *pvContext);
+extern void lorawan_receive_unregister_callback(uint32_t ui32Port, lorawan_receive_callback_t pfnCallback,
+                                                void *pvContext);
+extern void lorawan_receive_release(lorawan_rx_packet_t *pPacket);
+extern void lorawan_receive_stats(lorawan_rx_stats_t *pStats);
 
 extern void lorawan_power_management_register(lorawan_power_management_t callback);
 
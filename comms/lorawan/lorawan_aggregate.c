@@ -0,0 +1,81 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "lorawan_aggregate.h"
+
+uint32_t lorawan_aggregate_append(uint8_t *pui8Frame, uint32_t ui32Offset, uint32_t ui32Size,
+                                  const uint8_t *pui8Message, uint32_t ui32Length)
+{
+    if ((ui32Length > LORAWAN_AGGREGATE_MAX_MESSAGE) || (ui32Offset > ui32Size) ||
+        (ui32Length + LORAWAN_AGGREGATE_HEADER_SIZE > ui32Size - ui32Offset))
+    {
+        return 0;
+    }
+
+    // Move the message before writing its header, which may be where the
+    // message starts.
+    memmove(&pui8Frame[ui32Offset + LORAWAN_AGGREGATE_HEADER_SIZE], pui8Message, ui32Length);
+    pui8Frame[ui32Offset] = ui32Length;
+
+    return ui32Offset + LORAWAN_AGGREGATE_HEADER_SIZE + ui32Length;
+}
+
+void lorawan_aggregate_reader_init(lorawan_aggregate_reader_t *pReader, const uint8_t *pui8Frame,
+                                   uint32_t ui32Length)
+{
+    pReader->pui8Frame = pui8Frame;
+    pReader->ui32Length = ui32Length;
+    pReader->ui32Offset = 0;
+}
+
+int32_t lorawan_aggregate_next(lorawan_aggregate_reader_t *pReader, const uint8_t **ppui8Message)
+{
+    uint32_t ui32Length;
+
+    if (pReader->ui32Offset >= pReader->ui32Length)
+    {
+        return -1;
+    }
+
+    ui32Length = pReader->pui8Frame[pReader->ui32Offset];
+    if (ui32Length > pReader->ui32Length - pReader->ui32Offset - LORAWAN_AGGREGATE_HEADER_SIZE)
+    {
+        return -2;
+    }
+
+    *ppui8Message = &pReader->pui8Frame[pReader->ui32Offset + LORAWAN_AGGREGATE_HEADER_SIZE];
+    pReader->ui32Offset += LORAWAN_AGGREGATE_HEADER_SIZE + ui32Length;
+
+    return ui32Length;
+}
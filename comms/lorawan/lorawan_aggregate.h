@@ -0,0 +1,68 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _LORAWAN_AGGREGATE_H_
+#define _LORAWAN_AGGREGATE_H_
+
+#include <stdint.h>
+
+// Uplinks on an aggregation port carry a container of one or more messages,
+// each preceded by its length in one byte:
+//
+//   | length 0 | message 0 | length 1 | message 1 | ...
+//
+// The container depends on nothing but the C library, the same sources
+// decode it on the network side.
+
+#define LORAWAN_AGGREGATE_HEADER_SIZE   1
+#define LORAWAN_AGGREGATE_MAX_MESSAGE   255
+
+typedef struct
+{
+    const uint8_t *pui8Frame;
+    uint32_t ui32Length;
+    uint32_t ui32Offset;
+} lorawan_aggregate_reader_t;
+
+// Appends a message at ui32Offset of a frame of ui32Size bytes and returns
+// the offset past it, or 0 if it does not fit.  The message may overlap the
+// frame, as when a buffer becomes the first message of its own container.
+extern uint32_t lorawan_aggregate_append(uint8_t *pui8Frame, uint32_t ui32Offset, uint32_t ui32Size,
+                                         const uint8_t *pui8Message, uint32_t ui32Length);
+
+extern void lorawan_aggregate_reader_init(lorawan_aggregate_reader_t *pReader, const uint8_t *pui8Frame,
+                                          uint32_t ui32Length);
+
+// Returns the length of the next message and points ppui8Message at it, -1
+// at the end of the container or -2 if it is truncated.
+extern int32_t lorawan_aggregate_next(lorawan_aggregate_reader_t *pReader, const uint8_t **ppui8Message);
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "lorawan_config.h"
+
+#include "lorawan_rx_pool.h"
+
+#if (LORAWAN_RX_POOL_BLOCKS < 1) || (LORAWAN_RX_POOL_BLOCKS > 255)
+#error "LORAWAN_RX_POOL_BLOCKS must be between 1 and 255"
+#endif
+
+static uint8_t lorawan_rx_pool_blocks[LORAWAN_RX_POOL_BLOCKS][LORAWAN_RX_BLOCK_SIZE]
+    __attribute__((aligned(4)));
+static bool lorawan_rx_pool_owned[LORAWAN_RX_POOL_BLOCKS];
+
+// Stack of free block indices, the next block to hand out on top.
+static uint8_t lorawan_rx_pool_free_list[LORAWAN_RX_POOL_BLOCKS];
+static uint32_t lorawan_rx_pool_free_count;
+static uint32_t lorawan_rx_pool_min_free;
+
+static int32_t lorawan_rx_pool_index(const uint8_t *pui8Block)
+{
+    uintptr_t offset = (uintptr_t)pui8Block - (uintptr_t)lorawan_rx_pool_blocks;
+
+    if ((pui8Block < &lorawan_rx_pool_blocks[0][0]) ||
+        (offset >= sizeof(lorawan_rx_pool_blocks)) || (offset % LORAWAN_RX_BLOCK_SIZE))
+    {
+        return -1;
+    }
+
+    return offset / LORAWAN_RX_BLOCK_SIZE;
+}
+
+void lorawan_rx_pool_init(void)
+{
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < LORAWAN_RX_POOL_BLOCKS; i++)
+    {
+        lorawan_rx_pool_owned[i] = false;
+        lorawan_rx_pool_free_list[i] = LORAWAN_RX_POOL_BLOCKS - 1 - i;
+    }
+    lorawan_rx_pool_free_count = LORAWAN_RX_POOL_BLOCKS;
+    lorawan_rx_pool_min_free = LORAWAN_RX_POOL_BLOCKS;
+    taskEXIT_CRITICAL();
+}
+
+uint8_t *lorawan_rx_pool_alloc(void)
+{
+    uint8_t *pui8Block = NULL;
+    uint8_t ui8Index;
+
+    taskENTER_CRITICAL();
+    if (lorawan_rx_pool_free_count)
+    {
+        ui8Index = lorawan_rx_pool_free_list[--lorawan_rx_pool_free_count];
+        lorawan_rx_pool_owned[ui8Index] = true;
+        pui8Block = lorawan_rx_pool_blocks[ui8Index];
+
+        if (lorawan_rx_pool_free_count < lorawan_rx_pool_min_free)
+        {
+            lorawan_rx_pool_min_free = lorawan_rx_pool_free_count;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return pui8Block;
+}
+
+// Fails for a block that is not from the pool or already free.
+bool lorawan_rx_pool_free(uint8_t *pui8Block)
+{
+    bool bFreed = false;
+    int32_t i32Index = lorawan_rx_pool_index(pui8Block);
+
+    if (i32Index < 0)
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    if (lorawan_rx_pool_owned[i32Index])
+    {
+        lorawan_rx_pool_owned[i32Index] = false;
+        lorawan_rx_pool_free_list[lorawan_rx_pool_free_count++] = i32Index;
+        bFreed = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return bFreed;
+}
+
+void lorawan_rx_pool_stats(lorawan_rx_stats_t *pStats)
+{
+    taskENTER_CRITICAL();
+    pStats->ui32Blocks = LORAWAN_RX_POOL_BLOCKS;
+    pStats->ui32BlockSize = LORAWAN_RX_BLOCK_SIZE;
+    pStats->ui32Free = lorawan_rx_pool_free_count;
+    pStats->ui32MinFree = lorawan_rx_pool_min_free;
+    taskEXIT_CRITICAL();
+}
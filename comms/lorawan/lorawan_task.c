@@ -43,6 +43,7 @@
 
 #include <FreeRTOS.h>
 #include <queue.h>
+#include <semphr.h>
 #include <timers.h>
 
 #include <LmHandler.h>
@@ -50,7 +51,10 @@
 #include <LmhpCompliance.h>
 #include <LmhpFragmentation.h>
 #include <LmhpRemoteMcastSetup.h>
+#include <NvmDataMgmt.h>
 #include <board.h>
+#include <eeprom_emulation.h>
+#include <lorawan_eeprom_config.h>
 #include <radio.h>
 
 #include "lorawan.h"
@@ -58,22 +62,75 @@
 
 #include "lmh_callbacks.h"
 #include "lmhp_fragmentation.h"
+#include "lorawan_aggregate.h"
 #include "lorawan_task.h"
 #include "lorawan_task_cli.h"
+#include "lorawan_tx_pool.h"
+#include "lorawan_tx_scheduler.h"
 
 #define LORAWAN_SPI_PORT_TIMEOUT    8000
 
+// The SPI port may be powered down late, sharing the wake-up of another timer
+#define LORAWAN_SPI_PORT_SLACK      2000
+
 extern void *SX126xHandle;
 
 static uint32_t lorawan_stack_started;
 static uint32_t lorawan_spi_port_powered;
 
 static lorawan_power_management_t lorawan_pm_callback;
+
+// Serializes access to the emulated EEPROM between the LoRaWAN and console tasks
+static SemaphoreHandle_t lorawan_eeprom_mutex;
 static TaskHandle_t lorawan_task_handle;
 static QueueHandle_t lorawan_task_command_queue;
-static QueueHandle_t lorawan_task_transmit_queue;
 static TimerHandle_t lorawan_spi_port_timer;
 
+// Uplink handed to LmHandlerSend(), kept until its confirmation is processed
+// as the MCPS-Confirm display still reads the payload.
+static uint8_t *lorawan_tx_inflight;
+static uint32_t lorawan_tx_committed;
+static uint32_t lorawan_tx_sent;
+static uint32_t lorawan_tx_send_errors;
+static uint32_t lorawan_tx_sequence;
+static uint32_t lorawan_tx_deferred;
+static uint32_t lorawan_tx_expired;
+static uint32_t lorawan_tx_aggregated;
+static uint32_t lorawan_tx_rejected;
+
+// Set when the duty cycle restricted a MAC request, no uplink is attempted
+// before lorawan_tx_ready_at.
+static bool lorawan_tx_holdoff;
+static TickType_t lorawan_tx_ready_at;
+
+#if LORAWAN_TX_AGGREGATION_PORTS > 0
+// Ports whose uplinks are packed into containers, 0 for an unused entry, and
+// the time in ticks their messages may wait for others.
+static uint32_t lorawan_tx_aggregation_port[LORAWAN_TX_AGGREGATION_PORTS];
+static TickType_t lorawan_tx_aggregation_budget[LORAWAN_TX_AGGREGATION_PORTS];
+
+// Set while messages are held back, with the time the first of them is due.
+static bool lorawan_tx_aggregation_hold;
+static TickType_t lorawan_tx_aggregation_release_at;
+
+typedef struct
+{
+    uint32_t ui32Port;
+    uint32_t ui32Bytes;
+    uint32_t ui32Oldest;
+    uint32_t ui32Deadline;
+    bool bFound;
+    bool bExpires;
+    bool bUrgent;
+} lorawan_tx_group_t;
+
+typedef struct
+{
+    uint32_t ui32Port;
+    uint32_t ui32Space;
+} lorawan_tx_fit_t;
+#endif
+
 #define LM_BUFFER_SIZE 242
 static uint8_t psLmDataBuffer[LM_BUFFER_SIZE];
 
@@ -121,35 +178,403 @@ static void lorawan_task_handle_power_management(lorawan_pm_state_e state)
     }
 }
 
-static void lorawan_task_handle_uplink()
+// pdMS_TO_TICKS() overflows beyond 71 minutes, duty cycle waits can be longer.
+static TickType_t lorawan_task_ms_to_ticks(uint32_t ui32Milliseconds)
 {
-    if (LmhpRemoteMcastSessionStateStarted())
+    return (TickType_t)(((uint64_t)ui32Milliseconds * configTICK_RATE_HZ) / 1000);
+}
+
+static void lorawan_task_release_inflight()
+{
+    if (lorawan_tx_inflight)
     {
-        return;
+        lorawan_tx_pool_move(lorawan_tx_inflight, LORAWAN_TX_BLOCK_QUEUED, LORAWAN_TX_BLOCK_FREE);
+        lorawan_tx_inflight = NULL;
+    }
+}
+
+static void lorawan_task_release_queued()
+{
+    lorawan_tx_packet_t packet;
+
+    while (lorawan_tx_scheduler_get(&packet))
+    {
+        lorawan_tx_pool_move(packet.pui8Data, LORAWAN_TX_BLOCK_QUEUED, LORAWAN_TX_BLOCK_FREE);
     }
+    lorawan_task_release_inflight();
+    lorawan_tx_holdoff = false;
+#if LORAWAN_TX_AGGREGATION_PORTS > 0
+    lorawan_tx_aggregation_hold = false;
+#endif
+}
 
+// Drops the uplinks that are not sent by their deadline if the earliest
+// transmission is at ui32Time.
+static void lorawan_task_expire_uplinks(uint32_t ui32Time)
+{
     lorawan_tx_packet_t packet;
-    if (xQueuePeek(lorawan_task_transmit_queue, &packet, 0) == pdPASS)
+
+    while (lorawan_tx_scheduler_get_expired(ui32Time, &packet))
+    {
+        lorawan_tx_pool_move(packet.pui8Data, LORAWAN_TX_BLOCK_QUEUED, LORAWAN_TX_BLOCK_FREE);
+        lorawan_tx_expired++;
+    }
+}
+
+#if LORAWAN_TX_AGGREGATION_PORTS > 0
+static int32_t lorawan_task_aggregation_index(uint32_t ui32Port)
+{
+    for (uint32_t i = 0; i < LORAWAN_TX_AGGREGATION_PORTS; i++)
     {
-        if (LmHandlerIsBusy() == true)
+        if (ui32Port && (lorawan_tx_aggregation_port[i] == ui32Port))
         {
-            return;
+            return i;
         }
+    }
 
-        xQueueReceive(lorawan_task_transmit_queue, &packet, 0);
+    return -1;
+}
 
-        LmHandlerAppData_t app_data;
+// Space a message takes in a container, a container is appended as is.
+static uint32_t lorawan_task_aggregate_size(const lorawan_tx_packet_t *pPacket)
+{
+    return pPacket->ui32Length + (pPacket->bContainer ? 0 : LORAWAN_AGGREGATE_HEADER_SIZE);
+}
+
+static void lorawan_task_group_visit(const lorawan_tx_packet_t *pPacket, void *pvContext)
+{
+    lorawan_tx_group_t *pGroup = pvContext;
+
+    if (pPacket->ui32Port != pGroup->ui32Port)
+    {
+        return;
+    }
+
+    pGroup->ui32Bytes += lorawan_task_aggregate_size(pPacket);
+    if (!pGroup->bFound || ((int32_t)(pPacket->ui32Time - pGroup->ui32Oldest) < 0))
+    {
+        pGroup->ui32Oldest = pPacket->ui32Time;
+    }
+    if (pPacket->bExpires && (!pGroup->bExpires || ((int32_t)(pPacket->ui32Deadline - pGroup->ui32Deadline) < 0)))
+    {
+        pGroup->ui32Deadline = pPacket->ui32Deadline;
+        pGroup->bExpires = true;
+    }
+    if (pPacket->ePriority == LORAWAN_TX_PRIORITY_HIGH)
+    {
+        pGroup->bUrgent = true;
+    }
+    pGroup->bFound = true;
+}
+
+// Fills pui32Held with the aggregation ports whose messages wait for more:
+// the frame is not full, none is urgent and the budget of the oldest one, or
+// an earlier deadline, is still ahead.
+static void lorawan_task_aggregation_hold(TickType_t now, uint32_t ui32MaxPayload, uint32_t *pui32Held)
+{
+    lorawan_tx_group_t group;
+    TickType_t release;
+
+    lorawan_tx_aggregation_hold = false;
+
+    for (uint32_t i = 0; i < LORAWAN_TX_AGGREGATION_PORTS; i++)
+    {
+        pui32Held[i] = 0;
+        if (lorawan_tx_aggregation_port[i] == 0)
+        {
+            continue;
+        }
+
+        memset(&group, 0, sizeof(group));
+        group.ui32Port = lorawan_tx_aggregation_port[i];
+        lorawan_tx_scheduler_for_each(lorawan_task_group_visit, &group);
+        if (!group.bFound || group.bUrgent || (group.ui32Bytes >= ui32MaxPayload))
+        {
+            continue;
+        }
+
+        release = group.ui32Oldest + lorawan_tx_aggregation_budget[i];
+        if (group.bExpires && ((int32_t)(group.ui32Deadline - release) < 0))
+        {
+            release = group.ui32Deadline;
+        }
+        if ((int32_t)(release - now) <= 0)
+        {
+            continue;
+        }
+
+        pui32Held[i] = group.ui32Port;
+        if (!lorawan_tx_aggregation_hold || ((int32_t)(release - lorawan_tx_aggregation_release_at) < 0))
+        {
+            lorawan_tx_aggregation_release_at = release;
+        }
+        lorawan_tx_aggregation_hold = true;
+    }
+}
+
+static bool lorawan_task_uplink_not_held(const lorawan_tx_packet_t *pPacket, void *pvContext)
+{
+    const uint32_t *pui32Held = pvContext;
 
-        if (packet.ui32Length > 0)
+    for (uint32_t i = 0; i < LORAWAN_TX_AGGREGATION_PORTS; i++)
+    {
+        if (pui32Held[i] && (pui32Held[i] == pPacket->ui32Port))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool lorawan_task_uplink_fits(const lorawan_tx_packet_t *pPacket, void *pvContext)
+{
+    const lorawan_tx_fit_t *pFit = pvContext;
+
+    return (pPacket->ui32Port == pFit->ui32Port) && (lorawan_task_aggregate_size(pPacket) <= pFit->ui32Space);
+}
+
+// Turns pPacket into a container, if on an aggregation port, and moves in
+// the queued messages for the same port that fit, best first.  Returns false
+// if pPacket cannot be sent on its port.
+static bool lorawan_task_aggregate(lorawan_tx_packet_t *pPacket, uint32_t ui32MaxPayload)
+{
+    lorawan_tx_packet_t next;
+    lorawan_tx_fit_t fit;
+
+    if (lorawan_task_aggregation_index(pPacket->ui32Port) < 0)
+    {
+        return true;
+    }
+
+    if (!pPacket->bContainer)
+    {
+        // Fails only for a message committed before its port was enabled
+        // that leaves no room for the length prefix.  Sent as is, the
+        // receiver would take its first byte for one.
+        fit.ui32Space = lorawan_aggregate_append(pPacket->pui8Data, 0, LORAWAN_TX_BLOCK_SIZE,
+                                                 pPacket->pui8Data, pPacket->ui32Length);
+        if (fit.ui32Space == 0)
+        {
+            return false;
+        }
+        pPacket->ui32Length = fit.ui32Space;
+        pPacket->bContainer = true;
+    }
+
+    fit.ui32Port = pPacket->ui32Port;
+    fit.ui32Space = (ui32MaxPayload > pPacket->ui32Length) ? ui32MaxPayload - pPacket->ui32Length : 0;
+    while (fit.ui32Space && lorawan_tx_scheduler_get_matching(lorawan_task_uplink_fits, &fit, &next))
+    {
+        if (next.bContainer)
+        {
+            memcpy(&pPacket->pui8Data[pPacket->ui32Length], next.pui8Data, next.ui32Length);
+            pPacket->ui32Length += next.ui32Length;
+        }
+        else
+        {
+            pPacket->ui32Length = lorawan_aggregate_append(pPacket->pui8Data, pPacket->ui32Length,
+                                                           LORAWAN_TX_BLOCK_SIZE, next.pui8Data, next.ui32Length);
+        }
+        lorawan_tx_pool_move(next.pui8Data, LORAWAN_TX_BLOCK_QUEUED, LORAWAN_TX_BLOCK_FREE);
+        lorawan_tx_aggregated++;
+
+        // The frame goes as early, and is kept as long, as its most pressing
+        // message asks for.
+        if (next.tType == LORAMAC_HANDLER_CONFIRMED_MSG)
+        {
+            pPacket->tType = LORAMAC_HANDLER_CONFIRMED_MSG;
+        }
+        if (next.ePriority > pPacket->ePriority)
+        {
+            pPacket->ePriority = next.ePriority;
+        }
+        if (pPacket->bExpires && (!next.bExpires || ((int32_t)(next.ui32Deadline - pPacket->ui32Deadline) > 0)))
+        {
+            pPacket->bExpires = next.bExpires;
+            pPacket->ui32Deadline = next.ui32Deadline;
+        }
+        if ((int32_t)(next.ui32Sequence - pPacket->ui32Sequence) < 0)
+        {
+            pPacket->ui32Sequence = next.ui32Sequence;
+        }
+        if ((int32_t)(next.ui32Time - pPacket->ui32Time) < 0)
         {
-            memcpy(psLmDataBuffer, packet.pui8Data, packet.ui32Length);
+            pPacket->ui32Time = next.ui32Time;
         }
+
+        fit.ui32Space = ui32MaxPayload - pPacket->ui32Length;
+    }
+
+    return true;
+}
+
+static uint32_t lorawan_task_max_payload()
+{
+    LoRaMacTxInfo_t txInfo;
+
+    // Room left at the current data rate next to the pending MAC commands.
+    LoRaMacQueryTxPossible(0, &txInfo);
+
+    return (txInfo.MaxPossibleApplicationDataSize < LORAWAN_TX_BLOCK_SIZE) ? txInfo.MaxPossibleApplicationDataSize
+                                                                          : LORAWAN_TX_BLOCK_SIZE;
+}
+#endif
+
+static bool lorawan_task_next_uplink(TickType_t now, lorawan_tx_packet_t *pPacket)
+{
+#if LORAWAN_TX_AGGREGATION_PORTS > 0
+    uint32_t pui32Held[LORAWAN_TX_AGGREGATION_PORTS];
+    uint32_t ui32MaxPayload = lorawan_task_max_payload();
+
+    lorawan_task_aggregation_hold(now, ui32MaxPayload, pui32Held);
+    while (lorawan_tx_scheduler_get_matching(lorawan_task_uplink_not_held, pui32Held, pPacket))
+    {
+        if (lorawan_task_aggregate(pPacket, ui32MaxPayload))
+        {
+            return true;
+        }
+        lorawan_tx_pool_move(pPacket->pui8Data, LORAWAN_TX_BLOCK_QUEUED, LORAWAN_TX_BLOCK_FREE);
+        lorawan_tx_rejected++;
+    }
+
+    return false;
+#else
+    return lorawan_tx_scheduler_get(pPacket);
+#endif
+}
+
+static void lorawan_task_handle_uplink()
+{
+    TickType_t now = xTaskGetTickCount();
+
+    if (lorawan_tx_holdoff && ((int32_t)(lorawan_tx_ready_at - now) > 0))
+    {
+        lorawan_task_expire_uplinks(lorawan_tx_ready_at);
+        return;
+    }
+    lorawan_tx_holdoff = false;
+    lorawan_task_expire_uplinks(now);
+
+    if (LmhpRemoteMcastSessionStateStarted())
+    {
+        return;
+    }
+
+    if (LmHandlerIsBusy() == true)
+    {
+        return;
+    }
+
+    lorawan_task_release_inflight();
+
+    // The pick is made only now that the MAC is free, so that an uplink
+    // committed while it was busy or held off can still go first.
+    lorawan_tx_packet_t packet;
+    if (lorawan_task_next_uplink(now, &packet))
+    {
+        LmHandlerAppData_t app_data;
+
+        // The pool buffer goes to the MAC as is, it copies the payload into
+        // its frame buffer while the request is processed.
         app_data.Port = packet.ui32Port;
         app_data.BufferSize = packet.ui32Length;
-        app_data.Buffer = psLmDataBuffer;
+        app_data.Buffer = packet.pui8Data;
+
+        if (LmHandlerSend(&app_data, packet.tType) == LORAMAC_HANDLER_SUCCESS)
+        {
+            lorawan_tx_inflight = packet.pui8Data;
+            lorawan_tx_sent++;
+        }
+        else if (lorawan_tx_holdoff)
+        {
+            // Restricted by the duty cycle, lorawan_task_uplink_holdoff() was
+            // called with the wait time.  The uplink competes again once the
+            // wait is over.
+            lorawan_tx_scheduler_put(&packet);
+            lorawan_tx_deferred++;
+            lorawan_task_expire_uplinks(lorawan_tx_ready_at);
+        }
+        else
+        {
+            lorawan_tx_pool_move(packet.pui8Data, LORAWAN_TX_BLOCK_QUEUED, LORAWAN_TX_BLOCK_FREE);
+            lorawan_tx_send_errors++;
+        }
+    }
+}
+
+// Time until the next hold-off end or deadline, when the queued uplinks need
+// a look even if nothing else wakes the task.
+static TickType_t lorawan_task_uplink_timeout()
+{
+    TickType_t now = xTaskGetTickCount();
+    TickType_t timeout = portMAX_DELAY;
+    uint32_t ui32Deadline;
+
+    if (!lorawan_stack_started || (lorawan_tx_scheduler_count() == 0))
+    {
+        return portMAX_DELAY;
+    }
+
+    if (lorawan_tx_holdoff && ((int32_t)(lorawan_tx_ready_at - now) > 0))
+    {
+        timeout = lorawan_tx_ready_at - now;
+    }
+
+    if (lorawan_tx_scheduler_next_deadline(&ui32Deadline) && ((int32_t)(ui32Deadline - now) >= 0) &&
+        (ui32Deadline - now + 1 < timeout))
+    {
+        timeout = ui32Deadline - now + 1;
+    }
+
+#if LORAWAN_TX_AGGREGATION_PORTS > 0
+    if (lorawan_tx_aggregation_hold && ((int32_t)(lorawan_tx_aggregation_release_at - now) > 0) &&
+        (lorawan_tx_aggregation_release_at - now < timeout))
+    {
+        timeout = lorawan_tx_aggregation_release_at - now;
+    }
+#endif
+
+    return timeout;
+}
+
+static void lorawan_task_handle_eeprom()
+{
+    uint32_t ui32Pending;
 
-        LmHandlerSend(&app_data, packet.tType);
+    // Page transfers of the emulated EEPROM are done a slice at a time while
+    // the MAC and radio are idle, so that writes issued from within MAC
+    // processing never have to copy and erase a whole page.
+    if (!eeprom_compact_pending(&lorawan_eeprom_handle))
+    {
+        return;
     }
+
+    if (LoRaMacIsBusy() || (Radio.GetStatus() != RF_IDLE))
+    {
+        return;
+    }
+
+    // The console task may format the EEPROM at any time.
+    eeprom_lock(&lorawan_eeprom_handle);
+    ui32Pending = eeprom_compact_step(&lorawan_eeprom_handle, LORAWAN_EEPROM_COMPACTION_BUDGET);
+    eeprom_unlock(&lorawan_eeprom_handle);
+
+    if (ui32Pending)
+    {
+        lorawan_task_wake();
+    }
+}
+
+// The NVM context manager keeps a copy of what it stored, it is dropped along
+// with the EEPROM content so that the next store writes whole groups again.
+static void lorawan_task_clear()
+{
+    eeprom_lock(&lorawan_eeprom_handle);
+    eeprom_format(&lorawan_eeprom_handle);
+    eeprom_unlock(&lorawan_eeprom_handle);
+
+    NvmDataMgmtFactoryReset();
 }
 
 static void lorawan_task_handle_command()
@@ -168,6 +593,23 @@ static void lorawan_task_handle_command()
             return;
         }
 
+        if (command.eCommand == LORAWAN_CLEAR)
+        {
+            lorawan_task_clear();
+            return;
+        }
+
+        if (command.eCommand == LORAWAN_RESET)
+        {
+            // BoardResetMcu() stores the context changes still held back by
+            // the coalescing window.
+            if (lorawan_stack_started)
+            {
+                BoardResetMcu();
+            }
+            NVIC_SystemReset();
+        }
+
         if (lorawan_stack_started)
         {
             switch (command.eCommand)
@@ -246,11 +688,14 @@ static void lorawan_stack_start()
 
 void lorawan_stack_stop()
 {
+    // Store the context changes still held back by the coalescing window.
+    NvmDataMgmtFlush();
+
     LoRaMacStop();
     LoRaMacDeInitialization();
     BoardDeInitMcu();
     lorawan_task_handle_power_management(LORAWAN_PM_SLEEP);
-    xQueueReset(lorawan_task_transmit_queue);
+    lorawan_task_release_queued();
 
     lorawan_stack_started = false;
     lorawan_spi_port_powered = false;
@@ -266,6 +711,16 @@ void lorawan_wake_on_timer_irq()
     lorawan_task_wake();
 }
 
+static void lorawan_eeprom_lock(void)
+{
+    xSemaphoreTake(lorawan_eeprom_mutex, portMAX_DELAY);
+}
+
+static void lorawan_eeprom_unlock(void)
+{
+    xSemaphoreGive(lorawan_eeprom_mutex);
+}
+
 static void lorawan_task(void *pvParameters)
 {
     lorawan_stack_started = false;
@@ -279,11 +734,12 @@ static void lorawan_task(void *pvParameters)
         {
             LmHandlerProcess();
             lorawan_task_handle_uplink();
+            lorawan_task_handle_eeprom();
         }
 
         lorawan_task_handle_power_management(LORAWAN_PM_SLEEP);
 
-        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+        ulTaskNotifyTake(pdFALSE, lorawan_task_uplink_timeout());
 
         lorawan_task_handle_power_management(LORAWAN_PM_WAKE);
     }
@@ -294,7 +750,11 @@ void lorawan_task_create(uint32_t ui32Priority)
     xTaskCreate(lorawan_task, "lorawan", 512, 0, ui32Priority, &lorawan_task_handle);
 
     lorawan_task_command_queue = xQueueCreate(8, sizeof(lorawan_command_t));
-    lorawan_task_transmit_queue = xQueueCreate(8, sizeof(lorawan_tx_packet_t));
+    lorawan_eeprom_mutex = xSemaphoreCreateMutex();
+    lorawan_eeprom_handle.lock = lorawan_eeprom_lock;
+    lorawan_eeprom_handle.unlock = lorawan_eeprom_unlock;
+    lorawan_tx_pool_init();
+    lorawan_tx_scheduler_init();
 
     lorawan_spi_port_timer = xTimerCreate(
         "LoRaWAN Port Timer",
@@ -303,6 +763,7 @@ void lorawan_task_create(uint32_t ui32Priority)
         NULL,
         lorawan_port_callback
     );
+    vTimerSetSlack(lorawan_spi_port_timer, pdMS_TO_TICKS(LORAWAN_SPI_PORT_SLACK));
 
     memset(&lmh_callbacks, 0, sizeof(LmHandlerCallbacks_t));
     lmh_callbacks_setup(&lmh_callbacks);
@@ -337,30 +798,191 @@ void lorawan_send_command(lorawan_command_t *pCommand)
     //taskEXIT_CRITICAL();
 }
 
-void lorawan_transmit(uint32_t ui32Port, uint32_t ui32Ack, uint32_t ui32Length, uint8_t *pui8Data)
+void lorawan_task_uplink_holdoff(uint32_t ui32Delay)
+{
+    lorawan_tx_ready_at = xTaskGetTickCount() + lorawan_task_ms_to_ticks(ui32Delay);
+    lorawan_tx_holdoff = true;
+}
+
+lorawan_tx_status_e lorawan_tx_reserve(uint8_t **ppui8Buffer)
+{
+    *ppui8Buffer = lorawan_tx_pool_alloc();
+
+    return *ppui8Buffer ? LORAWAN_TX_OK : LORAWAN_TX_NO_BUFFER;
+}
+
+lorawan_tx_status_e lorawan_tx_commit(uint8_t *pui8Buffer, uint32_t ui32Port, uint32_t ui32Ack, uint32_t ui32Length)
+{
+    return lorawan_tx_commit_priority(pui8Buffer, ui32Port, ui32Ack, ui32Length, LORAWAN_TX_PRIORITY_NORMAL, 0);
+}
+
+lorawan_tx_status_e lorawan_tx_commit_priority(uint8_t *pui8Buffer, uint32_t ui32Port, uint32_t ui32Ack,
+                                               uint32_t ui32Length, lorawan_tx_priority_e ePriority,
+                                               uint32_t ui32Lifetime)
 {
     lorawan_tx_packet_t packet;
+    lorawan_tx_status_e eStatus;
+
+    if ((ui32Length > LORAWAN_TX_BLOCK_SIZE) || (ePriority > LORAWAN_TX_PRIORITY_HIGH))
+    {
+        return LORAWAN_TX_INVALID;
+    }
+
+#if LORAWAN_TX_AGGREGATION_PORTS > 0
+    // The message must fit a container of one.
+    if ((lorawan_task_aggregation_index(ui32Port) >= 0) &&
+        ((ui32Length + LORAWAN_AGGREGATE_HEADER_SIZE > LORAWAN_TX_BLOCK_SIZE) ||
+         (ui32Length > LORAWAN_AGGREGATE_MAX_MESSAGE)))
+    {
+        return LORAWAN_TX_INVALID;
+    }
+#endif
 
     packet.tType = ui32Ack ? LORAMAC_HANDLER_CONFIRMED_MSG : LORAMAC_HANDLER_UNCONFIRMED_MSG;
     packet.ui32Port = ui32Port;
     packet.ui32Length = ui32Length;
-
-    if (ui32Length > 0)
+    packet.pui8Data = pui8Buffer;
+    packet.ePriority = ePriority;
+    packet.bExpires = (ui32Lifetime != 0);
+    packet.ui32Time = xTaskGetTickCount();
+    packet.ui32Deadline = packet.ui32Time + lorawan_task_ms_to_ticks(ui32Lifetime);
+    packet.bContainer = false;
+
+    // Hand the buffer over before queueing it, the task may run at once.
+    eStatus = lorawan_tx_pool_move(pui8Buffer, LORAWAN_TX_BLOCK_RESERVED, LORAWAN_TX_BLOCK_QUEUED);
+    if (eStatus != LORAWAN_TX_OK)
     {
-        packet.pui8Data = pui8Data;
+        return eStatus;
     }
-    else
+
+    taskENTER_CRITICAL();
+    packet.ui32Sequence = lorawan_tx_sequence++;
+    taskEXIT_CRITICAL();
+
+    if (!lorawan_tx_scheduler_put(&packet))
     {
-        packet.pui8Data = NULL;
+        lorawan_tx_pool_move(pui8Buffer, LORAWAN_TX_BLOCK_QUEUED, LORAWAN_TX_BLOCK_RESERVED);
+        return LORAWAN_TX_QUEUE_FULL;
     }
 
-    // prevent context switch until task notification is completed
-    //taskENTER_CRITICAL();
+    taskENTER_CRITICAL();
+    lorawan_tx_committed++;
+    taskEXIT_CRITICAL();
 
-    xQueueSend(lorawan_task_transmit_queue, &packet, 0);
     lorawan_task_wake();
 
-    //taskEXIT_CRITICAL();
+    return LORAWAN_TX_OK;
+}
+
+lorawan_tx_status_e lorawan_tx_release(uint8_t *pui8Buffer)
+{
+    return lorawan_tx_pool_move(pui8Buffer, LORAWAN_TX_BLOCK_RESERVED, LORAWAN_TX_BLOCK_FREE);
+}
+
+void lorawan_tx_stats(lorawan_tx_stats_t *pStats)
+{
+    lorawan_tx_pool_stats(pStats);
+
+    taskENTER_CRITICAL();
+    pStats->ui32Committed = lorawan_tx_committed;
+    pStats->ui32Sent = lorawan_tx_sent;
+    pStats->ui32SendErrors = lorawan_tx_send_errors;
+    pStats->ui32Deferred = lorawan_tx_deferred;
+    pStats->ui32Expired = lorawan_tx_expired;
+    pStats->ui32Aggregated = lorawan_tx_aggregated;
+    pStats->ui32Rejected = lorawan_tx_rejected;
+    taskEXIT_CRITICAL();
+}
+
+lorawan_tx_status_e lorawan_tx_aggregation_enable(uint32_t ui32Port, uint32_t ui32Budget)
+{
+#if LORAWAN_TX_AGGREGATION_PORTS > 0
+    lorawan_tx_status_e eStatus = LORAWAN_TX_INVALID;
+    int32_t i32Index;
+
+    if ((ui32Port == 0) || (ui32Port > 223))
+    {
+        return LORAWAN_TX_INVALID;
+    }
+
+    taskENTER_CRITICAL();
+    i32Index = lorawan_task_aggregation_index(ui32Port);
+    for (uint32_t i = 0; (i32Index < 0) && (i < LORAWAN_TX_AGGREGATION_PORTS); i++)
+    {
+        if (lorawan_tx_aggregation_port[i] == 0)
+        {
+            i32Index = i;
+        }
+    }
+
+    if (i32Index >= 0)
+    {
+        lorawan_tx_aggregation_budget[i32Index] = lorawan_task_ms_to_ticks(ui32Budget);
+        lorawan_tx_aggregation_port[i32Index] = ui32Port;
+        eStatus = LORAWAN_TX_OK;
+    }
+    taskEXIT_CRITICAL();
+
+    return eStatus;
+#else
+    return LORAWAN_TX_INVALID;
+#endif
+}
+
+lorawan_tx_status_e lorawan_tx_aggregation_disable(uint32_t ui32Port)
+{
+#if LORAWAN_TX_AGGREGATION_PORTS > 0
+    int32_t i32Index;
+
+    taskENTER_CRITICAL();
+    i32Index = lorawan_task_aggregation_index(ui32Port);
+    if (i32Index >= 0)
+    {
+        lorawan_tx_aggregation_port[i32Index] = 0;
+    }
+    taskEXIT_CRITICAL();
+
+    return (i32Index >= 0) ? LORAWAN_TX_OK : LORAWAN_TX_INVALID;
+#else
+    return LORAWAN_TX_INVALID;
+#endif
+}
+
+lorawan_tx_status_e lorawan_transmit(uint32_t ui32Port, uint32_t ui32Ack, uint32_t ui32Length, uint8_t *pui8Data)
+{
+    return lorawan_transmit_priority(ui32Port, ui32Ack, ui32Length, pui8Data, LORAWAN_TX_PRIORITY_NORMAL, 0);
+}
+
+lorawan_tx_status_e lorawan_transmit_priority(uint32_t ui32Port, uint32_t ui32Ack, uint32_t ui32Length,
+                                              uint8_t *pui8Data, lorawan_tx_priority_e ePriority,
+                                              uint32_t ui32Lifetime)
+{
+    uint8_t *pui8Buffer;
+    lorawan_tx_status_e eStatus;
+
+    if (ui32Length > LORAWAN_TX_BLOCK_SIZE)
+    {
+        return LORAWAN_TX_INVALID;
+    }
+
+    eStatus = lorawan_tx_reserve(&pui8Buffer);
+    if (eStatus != LORAWAN_TX_OK)
+    {
+        return eStatus;
+    }
+
+    if (ui32Length > 0)
+    {
+        memcpy(pui8Buffer, pui8Data, ui32Length);
+    }
+
+    eStatus = lorawan_tx_commit_priority(pui8Buffer, ui32Port, ui32Ack, ui32Length, ePriority, ui32Lifetime);
+    if (eStatus != LORAWAN_TX_OK)
+    {
+        lorawan_tx_release(pui8Buffer);
+    }
+
+    return eStatus;
 }
 
 void lorawan_power_management_register(lorawan_power_management_t pHandler)
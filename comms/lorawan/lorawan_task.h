@@ -36,5 +36,8 @@
 
 extern void lorawan_task_create(uint32_t ui32Priority);
 extern void lorawan_task_wake();
+// Called when the duty cycle restricts a MAC request, with the time in ms
+// before the next transmission is possible.
+extern void lorawan_task_uplink_holdoff(uint32_t ui32Delay);
 
 #endif
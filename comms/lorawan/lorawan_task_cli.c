@@ -71,6 +71,9 @@ static char *argv[8];
 static char argz[128];
 
 #define LM_BUFFER_SIZE 242
+
+// The periodic uplinks may be sent late, sharing the wake-up of another timer
+#define LORAWAN_PERIODIC_SLACK 1000
 static uint8_t lorawan_cli_transmit_buffer[LM_BUFFER_SIZE];
 
 static TimerHandle_t periodic_transmit_timer = NULL;
@@ -150,6 +153,7 @@ static void lorawan_task_cli_help(char *pui8OutBuffer, size_t argc, char **argv)
     strcat(pui8OutBuffer, "  keys\r\n");
     strcat(pui8OutBuffer, "  periodic\r\n");
     strcat(pui8OutBuffer, "  send\r\n");
+    strcat(pui8OutBuffer, "  stats    uplink and downlink buffer statistics\r\n");
 }
 
 static void lorawan_task_cli_class(char *pui8OutBuffer, size_t argc, char **argv)
@@ -335,11 +339,12 @@ static void lorawan_task_cli_periodic(char *pui8OutBuffer, size_t argc, char **a
                                                    pdTRUE,
                                                    (void *)0,
                                                    periodic_transmit_callback);
+            vTimerSetSlack(periodic_transmit_timer, pdMS_TO_TICKS(LORAWAN_PERIODIC_SLACK));
             xTimerStart(periodic_transmit_timer, portMAX_DELAY);
         }
         else
         {
-            xTimerChangePeriod(periodic_transmit_timer, pdMS_TO_TICKS(ui32Period), portMAX_DELAY);
+            xTimerChangePeriod(periodic_transmit_timer, pdMS_TO_TICKS(ui32Period * 1000), portMAX_DELAY);
         }
     }
 }
@@ -364,7 +369,67 @@ static void lorawan_task_cli_send(char *pui8OutBuffer, size_t argc, char **argv)
         port = atoi(argv[2]);
     }
 
-    lorawan_transmit(port, ack, length, lorawan_cli_transmit_buffer);
+    switch (lorawan_transmit(port, ack, length, lorawan_cli_transmit_buffer))
+    {
+    case LORAWAN_TX_NO_BUFFER:
+        strcat(pui8OutBuffer, "\r\nno uplink buffer available\r\n");
+        break;
+    case LORAWAN_TX_QUEUE_FULL:
+        strcat(pui8OutBuffer, "\r\nuplink queue full\r\n");
+        break;
+    case LORAWAN_TX_INVALID:
+        strcat(pui8OutBuffer, "\r\ninvalid uplink\r\n");
+        break;
+    default:
+        break;
+    }
+}
+
+static void lorawan_task_cli_stats(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    lorawan_tx_stats_t stats;
+    lorawan_rx_stats_t rx_stats;
+    char line[64];
+
+    lorawan_tx_stats(&stats);
+
+    am_util_stdio_sprintf(line, "\r\nbuffers   : %d x %d bytes\r\n", stats.ui32Blocks, stats.ui32BlockSize);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "free      : %d (min %d)\r\n", stats.ui32Free, stats.ui32MinFree);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "reserved  : %d\r\n", stats.ui32Reserved);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "no buffer : %d\r\n", stats.ui32NoBuffer);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "committed : %d\r\n", stats.ui32Committed);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "sent      : %d\r\n", stats.ui32Sent);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "errors    : %d\r\n", stats.ui32SendErrors);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "deferred  : %d\r\n", stats.ui32Deferred);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "expired   : %d\r\n", stats.ui32Expired);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "aggregated: %d\r\n", stats.ui32Aggregated);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "rejected  : %d\r\n", stats.ui32Rejected);
+    strcat(pui8OutBuffer, line);
+
+    lorawan_receive_stats(&rx_stats);
+
+    am_util_stdio_sprintf(line, "\r\ndownlink buffers : %d x %d bytes\r\n", rx_stats.ui32Blocks, rx_stats.ui32BlockSize);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "free             : %d (min %d)\r\n", rx_stats.ui32Free, rx_stats.ui32MinFree);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "dispatched       : %d\r\n", rx_stats.ui32Dispatched);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "no buffer        : %d\r\n", rx_stats.ui32NoBuffer);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "queue full       : %d\r\n", rx_stats.ui32QueueFull);
+    strcat(pui8OutBuffer, line);
+    am_util_stdio_sprintf(line, "unclaimed        : %d\r\n", rx_stats.ui32Unclaimed);
+    strcat(pui8OutBuffer, line);
 }
 
 static portBASE_TYPE
@@ -397,7 +462,9 @@ lorawan_task_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const ch
     }
     else if (strcmp(argv[1], "clear") == 0)
     {
-        eeprom_format(&lorawan_eeprom_handle);
+        lorawan_command_t command;
+        command.eCommand = LORAWAN_CLEAR;
+        lorawan_send_command(&command);
     }
     else if (strcmp(argv[1], "datetime") == 0)
     {
@@ -425,6 +492,10 @@ lorawan_task_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const ch
     {
         lorawan_task_cli_port(pui8OutBuffer, argc, argv);
     }
+    else if (strcmp(argv[1], "stats") == 0)
+    {
+        lorawan_task_cli_stats(pui8OutBuffer, argc, argv);
+    }
 
     return pdFALSE;
 }
@@ -0,0 +1,152 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "lorawan_config.h"
+
+#include "lorawan_tx_pool.h"
+
+#if (LORAWAN_TX_POOL_BLOCKS < 1) || (LORAWAN_TX_POOL_BLOCKS > 255)
+#error "LORAWAN_TX_POOL_BLOCKS must be between 1 and 255"
+#endif
+
+static uint8_t lorawan_tx_pool_blocks[LORAWAN_TX_POOL_BLOCKS][LORAWAN_TX_BLOCK_SIZE]
+    __attribute__((aligned(4)));
+static uint8_t lorawan_tx_pool_state[LORAWAN_TX_POOL_BLOCKS];
+
+// Stack of free block indices, the next block to hand out on top.
+static uint8_t lorawan_tx_pool_free_list[LORAWAN_TX_POOL_BLOCKS];
+static uint32_t lorawan_tx_pool_free_count;
+static uint32_t lorawan_tx_pool_min_free;
+static uint32_t lorawan_tx_pool_reserved;
+static uint32_t lorawan_tx_pool_no_buffer;
+
+static int32_t lorawan_tx_pool_index(const uint8_t *pui8Block)
+{
+    uintptr_t offset = (uintptr_t)pui8Block - (uintptr_t)lorawan_tx_pool_blocks;
+
+    if ((pui8Block < &lorawan_tx_pool_blocks[0][0]) ||
+        (offset >= sizeof(lorawan_tx_pool_blocks)) || (offset % LORAWAN_TX_BLOCK_SIZE))
+    {
+        return -1;
+    }
+
+    return offset / LORAWAN_TX_BLOCK_SIZE;
+}
+
+void lorawan_tx_pool_init(void)
+{
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < LORAWAN_TX_POOL_BLOCKS; i++)
+    {
+        lorawan_tx_pool_state[i] = LORAWAN_TX_BLOCK_FREE;
+        lorawan_tx_pool_free_list[i] = LORAWAN_TX_POOL_BLOCKS - 1 - i;
+    }
+    lorawan_tx_pool_free_count = LORAWAN_TX_POOL_BLOCKS;
+    lorawan_tx_pool_min_free = LORAWAN_TX_POOL_BLOCKS;
+    lorawan_tx_pool_reserved = 0;
+    lorawan_tx_pool_no_buffer = 0;
+    taskEXIT_CRITICAL();
+}
+
+uint8_t *lorawan_tx_pool_alloc(void)
+{
+    uint8_t *pui8Block = NULL;
+    uint8_t ui8Index;
+
+    taskENTER_CRITICAL();
+    if (lorawan_tx_pool_free_count)
+    {
+        ui8Index = lorawan_tx_pool_free_list[--lorawan_tx_pool_free_count];
+        lorawan_tx_pool_state[ui8Index] = LORAWAN_TX_BLOCK_RESERVED;
+        pui8Block = lorawan_tx_pool_blocks[ui8Index];
+
+        lorawan_tx_pool_reserved++;
+        if (lorawan_tx_pool_free_count < lorawan_tx_pool_min_free)
+        {
+            lorawan_tx_pool_min_free = lorawan_tx_pool_free_count;
+        }
+    }
+    else
+    {
+        lorawan_tx_pool_no_buffer++;
+    }
+    taskEXIT_CRITICAL();
+
+    return pui8Block;
+}
+
+lorawan_tx_status_e lorawan_tx_pool_move(uint8_t *pui8Block,
+                                         lorawan_tx_block_state_e eFrom,
+                                         lorawan_tx_block_state_e eTo)
+{
+    lorawan_tx_status_e eStatus = LORAWAN_TX_INVALID;
+    int32_t i32Index = lorawan_tx_pool_index(pui8Block);
+
+    // Only lorawan_tx_pool_alloc() takes blocks off the free list.
+    if ((i32Index < 0) || (eFrom == LORAWAN_TX_BLOCK_FREE))
+    {
+        return LORAWAN_TX_INVALID;
+    }
+
+    // The state check makes a double release or a commit of a queued buffer
+    // fail instead of corrupting the free list.
+    taskENTER_CRITICAL();
+    if (lorawan_tx_pool_state[i32Index] == eFrom)
+    {
+        lorawan_tx_pool_state[i32Index] = eTo;
+        if (eTo == LORAWAN_TX_BLOCK_FREE)
+        {
+            lorawan_tx_pool_free_list[lorawan_tx_pool_free_count++] = i32Index;
+        }
+        eStatus = LORAWAN_TX_OK;
+    }
+    taskEXIT_CRITICAL();
+
+    return eStatus;
+}
+
+void lorawan_tx_pool_stats(lorawan_tx_stats_t *pStats)
+{
+    taskENTER_CRITICAL();
+    pStats->ui32Blocks = LORAWAN_TX_POOL_BLOCKS;
+    pStats->ui32BlockSize = LORAWAN_TX_BLOCK_SIZE;
+    pStats->ui32Free = lorawan_tx_pool_free_count;
+    pStats->ui32MinFree = lorawan_tx_pool_min_free;
+    pStats->ui32Reserved = lorawan_tx_pool_reserved;
+    pStats->ui32NoBuffer = lorawan_tx_pool_no_buffer;
+    taskEXIT_CRITICAL();
+}
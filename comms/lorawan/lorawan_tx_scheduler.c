@@ -0,0 +1,190 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "lorawan_config.h"
+
+#include "lorawan_tx_scheduler.h"
+
+// Unordered, a pick scans all of them.  There are no more entries than pool
+// blocks, so this is cheaper than keeping per class lists in order.
+static lorawan_tx_packet_t lorawan_tx_scheduler_entries[LORAWAN_TX_POOL_BLOCKS];
+static uint32_t lorawan_tx_scheduler_entry_count;
+
+// Tick and sequence comparisons that hold across the counter wrapping.
+static bool lorawan_tx_scheduler_before(uint32_t ui32A, uint32_t ui32B)
+{
+    return (int32_t)(ui32A - ui32B) < 0;
+}
+
+static bool lorawan_tx_scheduler_precedes(const lorawan_tx_packet_t *pA, const lorawan_tx_packet_t *pB)
+{
+    if (pA->ePriority != pB->ePriority)
+    {
+        return pA->ePriority > pB->ePriority;
+    }
+
+    if (pA->bExpires != pB->bExpires)
+    {
+        return pA->bExpires;
+    }
+
+    if (pA->bExpires && (pA->ui32Deadline != pB->ui32Deadline))
+    {
+        return lorawan_tx_scheduler_before(pA->ui32Deadline, pB->ui32Deadline);
+    }
+
+    return lorawan_tx_scheduler_before(pA->ui32Sequence, pB->ui32Sequence);
+}
+
+static void lorawan_tx_scheduler_remove(uint32_t ui32Index, lorawan_tx_packet_t *pPacket)
+{
+    *pPacket = lorawan_tx_scheduler_entries[ui32Index];
+    lorawan_tx_scheduler_entries[ui32Index] =
+        lorawan_tx_scheduler_entries[--lorawan_tx_scheduler_entry_count];
+}
+
+void lorawan_tx_scheduler_init(void)
+{
+    taskENTER_CRITICAL();
+    lorawan_tx_scheduler_entry_count = 0;
+    taskEXIT_CRITICAL();
+}
+
+bool lorawan_tx_scheduler_put(const lorawan_tx_packet_t *pPacket)
+{
+    bool bStored = false;
+
+    taskENTER_CRITICAL();
+    if (lorawan_tx_scheduler_entry_count < LORAWAN_TX_POOL_BLOCKS)
+    {
+        lorawan_tx_scheduler_entries[lorawan_tx_scheduler_entry_count++] = *pPacket;
+        bStored = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return bStored;
+}
+
+// Takes the uplink to send next.
+bool lorawan_tx_scheduler_get(lorawan_tx_packet_t *pPacket)
+{
+    return lorawan_tx_scheduler_get_matching(NULL, NULL, pPacket);
+}
+
+// Takes the uplink to send next among those pfnFilter accepts.
+bool lorawan_tx_scheduler_get_matching(lorawan_tx_scheduler_filter_t pfnFilter, void *pvContext,
+                                       lorawan_tx_packet_t *pPacket)
+{
+    lorawan_tx_packet_t *pEntry;
+    int32_t i32Best = -1;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < lorawan_tx_scheduler_entry_count; i++)
+    {
+        pEntry = &lorawan_tx_scheduler_entries[i];
+        if ((pfnFilter && !pfnFilter(pEntry, pvContext)) ||
+            ((i32Best >= 0) && !lorawan_tx_scheduler_precedes(pEntry, &lorawan_tx_scheduler_entries[i32Best])))
+        {
+            continue;
+        }
+        i32Best = i;
+    }
+
+    if (i32Best >= 0)
+    {
+        lorawan_tx_scheduler_remove(i32Best, pPacket);
+    }
+    taskEXIT_CRITICAL();
+
+    return i32Best >= 0;
+}
+
+void lorawan_tx_scheduler_for_each(lorawan_tx_scheduler_visit_t pfnVisit, void *pvContext)
+{
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < lorawan_tx_scheduler_entry_count; i++)
+    {
+        pfnVisit(&lorawan_tx_scheduler_entries[i], pvContext);
+    }
+    taskEXIT_CRITICAL();
+}
+
+// Takes an uplink whose deadline is before ui32Time, call until it fails.
+bool lorawan_tx_scheduler_get_expired(uint32_t ui32Time, lorawan_tx_packet_t *pPacket)
+{
+    bool bFound = false;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < lorawan_tx_scheduler_entry_count; i++)
+    {
+        if (lorawan_tx_scheduler_entries[i].bExpires &&
+            lorawan_tx_scheduler_before(lorawan_tx_scheduler_entries[i].ui32Deadline, ui32Time))
+        {
+            lorawan_tx_scheduler_remove(i, pPacket);
+            bFound = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return bFound;
+}
+
+bool lorawan_tx_scheduler_next_deadline(uint32_t *pui32Deadline)
+{
+    bool bFound = false;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < lorawan_tx_scheduler_entry_count; i++)
+    {
+        if (lorawan_tx_scheduler_entries[i].bExpires &&
+            (!bFound || lorawan_tx_scheduler_before(lorawan_tx_scheduler_entries[i].ui32Deadline, *pui32Deadline)))
+        {
+            *pui32Deadline = lorawan_tx_scheduler_entries[i].ui32Deadline;
+            bFound = true;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return bFound;
+}
+
+uint32_t lorawan_tx_scheduler_count(void)
+{
+    return lorawan_tx_scheduler_entry_count;
+}
@@ -0,0 +1,56 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _LORAWAN_TX_SCHEDULER_H_
+#define _LORAWAN_TX_SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lorawan.h"
+
+// Filters and visitors run with interrupts disabled.
+typedef bool (*lorawan_tx_scheduler_filter_t)(const lorawan_tx_packet_t *pPacket, void *pvContext);
+typedef void (*lorawan_tx_scheduler_visit_t)(const lorawan_tx_packet_t *pPacket, void *pvContext);
+
+// Committed uplinks waiting for the MAC, at most one per pool block.  Times
+// are in ticks.
+extern void lorawan_tx_scheduler_init(void);
+extern bool lorawan_tx_scheduler_put(const lorawan_tx_packet_t *pPacket);
+extern bool lorawan_tx_scheduler_get(lorawan_tx_packet_t *pPacket);
+extern bool lorawan_tx_scheduler_get_matching(lorawan_tx_scheduler_filter_t pfnFilter, void *pvContext,
+                                              lorawan_tx_packet_t *pPacket);
+extern void lorawan_tx_scheduler_for_each(lorawan_tx_scheduler_visit_t pfnVisit, void *pvContext);
+extern bool lorawan_tx_scheduler_get_expired(uint32_t ui32Time, lorawan_tx_packet_t *pPacket);
+extern bool lorawan_tx_scheduler_next_deadline(uint32_t *pui32Deadline);
+extern uint32_t lorawan_tx_scheduler_count(void);
+
+#endif
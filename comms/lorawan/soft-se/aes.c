@@ -64,6 +64,31 @@
 
 #include "aes.h"
 
+/* byte oriented rounds, used by all but the T-table encryption */
+#if ( AES_BACKEND != AES_BACKEND_TTABLE ) || defined( AES_DEC_PREKEYED ) \
+    || defined( AES_ENC_128_OTFK ) || defined( AES_DEC_128_OTFK )       \
+    || defined( AES_ENC_256_OTFK ) || defined( AES_DEC_256_OTFK )
+#  define BYTE_ROUNDS
+#endif
+
+/* table driven byte substitution in the encryption rounds */
+#if ( AES_BACKEND == AES_BACKEND_BYTE ) \
+    || defined( AES_ENC_128_OTFK ) || defined( AES_ENC_256_OTFK )
+#  define BYTE_ENC_ROUNDS
+#endif
+
+/* S-box table lookups, the constant time version only substitutes bytes
+   with boolean operations */
+#if ( AES_BACKEND != AES_BACKEND_CONST_TIME )                           \
+    || defined( AES_ENC_128_OTFK ) || defined( AES_DEC_128_OTFK )       \
+    || defined( AES_ENC_256_OTFK ) || defined( AES_DEC_256_OTFK )
+#  define SBOX_LOOKUPS
+#endif
+
+#if ( AES_BACKEND == AES_BACKEND_TTABLE ) && !defined( USE_TABLES )
+#  error The T-table backend requires USE_TABLES
+#endif
+
 //#if defined( HAVE_UINT_32T )
 //  typedef unsigned long uint32_t;
 //#endif
@@ -191,14 +216,27 @@
     w(0xf0), w(0xf1), w(0xf2), w(0xf3), w(0xf4), w(0xf5), w(0xf6), w(0xf7),\
     w(0xf8), w(0xf9), w(0xfa), w(0xfb), w(0xfc), w(0xfd), w(0xfe), w(0xff) }
 
+#if defined( SBOX_LOOKUPS )
 static const uint8_t sbox[256]  =  sb_data(f1);
+#endif
 
 #if defined( AES_DEC_PREKEYED )
 static const uint8_t isbox[256] = isb_data(f1);
 #endif
 
+#if defined( BYTE_ENC_ROUNDS )
 static const uint8_t gfm2_sbox[256] = sb_data(f2);
 static const uint8_t gfm3_sbox[256] = sb_data(f3);
+#endif
+
+#if ( AES_BACKEND == AES_BACKEND_TTABLE )
+/* the S-box value times ( 2, 1, 1, 3 ), the first column of a combined
+   SubBytes and MixColumns step, least significant byte in row 0 */
+#define te_w(p) ( (uint32_t)f2(p) | ((uint32_t)(p) << 8) | ((uint32_t)(p) << 16) \
+                | ((uint32_t)f3(p) << 24) )
+
+static const uint32_t te_tab[256] = sb_data(te_w);
+#endif
 
 #if defined( AES_DEC_PREKEYED )
 static const uint8_t gfmul_9[256] = mm_data(f9);
@@ -373,6 +411,8 @@ static void xor_block( void *d, const void *s )
 #endif
 }
 
+#if defined( BYTE_ROUNDS )
+
 static void copy_and_key( void *d, const void *s, const void *k )
 {
 #if defined( HAVE_UINT_32T )
@@ -408,6 +448,10 @@ static void add_round_key( uint8_t d[N_BLOCK], const uint8_t k[N_BLOCK] )
     xor_block(d, k);
 }
 
+#endif
+
+#if defined( BYTE_ENC_ROUNDS )
+
 static void shift_sub_rows( uint8_t st[N_BLOCK] )
 {   uint8_t tt;
 
@@ -424,6 +468,8 @@ static void shift_sub_rows( uint8_t st[N_BLOCK] )
     st[ 7] = s_box(st[ 3]); st[ 3] = s_box( tt );
 }
 
+#endif
+
 #if defined( AES_DEC_PREKEYED )
 
 static void inv_shift_sub_rows( uint8_t st[N_BLOCK] )
@@ -444,6 +490,8 @@ static void inv_shift_sub_rows( uint8_t st[N_BLOCK] )
 
 #endif
 
+#if defined( BYTE_ENC_ROUNDS )
+
 #if defined( VERSION_1 )
   static void mix_sub_columns( uint8_t dt[N_BLOCK] )
   { uint8_t st[N_BLOCK];
@@ -473,6 +521,8 @@ static void inv_shift_sub_rows( uint8_t st[N_BLOCK] )
     dt[15] = gfm3_sb(st[12]) ^ s_box(st[1]) ^ s_box(st[6]) ^ gfm2_sb(st[11]);
   }
 
+#endif
+
 #if defined( AES_DEC_PREKEYED )
 
 #if defined( VERSION_1 )
@@ -506,8 +556,250 @@ static void inv_shift_sub_rows( uint8_t st[N_BLOCK] )
 
 #endif
 
+#if ( AES_BACKEND == AES_BACKEND_TTABLE )
+
+/* the cipher state is kept as four little endian column words */
+
+#define word_in(x, c)   ( (uint32_t)(x)[4 * (c)] | ((uint32_t)(x)[4 * (c) + 1] << 8) \
+                        | ((uint32_t)(x)[4 * (c) + 2] << 16) | ((uint32_t)(x)[4 * (c) + 3] << 24) )
+#define word_out(x, c, v)   { (x)[4 * (c)] = (uint8_t)(v); (x)[4 * (c) + 1] = (uint8_t)((v) >> 8); \
+                            (x)[4 * (c) + 2] = (uint8_t)((v) >> 16); (x)[4 * (c) + 3] = (uint8_t)((v) >> 24); }
+
+#define bval(x, n)      ((uint8_t)((x) >> (8 * (n))))
+#define rot1(x)         (((x) << 8) | ((x) >> 24))
+#define rot2(x)         (((x) << 16) | ((x) >> 16))
+#define rot3(x)         (((x) << 24) | ((x) >> 8))
+
+/* one column of SubBytes, ShiftRows, MixColumns and AddRoundKey */
+#define fwd_rnd(x0, x1, x2, x3, k)                                      \
+    ( te_tab[bval(x0, 0)] ^ rot1(te_tab[bval(x1, 1)])                   \
+    ^ rot2(te_tab[bval(x2, 2)]) ^ rot3(te_tab[bval(x3, 3)]) ^ (k) )
+
+/* one column of SubBytes, ShiftRows and AddRoundKey */
+#define fwd_lrnd(x0, x1, x2, x3, k)                                     \
+    ( ( (uint32_t)s_box(bval(x0, 0)) | ((uint32_t)s_box(bval(x1, 1)) << 8)  \
+    | ((uint32_t)s_box(bval(x2, 2)) << 16) | ((uint32_t)s_box(bval(x3, 3)) << 24) ) ^ (k) )
+
+static void encrypt_ttable( const uint8_t in[N_BLOCK], uint8_t out[N_BLOCK], const aes_context ctx[1] )
+{   const uint8_t *k = ctx->ksch;
+    uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+    uint8_t r;
+
+    s0 = word_in(in, 0) ^ word_in(k, 0);
+    s1 = word_in(in, 1) ^ word_in(k, 1);
+    s2 = word_in(in, 2) ^ word_in(k, 2);
+    s3 = word_in(in, 3) ^ word_in(k, 3);
+
+    for( r = 1 ; r < ctx->rnd ; ++r )
+    {
+        k += N_BLOCK;
+        t0 = fwd_rnd(s0, s1, s2, s3, word_in(k, 0));
+        t1 = fwd_rnd(s1, s2, s3, s0, word_in(k, 1));
+        t2 = fwd_rnd(s2, s3, s0, s1, word_in(k, 2));
+        t3 = fwd_rnd(s3, s0, s1, s2, word_in(k, 3));
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+
+    k += N_BLOCK;
+    t0 = fwd_lrnd(s0, s1, s2, s3, word_in(k, 0));
+    t1 = fwd_lrnd(s1, s2, s3, s0, word_in(k, 1));
+    t2 = fwd_lrnd(s2, s3, s0, s1, word_in(k, 2));
+    t3 = fwd_lrnd(s3, s0, s1, s2, word_in(k, 3));
+
+    word_out(out, 0, t0);
+    word_out(out, 1, t1);
+    word_out(out, 2, t2);
+    word_out(out, 3, t3);
+}
+
+#endif
+
+#if ( AES_BACKEND == AES_BACKEND_CONST_TIME )
+
+/* multiplication by 2 without a data dependent branch */
+#define ct_f2(x)    ((uint8_t)(((x) << 1) ^ (-((x) >> 7) & BPOLY)))
+
+/* transpose an 8 x 8 bit matrix held one row per byte */
+static uint64_t transpose_8x8( uint64_t x )
+{   uint64_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+/*  The S-box as a boolean circuit (Boyar and Peralta, "A depth-16 circuit
+    for the AES S-box", 2011) on bit planes: q[n] holds bit n of every
+    byte of the state, q[7] being the most significant one. */
+
+static void sbox_circuit( uint32_t q[8] )
+{   uint32_t x0, x1, x2, x3, x4, x5, x6, x7;
+    uint32_t y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11;
+    uint32_t y12, y13, y14, y15, y16, y17, y18, y19, y20, y21;
+    uint32_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+    uint32_t z10, z11, z12, z13, z14, z15, z16, z17;
+    uint32_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+    uint32_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+    uint32_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+    uint32_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+    uint32_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+    uint32_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+    uint32_t t60, t61, t62, t63, t64, t65, t66, t67;
+    uint32_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7]; x1 = q[6]; x2 = q[5]; x3 = q[4];
+    x4 = q[3]; x5 = q[2]; x6 = q[1]; x7 = q[0];
+
+    /* top linear transformation */
+    y14 = x3 ^ x5;      y13 = x0 ^ x6;      y9 = x0 ^ x3;
+    y8 = x0 ^ x5;       t0 = x1 ^ x2;       y1 = t0 ^ x7;
+    y4 = y1 ^ x3;       y12 = y13 ^ y14;    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;       y3 = y5 ^ y8;       t1 = x4 ^ y12;
+    y15 = t1 ^ x5;      y20 = t1 ^ x1;      y6 = y15 ^ x7;
+    y10 = y15 ^ t0;     y11 = y20 ^ y9;     y7 = x7 ^ y11;
+    y17 = y10 ^ y11;    y19 = y10 ^ y8;     y16 = t0 ^ y11;
+    y21 = y13 ^ y16;    y18 = x0 ^ y16;
+
+    /* non-linear section */
+    t2 = y12 & y15;     t3 = y3 & y6;       t4 = t3 ^ t2;
+    t5 = y4 & x7;       t6 = t5 ^ t2;       t7 = y13 & y16;
+    t8 = y5 & y1;       t9 = t8 ^ t7;       t10 = y2 & y7;
+    t11 = t10 ^ t7;     t12 = y9 & y11;     t13 = y14 & y17;
+    t14 = t13 ^ t12;    t15 = y8 & y10;     t16 = t15 ^ t12;
+    t17 = t4 ^ t14;     t18 = t6 ^ t16;     t19 = t9 ^ t14;
+    t20 = t11 ^ t16;    t21 = t17 ^ y20;    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;    t26 = t21 & t23;    t27 = t24 ^ t26;
+    t28 = t25 & t27;    t29 = t28 ^ t22;    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;    t32 = t31 & t30;    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;    t35 = t27 ^ t33;    t36 = t24 & t35;
+    t37 = t36 ^ t34;    t38 = t27 ^ t36;    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;    t42 = t29 ^ t33;    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;    t45 = t42 ^ t41;
+    z0 = t44 & y15;     z1 = t37 & y6;      z2 = t33 & x7;
+    z3 = t43 & y16;     z4 = t40 & y1;      z5 = t29 & y7;
+    z6 = t42 & y11;     z7 = t45 & y17;     z8 = t41 & y10;
+    z9 = t44 & y12;     z10 = t37 & y3;     z11 = t33 & y4;
+    z12 = t43 & y13;    z13 = t40 & y5;     z14 = t29 & y2;
+    z15 = t42 & y9;     z16 = t45 & y14;    z17 = t41 & y8;
+
+    /* bottom linear transformation */
+    t46 = z15 ^ z16;    t47 = z10 ^ z11;    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;     t50 = z2 ^ z12;     t51 = z2 ^ z5;
+    t52 = z7 ^ z8;      t53 = z0 ^ z3;      t54 = z6 ^ z7;
+    t55 = z16 ^ z17;    t56 = z12 ^ t48;    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;     t59 = z3 ^ t54;     t60 = t46 ^ t57;
+    t61 = z14 ^ t57;    t62 = t52 ^ t58;    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;     t65 = t61 ^ t62;    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;     s6 = t56 ^ ~t62;    s7 = t48 ^ ~t60;
+    t67 = t64 ^ t65;    s3 = t53 ^ t66;     s4 = t51 ^ t66;
+    s5 = t47 ^ t65;     s1 = t64 ^ ~s3;     s2 = t55 ^ ~t67;
+
+    q[7] = s0; q[6] = s1; q[5] = s2; q[4] = s3;
+    q[3] = s4; q[2] = s5; q[1] = s6; q[0] = s7;
+}
+
+/* SubBytes on the 16 bytes of the state at once */
+static void sub_bytes_ct( uint8_t st[N_BLOCK] )
+{   uint64_t a = 0, b = 0;
+    uint32_t q[8];
+    uint8_t i;
+
+    for( i = 0 ; i < 8 ; ++i )
+    {
+        a |= (uint64_t)st[i] << (8 * i);
+        b |= (uint64_t)st[i + 8] << (8 * i);
+    }
+    a = transpose_8x8( a );
+    b = transpose_8x8( b );
+    for( i = 0 ; i < 8 ; ++i )
+        q[i] = (uint8_t)(a >> (8 * i)) | ((uint32_t)(uint8_t)(b >> (8 * i)) << 8);
+
+    sbox_circuit( q );
+
+    a = b = 0;
+    for( i = 0 ; i < 8 ; ++i )
+    {
+        a |= (uint64_t)(uint8_t)q[i] << (8 * i);
+        b |= (uint64_t)(uint8_t)(q[i] >> 8) << (8 * i);
+    }
+    a = transpose_8x8( a );
+    b = transpose_8x8( b );
+    for( i = 0 ; i < 8 ; ++i )
+    {
+        st[i] = (uint8_t)(a >> (8 * i));
+        st[i + 8] = (uint8_t)(b >> (8 * i));
+    }
+}
+
+static void shift_rows( uint8_t st[N_BLOCK] )
+{   uint8_t tt;
+
+    tt = st[1]; st[ 1] = st[ 5]; st[ 5] = st[ 9]; st[ 9] = st[13]; st[13] = tt;
+    tt = st[2]; st[ 2] = st[10]; st[10] = tt;
+    tt = st[6]; st[ 6] = st[14]; st[14] = tt;
+    tt = st[15]; st[15] = st[11]; st[11] = st[ 7]; st[ 7] = st[ 3]; st[ 3] = tt;
+}
+
+static void mix_columns( uint8_t st[N_BLOCK] )
+{   uint8_t c, a0, a1, a2, a3, tt;
+
+    for( c = 0 ; c < N_BLOCK ; c += N_ROW )
+    {
+        a0 = st[c]; a1 = st[c + 1]; a2 = st[c + 2]; a3 = st[c + 3];
+        tt = a0 ^ a1 ^ a2 ^ a3;
+        st[c    ] = a0 ^ tt ^ ct_f2(a0 ^ a1);
+        st[c + 1] = a1 ^ tt ^ ct_f2(a1 ^ a2);
+        st[c + 2] = a2 ^ tt ^ ct_f2(a2 ^ a3);
+        st[c + 3] = a3 ^ tt ^ ct_f2(a3 ^ a0);
+    }
+}
+
+static void encrypt_const_time( const uint8_t in[N_BLOCK], uint8_t out[N_BLOCK], const aes_context ctx[1] )
+{   uint8_t s1[N_BLOCK], r;
+
+    copy_and_key( s1, in, ctx->ksch );
+    for( r = 1 ; r < ctx->rnd ; ++r )
+    {
+        sub_bytes_ct( s1 );
+        shift_rows( s1 );
+        mix_columns( s1 );
+        add_round_key( s1, ctx->ksch + r * N_BLOCK );
+    }
+    sub_bytes_ct( s1 );
+    shift_rows( s1 );
+    copy_and_key( out, s1, ctx->ksch + r * N_BLOCK );
+}
+
+#endif
+
 #if defined( AES_ENC_PREKEYED ) || defined( AES_DEC_PREKEYED )
 
+/*  Substitute the four bytes of a key schedule word */
+
+static void sub_word( uint8_t w[4] )
+{
+#if ( AES_BACKEND == AES_BACKEND_CONST_TIME )
+    uint8_t st[N_BLOCK] = { 0 };
+
+    block_copy_nn(st, w, 4);
+    sub_bytes_ct( st );
+    block_copy_nn(w, st, 4);
+#else
+    w[0] = s_box(w[0]);
+    w[1] = s_box(w[1]);
+    w[2] = s_box(w[2]);
+    w[3] = s_box(w[3]);
+#endif
+}
+
 /*  Set the cipher key for the pre-keyed version */
 
 return_type aes_set_key( const uint8_t key[], length_type keylen, aes_context ctx[1] )
@@ -528,33 +820,32 @@ return_type aes_set_key( const uint8_t key[], length_type keylen, aes_context ct
     hi = (keylen + 28) << 2;
     ctx->rnd = (hi >> 4) - 1;
     for( cc = keylen, rc = 1; cc < hi; cc += 4 )
-    {   uint8_t tt, t0, t1, t2, t3;
+    {   uint8_t tt, t[4];
 
-        t0 = ctx->ksch[cc - 4];
-        t1 = ctx->ksch[cc - 3];
-        t2 = ctx->ksch[cc - 2];
-        t3 = ctx->ksch[cc - 1];
+        t[0] = ctx->ksch[cc - 4];
+        t[1] = ctx->ksch[cc - 3];
+        t[2] = ctx->ksch[cc - 2];
+        t[3] = ctx->ksch[cc - 1];
         if( cc % keylen == 0 )
         {
-            tt = t0;
-            t0 = s_box(t1) ^ rc;
-            t1 = s_box(t2);
-            t2 = s_box(t3);
-            t3 = s_box(tt);
+            tt = t[0];
+            t[0] = t[1];
+            t[1] = t[2];
+            t[2] = t[3];
+            t[3] = tt;
+            sub_word( t );
+            t[0] ^= rc;
             rc = f2(rc);
         }
         else if( keylen > 24 && cc % keylen == 16 )
         {
-            t0 = s_box(t0);
-            t1 = s_box(t1);
-            t2 = s_box(t2);
-            t3 = s_box(t3);
+            sub_word( t );
         }
         tt = cc - keylen;
-        ctx->ksch[cc + 0] = ctx->ksch[tt + 0] ^ t0;
-        ctx->ksch[cc + 1] = ctx->ksch[tt + 1] ^ t1;
-        ctx->ksch[cc + 2] = ctx->ksch[tt + 2] ^ t2;
-        ctx->ksch[cc + 3] = ctx->ksch[tt + 3] ^ t3;
+        ctx->ksch[cc + 0] = ctx->ksch[tt + 0] ^ t[0];
+        ctx->ksch[cc + 1] = ctx->ksch[tt + 1] ^ t[1];
+        ctx->ksch[cc + 2] = ctx->ksch[tt + 2] ^ t[2];
+        ctx->ksch[cc + 3] = ctx->ksch[tt + 3] ^ t[3];
     }
     return 0;
 }
@@ -569,6 +860,11 @@ return_type aes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK], const
 {
     if( ctx->rnd )
     {
+#if ( AES_BACKEND == AES_BACKEND_TTABLE )
+        encrypt_ttable( in, out, ctx );
+#elif ( AES_BACKEND == AES_BACKEND_CONST_TIME )
+        encrypt_const_time( in, out, ctx );
+#else
         uint8_t s1[N_BLOCK], r;
         copy_and_key( s1, in, ctx->ksch );
 
@@ -586,6 +882,7 @@ return_type aes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK], const
 #endif
         shift_sub_rows( s1 );
         copy_and_key( out, s1, ctx->ksch + r * N_BLOCK );
+#endif
     }
     else
         return ( uint8_t )-1;
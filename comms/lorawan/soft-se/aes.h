@@ -56,6 +56,25 @@ extern "C" {
 #  define AES_DEC_256_OTFK  /* AES decryption with 'on the fly' 256 bit keying */
 #endif
 
+/*  Implementation of aes_set_key() and aes_encrypt() for a precomputed key
+    schedule, the key schedule layout is the same for all of them:
+
+    AES_BACKEND_BYTE        8-bit operations on the cipher state
+    AES_BACKEND_TTABLE      32-bit column operations with a 1 kbyte T-table,
+                            the fastest on Cortex-M4.  Table lookups are
+                            indexed by the cipher state
+    AES_BACKEND_CONST_TIME  bitsliced S-box, no table lookup or branch
+                            depends on the key or the data, for devices
+                            exposed to timing or cache side channels
+*/
+#define AES_BACKEND_BYTE        0
+#define AES_BACKEND_TTABLE      1
+#define AES_BACKEND_CONST_TIME  2
+
+#ifndef AES_BACKEND
+#  define AES_BACKEND  AES_BACKEND_BYTE
+#endif
+
 #define N_ROW                   4
 #define N_COL                   4
 #define N_BLOCK   (N_ROW * N_COL)
@@ -32,6 +32,7 @@ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 DEALINGS WITH THE SOFTWARE
 
 *****************************************************************************/
+#include <stddef.h>
 #include <stdint.h>
 #include "aes.h"
 #include "cmac.h"
@@ -152,3 +153,112 @@ void AES_CMAC_Final( uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX* ctx )
     aes_encrypt( in, digest, &ctx->rijndael );
     memset1( K, 0, sizeof K );
 }
+
+/* Doubles a block in GF(2^128), deriving K1 from L and K2 from K1 */
+static void AES_CMAC_Double( const uint8_t in[16], uint8_t out[16] )
+{
+    uint8_t carry = in[0] & 0x80;
+
+    LSHIFT( in, out );
+    if( carry )
+        out[15] ^= 0x87;
+}
+
+void AES_CMAC_KeySetup( AES_CMAC_KEY* key, const uint8_t k[AES_CMAC_KEY_LENGTH] )
+{
+    uint8_t L[16];
+
+    memset1( ( uint8_t* )&key->rijndael, '\0', sizeof( key->rijndael ) );
+    aes_set_key( k, AES_CMAC_KEY_LENGTH, &key->rijndael );
+
+    memset1( L, '\0', 16 );
+    aes_encrypt( L, L, &key->rijndael );
+    AES_CMAC_Double( L, key->K1 );
+    AES_CMAC_Double( key->K1, key->K2 );
+    memset1( L, 0, sizeof L );
+}
+
+/* Folds the last, possibly partial, block into X */
+static void AES_CMAC_Last( uint8_t X[16], const AES_CMAC_KEY* key, const uint8_t* data, uint32_t len )
+{
+    uint8_t M_last[16];
+
+    if( len == 16 )
+    {
+        memcpy1( M_last, data, 16 );
+        XOR( key->K1, M_last );
+    }
+    else
+    {
+        memcpy1( M_last, data, len );
+        M_last[len] = 0x80;
+        while( ++len < 16 )
+            M_last[len] = 0;
+        XOR( key->K2, M_last );
+    }
+    XOR( M_last, X );
+}
+
+void AES_CMAC_Digest( uint8_t digest[AES_CMAC_DIGEST_LENGTH], const AES_CMAC_KEY* key, const uint8_t* prefix,
+                      const uint8_t* data, uint32_t len )
+{
+    uint8_t X[16];
+
+    memset1( X, 0, sizeof X );
+
+    if( prefix != NULL )
+    {
+        if( len == 0 )
+        {
+            /* the prefix is the last block */
+            AES_CMAC_Last( X, key, prefix, 16 );
+            aes_encrypt( X, digest, &key->rijndael );
+            return;
+        }
+        XOR( prefix, X );
+        aes_encrypt( X, X, &key->rijndael );
+    }
+    while( len > 16 )
+    {
+        XOR( data, X );
+        aes_encrypt( X, X, &key->rijndael );
+        data += 16;
+        len -= 16;
+    }
+    AES_CMAC_Last( X, key, data, len );
+    aes_encrypt( X, digest, &key->rijndael );
+}
+
+void AES_CMAC_Digest2( uint8_t digest0[AES_CMAC_DIGEST_LENGTH], const AES_CMAC_KEY* key0, const uint8_t* prefix0,
+                       uint8_t digest1[AES_CMAC_DIGEST_LENGTH], const AES_CMAC_KEY* key1, const uint8_t* prefix1,
+                       const uint8_t* data, uint32_t len )
+{
+    uint8_t X0[16];
+    uint8_t X1[16];
+
+    if( ( prefix0 == NULL ) || ( prefix1 == NULL ) || ( len == 0 ) )
+    {
+        AES_CMAC_Digest( digest0, key0, prefix0, data, len );
+        AES_CMAC_Digest( digest1, key1, prefix1, data, len );
+        return;
+    }
+
+    memcpy1( X0, prefix0, 16 );
+    memcpy1( X1, prefix1, 16 );
+    aes_encrypt( X0, X0, &key0->rijndael );
+    aes_encrypt( X1, X1, &key1->rijndael );
+
+    while( len > 16 )
+    {
+        XOR( data, X0 );
+        XOR( data, X1 );
+        aes_encrypt( X0, X0, &key0->rijndael );
+        aes_encrypt( X1, X1, &key1->rijndael );
+        data += 16;
+        len -= 16;
+    }
+    AES_CMAC_Last( X0, key0, data, len );
+    AES_CMAC_Last( X1, key1, data, len );
+    aes_encrypt( X0, digest0, &key0->rijndael );
+    aes_encrypt( X1, digest1, &key1->rijndael );
+}
@@ -51,6 +51,14 @@ typedef struct _AES_CMAC_CTX {
             uint8_t        M_last[16];
             uint32_t       M_n;
     } AES_CMAC_CTX;
+
+/* Key schedule and subkeys K1 and K2 of a key, set up once by
+   AES_CMAC_KeySetup() for any number of messages */
+typedef struct _AES_CMAC_KEY {
+            aes_context    rijndael;
+            uint8_t        K1[16];
+            uint8_t        K2[16];
+    } AES_CMAC_KEY;
    
 //#include <sys/cdefs.h>
     
@@ -61,6 +69,17 @@ void     AES_CMAC_Update(AES_CMAC_CTX * ctx, const uint8_t * data, uint32_t len)
           //          __attribute__((__bounded__(__string__,2,3)));
 void     AES_CMAC_Final(uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX  * ctx);
             //     __attribute__((__bounded__(__minbytes__,1,AES_CMAC_DIGEST_LENGTH)));
+
+/* One shot CMAC of prefix | data with a prepared key, prefix is an optional
+   16 byte block.  AES_CMAC_Digest2() computes the CMACs of prefix0 | data and
+   prefix1 | data with two keys in a single pass over data. */
+void     AES_CMAC_KeySetup(AES_CMAC_KEY * key, const uint8_t k[AES_CMAC_KEY_LENGTH]);
+void     AES_CMAC_Digest(uint8_t digest[AES_CMAC_DIGEST_LENGTH], const AES_CMAC_KEY * key,
+                         const uint8_t * prefix, const uint8_t * data, uint32_t len);
+void     AES_CMAC_Digest2(uint8_t digest0[AES_CMAC_DIGEST_LENGTH], const AES_CMAC_KEY * key0,
+                          const uint8_t * prefix0, uint8_t digest1[AES_CMAC_DIGEST_LENGTH],
+                          const AES_CMAC_KEY * key1, const uint8_t * prefix1,
+                          const uint8_t * data, uint32_t len);
 //__END_DECLS
 
 #ifdef __cplusplus
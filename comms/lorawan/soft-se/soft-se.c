@@ -25,6 +25,7 @@
  */
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <am_mcu_apollo.h>
 #include <am_util.h>
@@ -38,9 +39,47 @@
 #include "secure-element.h"
 #include "secure-element-nvm.h"
 
+/*!
+ * Number of expanded AES key schedules kept in RAM, with their CMAC subkeys.
+ * Each entry takes about 290 bytes. A LoRaWAN 1.0.x session uses up to four
+ * keys per frame.
+ */
+#ifndef SOFT_SE_KEY_CACHE_SIZE
+#define SOFT_SE_KEY_CACHE_SIZE 4
+#endif
+
+#if( SOFT_SE_KEY_CACHE_SIZE < 2 )
+#error "SOFT_SE_KEY_CACHE_SIZE must hold the two keys of SecureElementComputeAesCmacPair"
+#endif
+
+/*!
+ * Number of key identifiers mapped by KeySlotIndex
+ */
+#define NUM_OF_KEY_SLOTS ( MC_ROOT_KEY + 1 + SLOT_RAND_ZERO_KEY - MC_KE_KEY + 1 )
+
+/*!
+ * Expanded key schedule and CMAC subkeys cache entry. The key value they were
+ * derived from is kept to detect keys changed behind the secure element, e.g.
+ * when the NVM context is restored.
+ */
+typedef struct sKeyCacheEntry
+{
+    KeyIdentifier_t KeyID;
+    uint8_t KeyValue[SE_KEY_SIZE];
+    AES_CMAC_KEY CmacKey;
+} KeyCacheEntry_t;
+
 extern SecureElementNvmData_t lorawan_se;
 static SecureElementNvmData_t* SeNvm;
 
+/*!
+ * Index of each key identifier in the key list
+ */
+static uint8_t KeySlotIndex[NUM_OF_KEY_SLOTS];
+
+static KeyCacheEntry_t KeyCache[SOFT_SE_KEY_CACHE_SIZE];
+static uint8_t KeyCacheNext = 0;
+
 static void SecureElementSetDeviceEUI()
 {
     uint8_t isEmpty = true;
@@ -78,10 +117,35 @@ static void SecureElementSetDeviceEUI()
  */
 static SecureElementStatus_t GetKeyByID( KeyIdentifier_t keyID, Key_t** keyItem )
 {
+    uint32_t slot;
+
+    // Key identifiers form two contiguous ranges, unicast keys from 0 and
+    // multicast keys from MC_KE_KEY.
+    if( keyID <= MC_ROOT_KEY )
+    {
+        slot = keyID;
+    }
+    else if( ( keyID >= MC_KE_KEY ) && ( keyID <= SLOT_RAND_ZERO_KEY ) )
+    {
+        slot = MC_ROOT_KEY + 1 + keyID - MC_KE_KEY;
+    }
+    else
+    {
+        return SECURE_ELEMENT_ERROR_INVALID_KEY_ID;
+    }
+
+    if( ( KeySlotIndex[slot] < NUM_OF_KEYS ) && ( SeNvm->KeyList[KeySlotIndex[slot]].KeyID == keyID ) )
+    {
+        *keyItem = &( SeNvm->KeyList[KeySlotIndex[slot]] );
+        return SECURE_ELEMENT_SUCCESS;
+    }
+
+    // The key list was replaced, e.g. restored from NVM, refresh the slot
     for( uint8_t i = 0; i < NUM_OF_KEYS; i++ )
     {
         if( SeNvm->KeyList[i].KeyID == keyID )
         {
+            KeySlotIndex[slot] = i;
             *keyItem = &( SeNvm->KeyList[i] );
             return SECURE_ELEMENT_SUCCESS;
         }
@@ -89,6 +153,69 @@ static SecureElementStatus_t GetKeyByID( KeyIdentifier_t keyID, Key_t** keyItem
     return SECURE_ELEMENT_ERROR_INVALID_KEY_ID;
 }
 
+/*
+ * Gets the expanded AES key schedule and CMAC subkeys of a key, deriving them
+ * on a cache miss.
+ *
+ * \param[IN]  keyID          - Key identifier
+ * \param[IN]  keep           - Cached key schedule which must not be replaced, or NULL
+ * \param[OUT] cmacKey        - Key schedule and subkeys reference
+ * \retval                    - Status of the operation
+ */
+static SecureElementStatus_t GetCmacKeyByID( KeyIdentifier_t keyID, const AES_CMAC_KEY* keep,
+                                             const AES_CMAC_KEY** cmacKey )
+{
+    Key_t*                keyItem;
+    KeyCacheEntry_t*      entry;
+    SecureElementStatus_t retval = GetKeyByID( keyID, &keyItem );
+
+    if( retval != SECURE_ELEMENT_SUCCESS )
+    {
+        return retval;
+    }
+
+    for( uint8_t i = 0; i < SOFT_SE_KEY_CACHE_SIZE; i++ )
+    {
+        entry = &KeyCache[i];
+        if( ( entry->KeyID == keyID ) && ( memcmp( entry->KeyValue, keyItem->KeyValue, SE_KEY_SIZE ) == 0 ) )
+        {
+            *cmacKey = &entry->CmacKey;
+            return SECURE_ELEMENT_SUCCESS;
+        }
+    }
+
+    // Replace the entries in turn, skipping the one still in use
+    if( &KeyCache[KeyCacheNext].CmacKey == keep )
+    {
+        KeyCacheNext = ( KeyCacheNext + 1 ) % SOFT_SE_KEY_CACHE_SIZE;
+    }
+    entry        = &KeyCache[KeyCacheNext];
+    KeyCacheNext = ( KeyCacheNext + 1 ) % SOFT_SE_KEY_CACHE_SIZE;
+
+    AES_CMAC_KeySetup( &entry->CmacKey, keyItem->KeyValue );
+    memcpy1( entry->KeyValue, keyItem->KeyValue, SE_KEY_SIZE );
+    entry->KeyID = keyID;
+
+    *cmacKey = &entry->CmacKey;
+    return SECURE_ELEMENT_SUCCESS;
+}
+
+/*
+ * Drops the cached key schedule of a key.
+ *
+ * \param[IN]  keyID          - Key identifier
+ */
+static void InvalidateAesContext( KeyIdentifier_t keyID )
+{
+    for( uint8_t i = 0; i < SOFT_SE_KEY_CACHE_SIZE; i++ )
+    {
+        if( KeyCache[i].KeyID == keyID )
+        {
+            KeyCache[i].KeyID = NO_KEY;
+        }
+    }
+}
+
 /*
  * Computes a CMAC of a message using provided initial Bx block
  *
@@ -110,25 +237,13 @@ static SecureElementStatus_t ComputeCmac( uint8_t* micBxBuffer, uint8_t* buffer,
     }
 
     uint8_t Cmac[16];
-    AES_CMAC_CTX aesCmacCtx[1];
-
-    AES_CMAC_Init( aesCmacCtx );
 
-    Key_t*                keyItem;
-    SecureElementStatus_t retval = GetKeyByID( keyID, &keyItem );
+    const AES_CMAC_KEY*   cmacKey;
+    SecureElementStatus_t retval = GetCmacKeyByID( keyID, NULL, &cmacKey );
 
     if( retval == SECURE_ELEMENT_SUCCESS )
     {
-        AES_CMAC_SetKey( aesCmacCtx, keyItem->KeyValue );
-
-        if( micBxBuffer != NULL )
-        {
-            AES_CMAC_Update( aesCmacCtx, micBxBuffer, 16 );
-        }
-
-        AES_CMAC_Update( aesCmacCtx, buffer, size );
-
-        AES_CMAC_Final( Cmac, aesCmacCtx );
+        AES_CMAC_Digest( Cmac, cmacKey, micBxBuffer, buffer, size );
 
         // Bring into the required format
         *cmac = ( uint32_t )( ( uint32_t ) Cmac[3] << 24 | ( uint32_t ) Cmac[2] << 16 | ( uint32_t ) Cmac[1] << 8 |
@@ -158,6 +273,15 @@ SecureElementStatus_t SecureElementInit( SecureElementNvmData_t* nvm )
     // Initialize data
     memcpy1( ( uint8_t* )SeNvm, ( uint8_t* )&lorawan_se, sizeof( lorawan_se ) );
 
+    // Index the key list and drop all cached key schedules
+    for( uint8_t i = 0; i < NUM_OF_KEY_SLOTS; i++ )
+    {
+        KeySlotIndex[i] = NUM_OF_KEYS;
+    }
+    for( uint8_t i = 0; i < SOFT_SE_KEY_CACHE_SIZE; i++ )
+    {
+        KeyCache[i].KeyID = NO_KEY;
+    }
 
     return SECURE_ELEMENT_SUCCESS;
 }
@@ -169,6 +293,8 @@ SecureElementStatus_t SecureElementSetKey( KeyIdentifier_t keyID, uint8_t* key )
         return SECURE_ELEMENT_ERROR_NPE;
     }
 
+    InvalidateAesContext( keyID );
+
     for( uint8_t i = 0; i < NUM_OF_KEYS; i++ )
     {
         if( SeNvm->KeyList[i].KeyID == keyID )
@@ -206,6 +332,45 @@ SecureElementStatus_t SecureElementComputeAesCmac( uint8_t* micBxBuffer, uint8_t
     return ComputeCmac( micBxBuffer, buffer, size, keyID, cmac );
 }
 
+SecureElementStatus_t SecureElementComputeAesCmacPair( uint8_t* micBxBuffer0, uint8_t* micBxBuffer1, uint8_t* buffer,
+                                                       uint16_t size, KeyIdentifier_t keyID0, KeyIdentifier_t keyID1,
+                                                       uint32_t* cmac0, uint32_t* cmac1 )
+{
+    if( ( keyID0 >= LORAMAC_CRYPTO_MULTICAST_KEYS ) || ( keyID1 >= LORAMAC_CRYPTO_MULTICAST_KEYS ) )
+    {
+        // Never accept multicast key identifier for cmac computation
+        return SECURE_ELEMENT_ERROR_INVALID_KEY_ID;
+    }
+    if( ( buffer == NULL ) || ( cmac0 == NULL ) || ( cmac1 == NULL ) )
+    {
+        return SECURE_ELEMENT_ERROR_NPE;
+    }
+
+    uint8_t Cmac0[16];
+    uint8_t Cmac1[16];
+
+    const AES_CMAC_KEY*   cmacKey0;
+    const AES_CMAC_KEY*   cmacKey1;
+    SecureElementStatus_t retval = GetCmacKeyByID( keyID0, NULL, &cmacKey0 );
+
+    if( retval == SECURE_ELEMENT_SUCCESS )
+    {
+        // A miss must not replace the entry holding cmacKey0
+        retval = GetCmacKeyByID( keyID1, cmacKey0, &cmacKey1 );
+    }
+    if( retval == SECURE_ELEMENT_SUCCESS )
+    {
+        AES_CMAC_Digest2( Cmac0, cmacKey0, micBxBuffer0, Cmac1, cmacKey1, micBxBuffer1, buffer, size );
+
+        *cmac0 = ( uint32_t )( ( uint32_t ) Cmac0[3] << 24 | ( uint32_t ) Cmac0[2] << 16 |
+                               ( uint32_t ) Cmac0[1] << 8 | ( uint32_t ) Cmac0[0] );
+        *cmac1 = ( uint32_t )( ( uint32_t ) Cmac1[3] << 24 | ( uint32_t ) Cmac1[2] << 16 |
+                               ( uint32_t ) Cmac1[1] << 8 | ( uint32_t ) Cmac1[0] );
+    }
+
+    return retval;
+}
+
 SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t* buffer, uint16_t size, uint32_t expectedCmac,
                                                   KeyIdentifier_t keyID )
 {
@@ -244,21 +409,16 @@ SecureElementStatus_t SecureElementAesEncrypt( uint8_t* buffer, uint16_t size, K
         return SECURE_ELEMENT_ERROR_BUF_SIZE;
     }
 
-    aes_context aesContext;
-    memset1( aesContext.ksch, '\0', 240 );
-
-    Key_t*                pItem;
-    SecureElementStatus_t retval = GetKeyByID( keyID, &pItem );
+    const AES_CMAC_KEY*   cmacKey;
+    SecureElementStatus_t retval = GetCmacKeyByID( keyID, NULL, &cmacKey );
 
     if( retval == SECURE_ELEMENT_SUCCESS )
     {
-        aes_set_key( pItem->KeyValue, 16, &aesContext );
-
         uint8_t block = 0;
 
         while( size != 0 )
         {
-            aes_encrypt( &buffer[block], &encBuffer[block], &aesContext );
+            aes_encrypt( &buffer[block], &encBuffer[block], &cmacKey->rijndael );
             block = block + 16;
             size  = size - 16;
         }
@@ -266,6 +426,41 @@ SecureElementStatus_t SecureElementAesEncrypt( uint8_t* buffer, uint16_t size, K
     return retval;
 }
 
+SecureElementStatus_t SecureElementAesCtrXor( uint8_t* aBlock, uint8_t* buffer, uint16_t size, KeyIdentifier_t keyID )
+{
+    if( aBlock == NULL || buffer == NULL )
+    {
+        return SECURE_ELEMENT_ERROR_NPE;
+    }
+
+    const AES_CMAC_KEY*   cmacKey;
+    SecureElementStatus_t retval = GetCmacKeyByID( keyID, NULL, &cmacKey );
+
+    if( retval == SECURE_ELEMENT_SUCCESS )
+    {
+        uint8_t ctrBlock[16];
+        uint8_t sBlock[16];
+
+        memcpy1( ctrBlock, aBlock, 16 );
+
+        while( size > 0 )
+        {
+            uint16_t n = ( size > 16 ) ? 16 : size;
+
+            aes_encrypt( ctrBlock, sBlock, &cmacKey->rijndael );
+            ctrBlock[15]++;
+
+            for( uint16_t i = 0; i < n; i++ )
+            {
+                buffer[i] ^= sBlock[i];
+            }
+            buffer += n;
+            size -= n;
+        }
+    }
+    return retval;
+}
+
 SecureElementStatus_t SecureElementDeriveAndStoreKey( uint8_t* input, KeyIdentifier_t rootKeyID,
                                                       KeyIdentifier_t targetKeyID )
 {
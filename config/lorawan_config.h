@@ -40,6 +40,42 @@
 #define LORAWAN_EEPROM_NUMBER_OF_PAGES    (2)
 #define LORAWAN_EEPROM_START_ADDRESS      (AM_HAL_FLASH_INSTANCE_SIZE - (LORAWAN_EEPROM_NUMBER_OF_PAGES * AM_HAL_FLASH_PAGE_SIZE))
 
+/* Number of virtual addresses covered by the RAM index of the emulated EEPROM.
+ * It should span the whole LoRaMac NVM context; set to 0 to disable. */
+#define LORAWAN_EEPROM_INDEX_SIZE         (2048)
+
+/* Free words left in the active EEPROM page below which the lorawan task
+ * starts transferring to a new page while idle, and the number of words it
+ * copies per pass.  A threshold of 0 leaves transfers to the write that fills
+ * the page. */
+#define LORAWAN_EEPROM_COMPACTION_THRESHOLD (512)
+#define LORAWAN_EEPROM_COMPACTION_BUDGET    (64)
+
+/* Time in ms during which LoRaMac context changes are accumulated and stored
+ * together, only the frame counters being written when they change.  The
+ * pending changes are also stored when the stack is stopped and before a
+ * reset.  Set to 0 to store every change immediately. */
+#define NVM_DATA_MGMT_COALESCE_WINDOW       (60000)
+
+/* Uplink buffers handed out by lorawan_tx_reserve(), and the payload size of
+ * each.  A buffer stays out of the pool until its uplink is confirmed. */
+#define LORAWAN_TX_POOL_BLOCKS              (16)
+#define LORAWAN_TX_BLOCK_SIZE               (242)
+
+/* Number of ports lorawan_tx_aggregation_enable() can pack small uplinks on;
+ * set to 0 to leave aggregation out. */
+#define LORAWAN_TX_AGGREGATION_PORTS        (4)
+
+/* Downlink buffers handed to consumers, and the payload size of each.  A
+ * downlink arriving while all of them are held by consumers is dropped. */
+#define LORAWAN_RX_POOL_BLOCKS              (4)
+#define LORAWAN_RX_BLOCK_SIZE               (242)
+
+/* Downlink consumers lorawan_receive_register() and
+ * lorawan_receive_register_callback() can hold, over all ports.  Each
+ * consumer of a port gets its own copy of the downlink. */
+#define LORAWAN_RX_CONSUMERS                (8)
+
 #define LORAWAN_CLOCK_SOURCE    AM_HAL_STIMER_XTAL_32KHZ
 #define LORAWAN_CLOCK_PERIOD    32768
 
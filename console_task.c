@@ -41,7 +41,10 @@
 #include <stream_buffer.h>
 #include <task.h>
 
+#include "rtos_stats.h"
+
 #include "console_task.h"
+#include "console_task_cli.h"
 
 #define MAX_CMD_HIST_LEN (8)
 #define MAX_INPUT_LEN    (128)
@@ -170,6 +173,8 @@ static void console_task_setup(void)
     memset(cmd_hist, 0, MAX_CMD_HIST_LEN * MAX_INPUT_LEN);
 
     stream_buffer = xStreamBufferCreate(STREAM_BUFFER_SIZE, 1);
+
+    console_task_cli_register();
 }
 
 static void console_task(void *parameter)
@@ -306,6 +311,8 @@ void am_uart_isr()
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     uint32_t received = 0;
 
+    rtos_stats_isr_enter(RTOS_STATS_ISR_UART);
+
     uart_transfer.pui32BytesTransferred = &received;
 
     am_bsp_buffered_uart_service();
@@ -316,5 +323,7 @@ void am_uart_isr()
             stream_buffer, (void *)uart_buffer, received, &xHigherPriorityTaskWoken);
     }
 
+    rtos_stats_isr_exit(RTOS_STATS_ISR_UART);
+
     portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
 }
@@ -0,0 +1,257 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <FreeRTOS_CLI.h>
+#include <task.h>
+
+#include <rtos_stats.h>
+
+#include "console_task_cli.h"
+
+// top needs the run-time counters and the trace facility of the kernel.
+#if defined(RTOS_STATS_ENABLED)
+static portBASE_TYPE console_task_cli_entry(char *pui8OutBuffer,
+                                            size_t ui32OutBufferLength,
+                                            const char *pui8Command);
+
+static CLI_Command_Definition_t console_task_cli_definition = {
+    (const char *const) "top",
+    (const char *const) "top    :  CPU usage since the previous top.\r\n",
+    console_task_cli_entry,
+    0};
+
+static const char *isr_names[RTOS_STATS_ISRS] = {
+    "stimer", "gpio", "ctimer", "uart", "ble"};
+
+static TaskStatus_t task_status[RTOS_STATS_MAX_TASKS];
+
+// Snapshot of the previous top, the figures shown are the deltas since then.
+static uint32_t previous_counter;
+static uint32_t previous_runtime[RTOS_STATS_MAX_TASKS];
+static rtos_stats_t previous_stats;
+static rtos_stats_t stats;
+
+// Report being printed: its snapshot and the next line to print.
+static UBaseType_t top_tasks;
+static uint32_t top_elapsed;
+static uint32_t top_row;
+
+// Tenths of a percent of value over total.
+static uint32_t permille(uint64_t ui64Value, uint64_t ui64Total)
+{
+    if (ui64Total == 0)
+    {
+        return 0;
+    }
+
+    return (uint32_t)((ui64Value * 1000 + ui64Total / 2) / ui64Total);
+}
+
+static char task_state(eTaskState eState)
+{
+    switch (eState)
+    {
+    case eRunning:
+        return 'X';
+    case eReady:
+        return 'R';
+    case eBlocked:
+        return 'B';
+    case eSuspended:
+        return 'S';
+    default:
+        return 'D';
+    }
+}
+
+static void top_task(char *pcLine, size_t ui32Size, UBaseType_t uxIndex)
+{
+    TaskStatus_t *psTask = &task_status[uxIndex];
+    uint32_t ui32Number = psTask->xTaskNumber;
+    uint32_t ui32Runtime = psTask->ulRunTimeCounter;
+    uint32_t ui32Switches = 0;
+    uint32_t ui32Permille;
+
+    if (ui32Number < RTOS_STATS_MAX_TASKS)
+    {
+        ui32Runtime -= previous_runtime[ui32Number];
+        ui32Switches = stats.ui32TaskSwitches[ui32Number] -
+                       previous_stats.ui32TaskSwitches[ui32Number];
+    }
+
+    ui32Permille = permille(ui32Runtime, top_elapsed);
+    am_util_stdio_snprintf(pcLine,
+                           ui32Size,
+                           "%-16s %c %3d %3d.%d %7d %5d\r\n",
+                           psTask->pcTaskName,
+                           task_state(psTask->eCurrentState),
+                           (uint32_t)psTask->uxCurrentPriority,
+                           ui32Permille / 10,
+                           ui32Permille % 10,
+                           ui32Switches,
+                           psTask->usStackHighWaterMark);
+}
+
+static void top_isr(char *pcLine, size_t ui32Size, uint32_t ui32Index)
+{
+    uint64_t ui64ElapsedCycles = (uint64_t)top_elapsed * configCPU_CLOCK_HZ / RTOS_STATS_COUNTER_HZ;
+    uint32_t ui32Count = stats.sIsr[ui32Index].ui32Count - previous_stats.sIsr[ui32Index].ui32Count;
+    uint64_t ui64Cycles = stats.sIsr[ui32Index].ui64Cycles - previous_stats.sIsr[ui32Index].ui64Cycles;
+    uint32_t ui32Permille = permille(ui64Cycles, ui64ElapsedCycles);
+
+    am_util_stdio_snprintf(pcLine,
+                           ui32Size,
+                           "%-6s %7d %9d %3d.%d\r\n",
+                           isr_names[ui32Index],
+                           ui32Count,
+                           (uint32_t)(ui64Cycles / (configCPU_CLOCK_HZ / 1000000)),
+                           ui32Permille / 10,
+                           ui32Permille % 10);
+}
+
+static void top_sleep(char *pcLine, size_t ui32Size)
+{
+    uint32_t ui32Sleeps = stats.ui32Sleeps - previous_stats.ui32Sleeps;
+    uint64_t ui64Ticks = stats.ui64SleepTicks - previous_stats.ui64SleepTicks;
+    uint32_t ui32Permille = permille(ui64Ticks, top_elapsed);
+
+    am_util_stdio_snprintf(pcLine,
+                           ui32Size,
+                           "\r\ndeep sleep %d.%d%% in %d sleeps, %d switches over %d ms\r\n",
+                           ui32Permille / 10,
+                           ui32Permille % 10,
+                           ui32Sleeps,
+                           stats.ui32Switches - previous_stats.ui32Switches,
+                           (uint32_t)((uint64_t)top_elapsed * 1000 / RTOS_STATS_COUNTER_HZ));
+}
+
+// Renders line ui32Row of the report, the task table, the interrupt table
+// and the sleep summary.  Returns false past the last line.
+static bool top_line(char *pcLine, size_t ui32Size, uint32_t ui32Row)
+{
+    if (ui32Row == 0)
+    {
+        am_util_stdio_snprintf(pcLine, ui32Size, "\r\ntask             st pri   cpu%%  switch stack\r\n");
+        return true;
+    }
+    ui32Row -= 1;
+
+    if (ui32Row < top_tasks)
+    {
+        top_task(pcLine, ui32Size, ui32Row);
+        return true;
+    }
+    ui32Row -= top_tasks;
+
+    if (ui32Row == 0)
+    {
+        am_util_stdio_snprintf(pcLine, ui32Size, "\r\nisr      count        us   cpu%%\r\n");
+        return true;
+    }
+    ui32Row -= 1;
+
+    if (ui32Row < RTOS_STATS_ISRS)
+    {
+        top_isr(pcLine, ui32Size, ui32Row);
+        return true;
+    }
+    ui32Row -= RTOS_STATS_ISRS;
+
+    if (ui32Row == 0)
+    {
+        top_sleep(pcLine, ui32Size);
+        return true;
+    }
+
+    return false;
+}
+
+// The report is taken at the first call and handed out a page at a time, as
+// much as fits the output buffer, the CLI calling again while pdTRUE is
+// returned.
+portBASE_TYPE
+console_task_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const char *pui8Command)
+{
+    char line[96];
+    size_t ui32Length = 0;
+    size_t ui32LineLength;
+    uint32_t ui32Counter;
+
+    pui8OutBuffer[0] = 0;
+
+    if (top_row == 0)
+    {
+        rtos_stats_get(&stats);
+        top_tasks = uxTaskGetSystemState(task_status, RTOS_STATS_MAX_TASKS, &ui32Counter);
+        ui32Counter = rtos_stats_counter_get();
+        top_elapsed = ui32Counter - previous_counter;
+        previous_counter = ui32Counter;
+    }
+
+    while (top_line(line, sizeof(line), top_row))
+    {
+        ui32LineLength = strlen(line);
+        if (ui32Length + ui32LineLength >= ui32OutBufferLength)
+        {
+            return pdTRUE;
+        }
+        memcpy(&pui8OutBuffer[ui32Length], line, ui32LineLength + 1);
+        ui32Length += ui32LineLength;
+        top_row++;
+    }
+
+    for (UBaseType_t i = 0; i < top_tasks; i++)
+    {
+        if (task_status[i].xTaskNumber < RTOS_STATS_MAX_TASKS)
+        {
+            previous_runtime[task_status[i].xTaskNumber] = task_status[i].ulRunTimeCounter;
+        }
+    }
+    previous_stats = stats;
+    top_row = 0;
+
+    return pdFALSE;
+}
+#endif /* RTOS_STATS_ENABLED */
+
+void console_task_cli_register()
+{
+#if defined(RTOS_STATS_ENABLED)
+    FreeRTOS_CLIRegisterCommand(&console_task_cli_definition);
+#endif
+}
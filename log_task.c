@@ -0,0 +1,139 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "deferred_log.h"
+
+#include "console_task.h"
+#include "log_task.h"
+
+static TaskHandle_t log_task_handle;
+static deferred_log_record_t log_record;
+
+static void log_task_notify(void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if (log_task_handle == NULL)
+    {
+        return;
+    }
+
+    if (xPortIsInsideInterrupt())
+    {
+        vTaskNotifyGiveFromISR(log_task_handle, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    }
+    else
+    {
+        xTaskNotifyGive(log_task_handle);
+    }
+}
+
+static void log_task_print(deferred_log_record_t *pRecord)
+{
+    uintptr_t *a = pRecord->puArgs;
+
+    if (pRecord->pcFormat)
+    {
+        // unused arguments are 0 and ignored by the format
+        am_util_stdio_printf(pRecord->pcFormat, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+        return;
+    }
+
+    for (uint32_t i = 0; i < pRecord->ui32Length; i++)
+    {
+        am_util_stdio_printf("%02X ", pRecord->pui8Data[i]);
+        if (((i + 1) % 16) == 0 && (i + 1) < pRecord->ui32Length)
+        {
+            am_util_stdio_printf("\n\r");
+        }
+    }
+    am_util_stdio_printf("\n\r");
+}
+
+static void log_task(void *parameter)
+{
+    uint32_t ui32Dropped = 0;
+    uint32_t ui32Printed;
+    deferred_log_status_e eStatus;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        ui32Printed = 0;
+        do
+        {
+            eStatus = deferred_log_read(&log_record);
+            if (eStatus == DEFERRED_LOG_RECORD)
+            {
+                memset(log_record.puArgs + log_record.ui32Args,
+                       0,
+                       (DEFERRED_LOG_MAX_ARGS - log_record.ui32Args) * sizeof(uintptr_t));
+                log_task_print(&log_record);
+                ui32Printed++;
+            }
+            else if (eStatus == DEFERRED_LOG_PENDING)
+            {
+                // a writer was preempted between its reservation and its commit
+                vTaskDelay(1);
+            }
+        } while (eStatus != DEFERRED_LOG_EMPTY);
+
+        if (deferred_log_dropped() != ui32Dropped)
+        {
+            am_util_stdio_printf("\n\r[log] %u records dropped\n\r",
+                                 deferred_log_dropped() - ui32Dropped);
+            ui32Dropped = deferred_log_dropped();
+            ui32Printed++;
+        }
+
+        if (ui32Printed)
+        {
+            console_print_prompt();
+        }
+    }
+}
+
+void log_task_create(uint32_t priority)
+{
+    deferred_log_init(log_task_notify);
+    xTaskCreate(log_task, "log", 512, 0, priority, &log_task_handle);
+}
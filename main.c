@@ -41,13 +41,20 @@
 #include <FreeRTOS.h>
 #include <task.h>
 
+#include "deferred_log.h"
 #include "lorawan.h"
+#include "random_pool.h"
+#include "rtos_stats.h"
 
 #include "application_task.h"
 #include "console_task.h"
+#include "log_task.h"
 #include "lorawan_task.h"
 #include "ble_task.h"
 
+// Time the boot waited for the random pool to be seeded, in ms.
+static uint32_t random_pool_seed_time;
+
 //*****************************************************************************
 //
 // Sleep function called from FreeRTOS IDLE task.
@@ -58,6 +65,7 @@
 //*****************************************************************************
 uint32_t am_freertos_sleep(uint32_t idleTime)
 {
+    random_pool_sleep();
     am_hal_sysctrl_sleep(AM_HAL_SYSCTRL_SLEEP_DEEP);
     return 0;
 }
@@ -70,24 +78,29 @@ uint32_t am_freertos_sleep(uint32_t idleTime)
 //*****************************************************************************
 void am_freertos_wakeup(uint32_t idleTime)
 {
+    random_pool_wakeup();
 }
 
 void am_gpio_isr(void)
 {
     uint64_t ui64Status;
 
+    rtos_stats_isr_enter(RTOS_STATS_ISR_GPIO);
     am_hal_gpio_interrupt_status_get(true, &ui64Status);
     am_hal_gpio_interrupt_clear(ui64Status);
     am_hal_gpio_interrupt_service(ui64Status);
+    rtos_stats_isr_exit(RTOS_STATS_ISR_GPIO);
 }
 
 void am_ctimer_isr(void)
 {
     uint32_t ui32Status;
 
+    rtos_stats_isr_enter(RTOS_STATS_ISR_CTIMER);
     ui32Status = am_hal_ctimer_int_status_get(true);
     am_hal_ctimer_int_clear(ui32Status);
     am_hal_ctimer_int_service(ui32Status);
+    rtos_stats_isr_exit(RTOS_STATS_ISR_CTIMER);
 }
 
 //*****************************************************************************
@@ -154,12 +167,33 @@ void system_setup(void)
     NVIC_SetPriority(STIMER_CMPR4_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
     NVIC_SetPriority(STIMER_CMPR5_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
     NVIC_SetPriority(BLE_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
+    NVIC_SetPriority(CTIMER_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
 
     am_hal_interrupt_master_enable();
+
+    //
+    // Seed the random pool before the scheduler starts.  The entropy collector
+    // discards samples across a sleep, so the core stays awake for the
+    // RANDOM_POOL_SEED_SIZE samples, 10 ms each.  Nothing starts on an
+    // unseeded pool: random_pool_seeded() starts the collection again if it
+    // failed, and a wait longer than twice the expected one is logged once the
+    // log task runs.
+    //
+    random_pool_init();
+    while (!random_pool_seeded())
+    {
+        am_util_delay_ms(10);
+        random_pool_seed_time += 10;
+    }
 }
 
 void system_start(void)
 {
+    log_task_create(1);
+    if (random_pool_seed_time > 2 * 10 * RANDOM_POOL_SEED_SIZE)
+    {
+        DEFERRED_LOG("random pool: seeded after %d ms at boot\r\n", random_pool_seed_time);
+    }
     console_task_create(3);
     lorawan_task_create(2);
     ble_task_create(2);
@@ -34,6 +34,14 @@
 #include "util/calc128.h"
 #include "util/wstr.h"
 
+#ifndef SEC_RAND_CFG
+#define SEC_RAND_CFG SEC_RAND_CFG_HCI
+#endif
+
+#if SEC_RAND_CFG == SEC_RAND_CFG_PLATFORM
+#include "random_pool.h"
+#endif
+
 /**************************************************************************************************
   Global Variables
 **************************************************************************************************/
@@ -125,6 +133,7 @@ void SecInit(void)
 /*************************************************************************************************/
 void SecRandInit(void)
 {
+#if SEC_RAND_CFG == SEC_RAND_CFG_HCI
   int8_t i;
 
   /* get new random numbers */
@@ -132,6 +141,7 @@ void SecRandInit(void)
   {
     HciLeRandCmd();
   }
+#endif
 }
 
 /*************************************************************************************************/
@@ -147,6 +157,12 @@ void SecRandInit(void)
 /*************************************************************************************************/
 void SecRand(uint8_t *pRand, uint8_t randLen)
 {
+#if SEC_RAND_CFG == SEC_RAND_CFG_PLATFORM
+  WSF_ASSERT(randLen <= SEC_RAND_DATA_LEN);
+
+  /* Draw from the platform random pool, no HCI round trip to the controller. */
+  random_pool_get(pRand, randLen);
+#else
   int8_t count = (randLen + HCI_RAND_LEN - 1) / HCI_RAND_LEN;
   uint8_t index = secCb.randBtm * HCI_RAND_LEN;
 
@@ -167,6 +183,7 @@ void SecRand(uint8_t *pRand, uint8_t randLen)
     /* Update copy index. */
     secCb.randBtm = (secCb.randBtm >= SEC_HCI_RAND_MULT - 1) ? 0 : secCb.randBtm + 1;
   }
+#endif
 }
 
 /*************************************************************************************************/
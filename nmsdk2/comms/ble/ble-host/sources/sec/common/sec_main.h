@@ -56,6 +56,10 @@ extern "C" {
 #define SEC_CMAC_CFG_PLATFORM     0
 #define SEC_CMAC_CFG_HCI          1
 
+/*! Compile time random number configuration */
+#define SEC_RAND_CFG_HCI          0
+#define SEC_RAND_CFG_PLATFORM     1
+
 /*! Compile time CCM configuration */
 #define SEC_CCM_CFG_PLATFORM      0
 #define SEC_CCM_CFG_HCI           1
@@ -22,7 +22,11 @@
  */
 #include <stdlib.h>
 #include <stdio.h>
+#include "crc32_table.h"
 #include "utilities.h"
+#if defined( RANDOM_POOL_ENABLED )
+#include "random_pool.h"
+#endif
 
 /*!
  * Redefinition of rand() and srand() standard C functions.
@@ -32,6 +36,21 @@
 // Standard random functions redefinition start
 #define RAND_LOCAL_MAX 2147483647L
 
+#if defined( RANDOM_POOL_ENABLED )
+/*
+ * Draws from the entropy seeded random pool, the seed is only stirred into
+ * the pool and does not restart the sequence
+ */
+int32_t rand1( void )
+{
+    return ( int32_t )( random_pool_get_u32( ) % RAND_LOCAL_MAX );
+}
+
+void srand1( uint32_t seed )
+{
+    random_pool_add( ( uint8_t* )&seed, sizeof( seed ) );
+}
+#else
 static uint32_t next = 1;
 
 int32_t rand1( void )
@@ -43,6 +62,7 @@ void srand1( uint32_t seed )
 {
     next = seed;
 }
+#endif
 // Standard random functions redefinition end
 
 int32_t randr( int32_t min, int32_t max )
@@ -93,27 +113,13 @@ int8_t Nibble2HexChar( uint8_t a )
 
 uint32_t Crc32( uint8_t *buffer, uint16_t length )
 {
-    // The CRC calculation follows CCITT - 0x04C11DB7
-    const uint32_t reversedPolynom = 0xEDB88320;
-
-    // CRC initial value
-    uint32_t crc = 0xFFFFFFFF;
-
     if( buffer == NULL )
     {
         return 0;
     }
 
-    for( uint16_t i = 0; i < length; ++i )
-    {
-        crc ^= ( uint32_t )buffer[i];
-        for( uint16_t i = 0; i < 8; i++ )
-        {
-            crc = ( crc >> 1 ) ^ ( reversedPolynom & ~( ( crc & 0x01 ) - 1 ) );
-        }
-    }
-
-    return ~crc;
+    // The CRC calculation follows CCITT - 0x04C11DB7
+    return ~crc32_update( 0xFFFFFFFF, buffer, length );
 }
 
 uint32_t Crc32Init( void )
@@ -123,26 +129,12 @@ uint32_t Crc32Init( void )
 
 uint32_t Crc32Update( uint32_t crcInit, uint8_t *buffer, uint16_t length )
 {
-    // The CRC calculation follows CCITT - 0x04C11DB7
-    const uint32_t reversedPolynom = 0xEDB88320;
-
-    // CRC initial value
-    uint32_t crc = crcInit;
-
     if( buffer == NULL )
     {
         return 0;
     }
 
-    for( uint16_t i = 0; i < length; ++i )
-    {
-        crc ^= ( uint32_t )buffer[i];
-        for( uint16_t i = 0; i < 8; i++ )
-        {
-            crc = ( crc >> 1 ) ^ ( reversedPolynom & ~( ( crc & 0x01 ) - 1 ) );
-        }
-    }
-    return crc;
+    return crc32_update( crcInit, buffer, length );
 }
 
 uint32_t Crc32Finalize( uint32_t crc )
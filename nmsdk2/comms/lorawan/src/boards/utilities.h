@@ -87,6 +87,9 @@ typedef union Version_u
 /*!
  * \brief Initializes the pseudo random generator initial value
  *
+ * \remark When RANDOM_POOL_ENABLED is defined, the numbers come from the
+ *         entropy seeded random pool and the seed is only mixed into it
+ *
  * \param [IN] seed Pseudo random generator initial value
  */
 void srand1( uint32_t seed );
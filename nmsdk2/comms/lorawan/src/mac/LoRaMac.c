@@ -3805,8 +3805,10 @@ LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t* primitives, LoRaMacC
         return LORAMAC_STATUS_CRYPTO_ERROR;
     }
 
+#if !defined( RANDOM_POOL_ENABLED )
     // Random seed initialization
     srand1( Radio.Random( ) );
+#endif
 
     Radio.SetPublicNetwork( Nvm.MacGroup2.PublicNetwork );
     Radio.Sleep( );
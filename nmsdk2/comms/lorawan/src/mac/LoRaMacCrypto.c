@@ -136,9 +136,6 @@ static LoRaMacCryptoStatus_t PayloadEncrypt( uint8_t* buffer, int16_t size, KeyI
         return LORAMAC_CRYPTO_ERROR_NPE;
     }
 
-    uint8_t bufferIndex = 0;
-    uint16_t ctr = 1;
-    uint8_t sBlock[16] = { 0 };
     uint8_t aBlock[16] = { 0 };
 
     aBlock[0] = 0x01;
@@ -155,21 +152,14 @@ static LoRaMacCryptoStatus_t PayloadEncrypt( uint8_t* buffer, int16_t size, KeyI
     aBlock[12] = ( frameCounter >> 16 ) & 0xFF;
     aBlock[13] = ( frameCounter >> 24 ) & 0xFF;
 
-    while( size > 0 )
+    aBlock[15] = 0x01;
+
+    if( size > 0 )
     {
-        aBlock[15] = ctr & 0xFF;
-        ctr++;
-        if( SecureElementAesEncrypt( aBlock, 16, keyID, sBlock ) != SECURE_ELEMENT_SUCCESS )
+        if( SecureElementAesCtrXor( aBlock, buffer, size, keyID ) != SECURE_ELEMENT_SUCCESS )
         {
             return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
         }
-
-        for( uint8_t i = 0; i < ( ( size > 16 ) ? 16 : size ); i++ )
-        {
-            buffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
-        }
-        size -= 16;
-        bufferIndex += 16;
     }
 
     return LORAMAC_CRYPTO_SUCCESS;
@@ -194,8 +184,6 @@ static LoRaMacCryptoStatus_t FOptsEncrypt( uint16_t size, uint32_t address, uint
         return LORAMAC_CRYPTO_ERROR_NPE;
     }
 
-    uint8_t bufferIndex = 0;
-    uint8_t sBlock[16] = { 0 };
     uint8_t aBlock[16] = { 0 };
 
     aBlock[0] = 0x01;
@@ -245,14 +233,10 @@ static LoRaMacCryptoStatus_t FOptsEncrypt( uint16_t size, uint32_t address, uint
 
     if( size > 0 )
     {
-        if( SecureElementAesEncrypt( aBlock, 16, NWK_S_ENC_KEY, sBlock ) != SECURE_ELEMENT_SUCCESS )
+        if( SecureElementAesCtrXor( aBlock, buffer, size, NWK_S_ENC_KEY ) != SECURE_ELEMENT_SUCCESS )
         {
             return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
         }
-        for( uint8_t i = 0; i < size; i++ )
-        {
-            buffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
-        }
     }
 
     return LORAMAC_CRYPTO_SUCCESS;
@@ -464,24 +448,25 @@ static LoRaMacCryptoStatus_t PrepareB1( uint16_t msgLen, KeyIdentifier_t keyID,
 }
 
 /*
- * Computes cmac with adding B1 block in front ( only for Uplink frames LoRaWAN 1.1 )
+ * Computes the two cmacs of a LoRaWAN 1.1 uplink in a single pass over the message
  *
- *  cmac = aes128_cmac(keyID, B1 | msg)
+ *  cmacS = aes128_cmac(SNwkSIntKey, B1 | msg)
+ *  cmacF = aes128_cmac(FNwkSIntKey, B0 | msg)
  *
  * \param[IN]  msg            - Message to calculate the Integrity code
  * \param[IN]  len            - Length of message
- * \param[IN]  keyID          - Key identifier
  * \param[IN]  isAck          - True if it is a acknowledge frame ( Sets ConfFCnt in B0 block )
  * \param[IN]  txDr           - Data rate used for the transmission
  * \param[IN]  txCh           - Index of the channel used for the transmission
  * \param[IN]  devAddr        - Device address
  * \param[IN]  fCntUp         - Uplink Frame counter
- * \param[OUT] cmac           - Computed cmac
+ * \param[OUT] cmacS          - Computed cmac with the B1 block
+ * \param[OUT] cmacF          - Computed cmac with the B0 block
  * \retval                    - Status of the operation
  */
-static LoRaMacCryptoStatus_t ComputeCmacB1( uint8_t* msg, uint16_t len, KeyIdentifier_t keyID, bool isAck, uint8_t txDr, uint8_t txCh, uint32_t devAddr, uint32_t fCntUp, uint32_t* cmac )
+static LoRaMacCryptoStatus_t ComputeCmacB1B0( uint8_t* msg, uint16_t len, bool isAck, uint8_t txDr, uint8_t txCh, uint32_t devAddr, uint32_t fCntUp, uint32_t* cmacS, uint32_t* cmacF )
 {
-    if( ( msg == 0 ) || ( cmac == 0 ) )
+    if( ( msg == 0 ) || ( cmacS == 0 ) || ( cmacF == 0 ) )
     {
         return LORAMAC_CRYPTO_ERROR_NPE;
     }
@@ -490,12 +475,14 @@ static LoRaMacCryptoStatus_t ComputeCmacB1( uint8_t* msg, uint16_t len, KeyIdent
         return LORAMAC_CRYPTO_ERROR_BUF_SIZE;
     }
 
-    uint8_t micBuff[MIC_BLOCK_BX_SIZE];
+    uint8_t micBuffB1[MIC_BLOCK_BX_SIZE];
+    uint8_t micBuffB0[MIC_BLOCK_BX_SIZE];
 
-    // Initialize the first Block
-    PrepareB1( len, keyID, isAck, txDr, txCh, devAddr, fCntUp, micBuff );
+    // Initialize the first Blocks
+    PrepareB1( len, S_NWK_S_INT_KEY, isAck, txDr, txCh, devAddr, fCntUp, micBuffB1 );
+    PrepareB0( len, F_NWK_S_INT_KEY, isAck, UPLINK, devAddr, fCntUp, micBuffB0 );
 
-    if( SecureElementComputeAesCmac( micBuff, msg, len, keyID, cmac ) != SECURE_ELEMENT_SUCCESS )
+    if( SecureElementComputeAesCmacPair( micBuffB1, micBuffB0, msg, len, S_NWK_S_INT_KEY, F_NWK_S_INT_KEY, cmacS, cmacF ) != SECURE_ELEMENT_SUCCESS )
     {
         return LORAMAC_CRYPTO_ERROR_SECURE_ELEMENT_FUNC;
     }
@@ -1341,13 +1328,8 @@ LoRaMacCryptoStatus_t LoRaMacCryptoSecureMessage( uint32_t fCntUp, uint8_t txDr,
         uint32_t cmacF = 0;
 
         // cmacS  = aes128_cmac(SNwkSIntKey, B1 | msg)
-        retval = ComputeCmacB1( macMsg->Buffer, ( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE ), S_NWK_S_INT_KEY, macMsg->FHDR.FCtrl.Bits.Ack, txDr, txCh, macMsg->FHDR.DevAddr, fCntUp, &cmacS );
-        if( retval != LORAMAC_CRYPTO_SUCCESS )
-        {
-            return retval;
-        }
-        //cmacF = aes128_cmac(FNwkSIntKey, B0 | msg)
-        retval = ComputeCmacB0( macMsg->Buffer, ( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE ), F_NWK_S_INT_KEY, macMsg->FHDR.FCtrl.Bits.Ack, UPLINK, macMsg->FHDR.DevAddr, fCntUp, &cmacF );
+        // cmacF = aes128_cmac(FNwkSIntKey, B0 | msg)
+        retval = ComputeCmacB1B0( macMsg->Buffer, ( macMsg->BufSize - LORAMAC_MIC_FIELD_SIZE ), macMsg->FHDR.FCtrl.Bits.Ack, txDr, txCh, macMsg->FHDR.DevAddr, fCntUp, &cmacS, &cmacF );
         if( retval != LORAMAC_CRYPTO_SUCCESS )
         {
             return retval;
@@ -116,6 +116,27 @@ SecureElementStatus_t SecureElementSetKey( KeyIdentifier_t keyID, uint8_t* key )
  */
 SecureElementStatus_t SecureElementComputeAesCmac( uint8_t* micBxBuffer, uint8_t* buffer, uint16_t size, KeyIdentifier_t keyID, uint32_t* cmac );
 
+/*!
+ * Computes the CMACs of a message with two keys and initial Bx blocks, as the
+ * B1 and B0 MICs of a LoRaWAN 1.1 uplink
+ *
+ *  cmac0 = aes128_cmac(keyID0, micBxBuffer0 | buffer)
+ *  cmac1 = aes128_cmac(keyID1, micBxBuffer1 | buffer)
+ *
+ * \param[IN]  micBxBuffer0   - Buffer containing the initial Bx block of cmac0
+ * \param[IN]  micBxBuffer1   - Buffer containing the initial Bx block of cmac1
+ * \param[IN]  buffer         - Data buffer
+ * \param[IN]  size           - Data buffer size
+ * \param[IN]  keyID0         - Key identifier of cmac0
+ * \param[IN]  keyID1         - Key identifier of cmac1
+ * \param[OUT] cmac0          - Computed cmac with keyID0
+ * \param[OUT] cmac1          - Computed cmac with keyID1
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t SecureElementComputeAesCmacPair( uint8_t* micBxBuffer0, uint8_t* micBxBuffer1, uint8_t* buffer,
+                                                       uint16_t size, KeyIdentifier_t keyID0, KeyIdentifier_t keyID1,
+                                                       uint32_t* cmac0, uint32_t* cmac1 );
+
 /*!
  * Verifies a CMAC (computes and compare with expected cmac)
  *
@@ -138,6 +159,21 @@ SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t* buffer, uint16_t size
  */
 SecureElementStatus_t SecureElementAesEncrypt( uint8_t* buffer, uint16_t size, KeyIdentifier_t keyID, uint8_t* encBuffer );
 
+/*!
+ * Encrypts or decrypts a buffer in place in AES-CTR mode
+ *
+ * The counter block of the first 16 bytes is aBlock. The counter of each
+ * following block is aBlock[15] incremented by one, as for the LoRaWAN
+ * FRMPayload and FOpts A blocks.
+ *
+ * \param[IN]  aBlock         - First counter block ( 16 byte ), left unchanged
+ * \param[IN/OUT] buffer      - Data buffer
+ * \param[IN]  size           - Data buffer size, need not be a multiple of 16
+ * \param[IN]  keyID          - Key identifier to determine the AES key to be used
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t SecureElementAesCtrXor( uint8_t* aBlock, uint8_t* buffer, uint16_t size, KeyIdentifier_t keyID );
+
 /*!
  * Derives and store a key
  *
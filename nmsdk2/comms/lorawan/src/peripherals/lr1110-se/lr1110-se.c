@@ -171,6 +171,19 @@ SecureElementStatus_t SecureElementComputeAesCmac( uint8_t* micBxBuffer, uint8_t
     return status;
 }
 
+SecureElementStatus_t SecureElementComputeAesCmacPair( uint8_t* micBxBuffer0, uint8_t* micBxBuffer1, uint8_t* buffer,
+                                                       uint16_t size, KeyIdentifier_t keyID0, KeyIdentifier_t keyID1,
+                                                       uint32_t* cmac0, uint32_t* cmac1 )
+{
+    SecureElementStatus_t retval = SecureElementComputeAesCmac( micBxBuffer0, buffer, size, keyID0, cmac0 );
+
+    if( retval == SECURE_ELEMENT_SUCCESS )
+    {
+        retval = SecureElementComputeAesCmac( micBxBuffer1, buffer, size, keyID1, cmac1 );
+    }
+    return retval;
+}
+
 SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t* buffer, uint16_t size, uint32_t expectedCmac,
                                                   KeyIdentifier_t keyID )
 {
@@ -204,6 +217,48 @@ SecureElementStatus_t SecureElementAesEncrypt( uint8_t* buffer, uint16_t size, K
     return status;
 }
 
+SecureElementStatus_t SecureElementAesCtrXor( uint8_t* aBlock, uint8_t* buffer, uint16_t size, KeyIdentifier_t keyID )
+{
+    SecureElementStatus_t status = SECURE_ELEMENT_SUCCESS;
+    uint8_t               ctr    = 0;
+
+    if( ( aBlock == NULL ) || ( buffer == NULL ) )
+    {
+        return SECURE_ELEMENT_ERROR_NPE;
+    }
+
+    while( size > 0 )
+    {
+        uint8_t  ctrBuff[CRYPTO_MAXMESSAGE_SIZE];
+        uint8_t  sBuff[CRYPTO_MAXMESSAGE_SIZE];
+        uint16_t n         = ( size > CRYPTO_MAXMESSAGE_SIZE ) ? CRYPTO_MAXMESSAGE_SIZE : size;
+        uint16_t blockSize = ( n + 15 ) & ~15;
+
+        // All counter blocks of the chunk are encrypted by a single command
+        for( uint16_t i = 0; i < blockSize; i += 16 )
+        {
+            memcpy1( ctrBuff + i, aBlock, 15 );
+            ctrBuff[i + 15] = aBlock[15] + ctr++;
+        }
+
+        lr1110_crypto_aes_encrypt_01( &LR1110, ( lr1110_crypto_status_t* ) &status,
+                                      convert_key_id_from_se_to_lr1110( keyID ), ctrBuff, blockSize, sBuff );
+        if( status != SECURE_ELEMENT_SUCCESS )
+        {
+            return status;
+        }
+
+        for( uint16_t i = 0; i < n; i++ )
+        {
+            buffer[i] ^= sBuff[i];
+        }
+        buffer += n;
+        size -= n;
+    }
+
+    return status;
+}
+
 SecureElementStatus_t SecureElementDeriveAndStoreKey( uint8_t* input, KeyIdentifier_t rootKeyID,
                                                       KeyIdentifier_t targetKeyID )
 {
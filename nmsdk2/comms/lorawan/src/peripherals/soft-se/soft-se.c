@@ -206,6 +206,19 @@ SecureElementStatus_t SecureElementComputeAesCmac( uint8_t* micBxBuffer, uint8_t
     return ComputeCmac( micBxBuffer, buffer, size, keyID, cmac );
 }
 
+SecureElementStatus_t SecureElementComputeAesCmacPair( uint8_t* micBxBuffer0, uint8_t* micBxBuffer1, uint8_t* buffer,
+                                                       uint16_t size, KeyIdentifier_t keyID0, KeyIdentifier_t keyID1,
+                                                       uint32_t* cmac0, uint32_t* cmac1 )
+{
+    SecureElementStatus_t retval = SecureElementComputeAesCmac( micBxBuffer0, buffer, size, keyID0, cmac0 );
+
+    if( retval == SECURE_ELEMENT_SUCCESS )
+    {
+        retval = SecureElementComputeAesCmac( micBxBuffer1, buffer, size, keyID1, cmac1 );
+    }
+    return retval;
+}
+
 SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t* buffer, uint16_t size, uint32_t expectedCmac,
                                                   KeyIdentifier_t keyID )
 {
@@ -266,6 +279,46 @@ SecureElementStatus_t SecureElementAesEncrypt( uint8_t* buffer, uint16_t size, K
     return retval;
 }
 
+SecureElementStatus_t SecureElementAesCtrXor( uint8_t* aBlock, uint8_t* buffer, uint16_t size, KeyIdentifier_t keyID )
+{
+    if( aBlock == NULL || buffer == NULL )
+    {
+        return SECURE_ELEMENT_ERROR_NPE;
+    }
+
+    aes_context aesContext;
+    memset1( aesContext.ksch, '\0', 240 );
+
+    Key_t*                pItem;
+    SecureElementStatus_t retval = GetKeyByID( keyID, &pItem );
+
+    if( retval == SECURE_ELEMENT_SUCCESS )
+    {
+        uint8_t ctrBlock[16];
+        uint8_t sBlock[16];
+
+        // The key is expanded once for the whole buffer
+        aes_set_key( pItem->KeyValue, 16, &aesContext );
+        memcpy1( ctrBlock, aBlock, 16 );
+
+        while( size > 0 )
+        {
+            uint16_t n = ( size > 16 ) ? 16 : size;
+
+            aes_encrypt( ctrBlock, sBlock, &aesContext );
+            ctrBlock[15]++;
+
+            for( uint16_t i = 0; i < n; i++ )
+            {
+                buffer[i] ^= sBlock[i];
+            }
+            buffer += n;
+            size -= n;
+        }
+    }
+    return retval;
+}
+
 SecureElementStatus_t SecureElementDeriveAndStoreKey( uint8_t* input, KeyIdentifier_t rootKeyID,
                                                       KeyIdentifier_t targetKeyID )
 {
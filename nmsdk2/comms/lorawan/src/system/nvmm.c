@@ -29,6 +29,13 @@
 #include "eeprom-board.h"
 #include "nvmm.h"
 
+/*!
+ * Size of the blocks read from the NVM when verifying a CRC32
+ */
+#ifndef NVMM_CRC32_BLOCK_SIZE
+#define NVMM_CRC32_BLOCK_SIZE                       64
+#endif
+
 uint16_t NvmmWrite( uint8_t* src, uint16_t size, uint16_t offset )
 {
     if( EepromMcuWriteBuffer( offset, src, size ) == LMN_STATUS_OK )
@@ -49,22 +56,24 @@ uint16_t NvmmRead( uint8_t* dest, uint16_t size, uint16_t offset )
 
 bool NvmmCrc32Check( uint16_t size, uint16_t offset )
 {
-    uint8_t data = 0;
+    uint8_t data[NVMM_CRC32_BLOCK_SIZE];
+    uint16_t length = 0;
     uint32_t calculatedCrc32 = 0;
     uint32_t readCrc32 = 0;
 
     if( NvmmRead( ( uint8_t* ) &readCrc32, sizeof( readCrc32 ),
                   ( offset + ( size - sizeof( readCrc32 ) ) ) ) == sizeof( readCrc32 ) )
     {
-        // Calculate crc
+        // Calculate crc, streaming the data through a block sized buffer
         calculatedCrc32 = Crc32Init( );
-        for( uint16_t i = 0; i < ( size - sizeof( readCrc32 ) ); i++ )
+        for( uint16_t i = 0; i < ( size - sizeof( readCrc32 ) ); i += length )
         {
-            if( NvmmRead( &data, 1, offset + i ) != 1 )
+            length = MIN( ( size - sizeof( readCrc32 ) ) - i, sizeof( data ) );
+            if( NvmmRead( data, length, offset + i ) != length )
             {
                 return false;
             }
-            calculatedCrc32 = Crc32Update( calculatedCrc32, &data, 1 );
+            calculatedCrc32 = Crc32Update( calculatedCrc32, data, length );
         }
         calculatedCrc32 = Crc32Finalize( calculatedCrc32 );
 
@@ -42,56 +42,87 @@
     }while( 0 );
 
 /*!
- * Timers list head pointer
+ * Root of the timer heap, the next timer to expire
+ *
+ * \remark The started timers form a pairing heap ordered by their absolute
+ *         expiry time, so that starting a timer is O(1) and stopping or
+ *         expiring one is O(log n) amortized.
+ */
+static TimerEvent_t *TimerHeapRoot = NULL;
+
+/*!
+ * Number of timers which expired in the same TimerIrqHandler call as a
+ * previous one
  */
-static TimerEvent_t *TimerListHead = NULL;
+static uint32_t TimerSavedWakeups = 0;
 
 /*!
- * \brief Adds or replace the head timer of the list.
+ * \brief Checks if a timer expires before another one
  *
- * \remark The list is automatically sorted. The list head always contains the
- *         next timer to expire.
+ * \remark Expiry times are compared modulo 2^32, timeouts must stay below
+ *         2^31 ticks.
+ *
+ * \param [IN] a Timer object
+ * \param [IN] b Timer object
+ * \retval true if a expires before b
+ */
+static bool TimerIsBefore( TimerEvent_t *a, TimerEvent_t *b );
+
+/*!
+ * \brief Merges two timer heaps
  *
- * \param [IN]  obj Timer object to be become the new head
- * \param [IN]  remainingTime Remaining time of the previous head to be replaced
+ * \param [IN] a Root of the first heap, may be NULL
+ * \param [IN] b Root of the second heap, may be NULL
+ * \retval Root of the merged heap
  */
-static void TimerInsertNewHeadTimer( TimerEvent_t *obj );
+static TimerEvent_t* TimerHeapMerge( TimerEvent_t *a, TimerEvent_t *b );
 
 /*!
- * \brief Adds a timer to the list.
+ * \brief Merges a list of sibling heaps in two passes
  *
- * \remark The list is automatically sorted. The list head always contains the
- *         next timer to expire.
+ * \param [IN] first First heap of the list, may be NULL
+ * \retval Root of the merged heap
+ */
+static TimerEvent_t* TimerHeapMergePairs( TimerEvent_t *first );
+
+/*!
+ * \brief Removes a timer from the heap
  *
- * \param [IN]  obj Timer object to be added to the list
- * \param [IN]  remainingTime Remaining time of the running head after which the object may be added
+ * \param [IN] obj Timer object to be removed, must be in the heap
  */
-static void TimerInsertTimer( TimerEvent_t *obj );
+static void TimerHeapRemove( TimerEvent_t *obj );
 
 /*!
- * \brief Sets a timeout with the duration "timestamp"
+ * \brief Computes how much later than its nominal expiry time a timer expires
  *
- * \param [IN] timestamp Delay duration
+ * \remark The latest tolerated expiry time is rounded down on the most
+ *         significant bit which differs from the nominal one.
+ *
+ * \param [IN] obj       Timer object
+ * \param [IN] timestamp Nominal expiry time in RTC ticks
+ * \retval Expiry delay in RTC ticks
  */
-static void TimerSetTimeout( TimerEvent_t *obj );
+static uint32_t TimerGetSlackDelay( TimerEvent_t *obj, uint32_t timestamp );
 
 /*!
- * \brief Check if the Object to be added is not already in the list
+ * \brief Sets the alarm for the expiry time of a timer
  *
- * \param [IN] timestamp Delay duration
- * \retval true (the object is already in the list) or false
+ * \param [IN] obj Timer object at the root of the heap
  */
-static bool TimerExists( TimerEvent_t *obj );
+static void TimerSetTimeout( TimerEvent_t *obj );
 
 void TimerInit( TimerEvent_t *obj, void ( *callback )( void *context ) )
 {
     obj->Timestamp = 0;
     obj->ReloadValue = 0;
+    obj->Slack = 0;
     obj->IsStarted = false;
     obj->IsNext2Expire = false;
     obj->Callback = callback;
     obj->Context = NULL;
     obj->Next = NULL;
+    obj->Child = NULL;
+    obj->Prev = NULL;
 }
 
 void TimerSetContext( TimerEvent_t *obj, void* context )
@@ -101,78 +132,174 @@ void TimerSetContext( TimerEvent_t *obj, void* context )
 
 void TimerStart( TimerEvent_t *obj )
 {
-    uint32_t elapsedTime = 0;
+    TimerEvent_t* root;
 
     CRITICAL_SECTION_BEGIN( );
 
-    if( ( obj == NULL ) || ( TimerExists( obj ) == true ) )
+    if( ( obj == NULL ) || ( obj->IsStarted == true ) )
     {
         CRITICAL_SECTION_END( );
         return;
     }
 
-    obj->Timestamp = obj->ReloadValue;
+    obj->Timestamp = RtcGetTimerValue( ) + obj->ReloadValue;
+    obj->Timestamp += TimerGetSlackDelay( obj, obj->Timestamp );
     obj->IsStarted = true;
     obj->IsNext2Expire = false;
+    obj->Next = NULL;
+    obj->Child = NULL;
+    obj->Prev = NULL;
 
-    if( TimerListHead == NULL )
-    {
-        RtcSetTimerContext( );
-        // Inserts a timer at time now + obj->Timestamp
-        TimerInsertNewHeadTimer( obj );
-    }
-    else
-    {
-        elapsedTime = RtcGetTimerElapsedTime( );
-        obj->Timestamp += elapsedTime;
+    root = TimerHeapRoot;
+    TimerHeapRoot = TimerHeapMerge( root, obj );
 
-        if( obj->Timestamp < TimerListHead->Timestamp )
-        {
-            TimerInsertNewHeadTimer( obj );
-        }
-        else
+    if( TimerHeapRoot == obj )
+    {
+        if( root != NULL )
         {
-            TimerInsertTimer( obj );
+            root->IsNext2Expire = false;
         }
+        TimerSetTimeout( obj );
     }
     CRITICAL_SECTION_END( );
 }
 
-static void TimerInsertTimer( TimerEvent_t *obj )
+static uint32_t TimerGetSlackDelay( TimerEvent_t *obj, uint32_t timestamp )
 {
-    TimerEvent_t* cur = TimerListHead;
-    TimerEvent_t* next = TimerListHead->Next;
+    uint32_t slack = obj->Slack;
+    uint32_t latest;
+    uint32_t mask;
+    uint32_t bit = 1;
 
-    while( cur->Next != NULL )
+    // Expiry times are compared modulo 2^32
+    if( slack > ( ( uint32_t )INT32_MAX - obj->ReloadValue ) )
     {
-        if( obj->Timestamp > next->Timestamp )
-        {
-            cur = next;
-            next = next->Next;
-        }
-        else
+        slack = ( uint32_t )INT32_MAX - obj->ReloadValue;
+    }
+
+    latest = timestamp + slack;
+    // No alignment across the wrap around of the RTC ticks
+    if( ( slack == 0 ) || ( latest < timestamp ) )
+    {
+        return 0;
+    }
+
+    mask = timestamp ^ latest;
+    while( ( mask >>= 1 ) != 0 )
+    {
+        bit <<= 1;
+    }
+    return ( latest & ~( bit - 1 ) ) - timestamp;
+}
+
+static bool TimerIsBefore( TimerEvent_t *a, TimerEvent_t *b )
+{
+    // intentional wrap around
+    return ( int32_t )( a->Timestamp - b->Timestamp ) < 0;
+}
+
+static TimerEvent_t* TimerHeapMerge( TimerEvent_t *a, TimerEvent_t *b )
+{
+    TimerEvent_t* tmp;
+
+    if( a == NULL )
+    {
+        return b;
+    }
+    if( b == NULL )
+    {
+        return a;
+    }
+
+    if( TimerIsBefore( b, a ) == true )
+    {
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    // b becomes the first child of a
+    b->Prev = a;
+    b->Next = a->Child;
+    if( a->Child != NULL )
+    {
+        a->Child->Prev = b;
+    }
+    a->Child = b;
+    a->Next = NULL;
+    a->Prev = NULL;
+
+    return a;
+}
+
+static TimerEvent_t* TimerHeapMergePairs( TimerEvent_t *first )
+{
+    TimerEvent_t* pairs = NULL;
+    TimerEvent_t* root = NULL;
+    TimerEvent_t* a;
+    TimerEvent_t* b;
+
+    // Merges the siblings pairwise from left to right, the pairs are kept in
+    // reverse order
+    while( first != NULL )
+    {
+        a = first;
+        b = a->Next;
+        first = ( b != NULL ) ? b->Next : NULL;
+
+        a->Next = NULL;
+        a->Prev = NULL;
+        if( b != NULL )
         {
-            cur->Next = obj;
-            obj->Next = next;
-            return;
+            b->Next = NULL;
+            b->Prev = NULL;
         }
+        a = TimerHeapMerge( a, b );
+        a->Next = pairs;
+        pairs = a;
     }
-    cur->Next = obj;
-    obj->Next = NULL;
+
+    // Merges the pairs from right to left
+    while( pairs != NULL )
+    {
+        a = pairs;
+        pairs = pairs->Next;
+        a->Next = NULL;
+        root = TimerHeapMerge( a, root );
+    }
+
+    return root;
 }
 
-static void TimerInsertNewHeadTimer( TimerEvent_t *obj )
+static void TimerHeapRemove( TimerEvent_t *obj )
 {
-    TimerEvent_t* cur = TimerListHead;
+    TimerEvent_t* children = TimerHeapMergePairs( obj->Child );
 
-    if( cur != NULL )
+    if( obj == TimerHeapRoot )
     {
-        cur->IsNext2Expire = false;
+        TimerHeapRoot = children;
+    }
+    else
+    {
+        // Unlinks obj from its parent or from its previous sibling
+        if( obj->Prev->Child == obj )
+        {
+            obj->Prev->Child = obj->Next;
+        }
+        else
+        {
+            obj->Prev->Next = obj->Next;
+        }
+        if( obj->Next != NULL )
+        {
+            obj->Next->Prev = obj->Prev;
+        }
+        TimerHeapRoot = TimerHeapMerge( TimerHeapRoot, children );
     }
 
-    obj->Next = cur;
-    TimerListHead = obj;
-    TimerSetTimeout( TimerListHead );
+    obj->Next = NULL;
+    obj->Child = NULL;
+    obj->Prev = NULL;
 }
 
 bool TimerIsStarted( TimerEvent_t *obj )
@@ -183,142 +310,65 @@ bool TimerIsStarted( TimerEvent_t *obj )
 void TimerIrqHandler( void )
 {
     TimerEvent_t* cur;
-    TimerEvent_t* next;
-
-    uint32_t old =  RtcGetTimerContext( );
-    uint32_t now =  RtcSetTimerContext( );
-    uint32_t deltaContext = now - old; // intentional wrap around
+    bool isFirst = true;
 
-    // Update timeStamp based upon new Time Reference
-    // because delta context should never exceed 2^32
-    if( TimerListHead != NULL )
+    // Execute all the expired timers, callbacks may start or stop timers
+    while( ( TimerHeapRoot != NULL ) &&
+           ( ( int32_t )( TimerHeapRoot->Timestamp - RtcGetTimerValue( ) ) <= 0 ) )
     {
-        for( cur = TimerListHead; cur->Next != NULL; cur = cur->Next )
+        if( isFirst == false )
         {
-            next = cur->Next;
-            if( next->Timestamp > deltaContext )
-            {
-                next->Timestamp -= deltaContext;
-            }
-            else
-            {
-                next->Timestamp = 0;
-            }
+            TimerSavedWakeups++;
         }
-    }
+        isFirst = false;
 
-    // Execute immediately the alarm callback
-    if ( TimerListHead != NULL )
-    {
-        cur = TimerListHead;
-        TimerListHead = TimerListHead->Next;
-        cur->IsStarted = false;
-        ExecuteCallBack( cur->Callback, cur->Context );
-    }
-
-    // Remove all the expired object from the list
-    while( ( TimerListHead != NULL ) && ( TimerListHead->Timestamp < RtcGetTimerElapsedTime( ) ) )
-    {
-        cur = TimerListHead;
-        TimerListHead = TimerListHead->Next;
+        cur = TimerHeapRoot;
+        TimerHeapRemove( cur );
         cur->IsStarted = false;
+        cur->IsNext2Expire = false;
         ExecuteCallBack( cur->Callback, cur->Context );
     }
 
-    // Start the next TimerListHead if it exists AND NOT running
-    if( ( TimerListHead != NULL ) && ( TimerListHead->IsNext2Expire == false ) )
+    // Start the next TimerHeapRoot if it exists AND NOT running
+    if( ( TimerHeapRoot != NULL ) && ( TimerHeapRoot->IsNext2Expire == false ) )
     {
-        TimerSetTimeout( TimerListHead );
+        TimerSetTimeout( TimerHeapRoot );
     }
 }
 
 void TimerStop( TimerEvent_t *obj )
 {
-    CRITICAL_SECTION_BEGIN( );
+    bool isNext2Expire;
 
-    TimerEvent_t* prev = TimerListHead;
-    TimerEvent_t* cur = TimerListHead;
+    CRITICAL_SECTION_BEGIN( );
 
-    // List is empty or the obj to stop does not exist
-    if( ( TimerListHead == NULL ) || ( obj == NULL ) )
+    // The obj to stop is not in the heap
+    if( ( obj == NULL ) || ( obj->IsStarted == false ) )
     {
         CRITICAL_SECTION_END( );
         return;
     }
 
+    isNext2Expire = obj->IsNext2Expire;
+
+    TimerHeapRemove( obj );
     obj->IsStarted = false;
+    obj->IsNext2Expire = false;
 
-    if( TimerListHead == obj ) // Stop the Head
+    if( isNext2Expire == true ) // The root was running
     {
-        if( TimerListHead->IsNext2Expire == true ) // The head is already running
-        {
-            TimerListHead->IsNext2Expire = false;
-            if( TimerListHead->Next != NULL )
-            {
-                TimerListHead = TimerListHead->Next;
-                TimerSetTimeout( TimerListHead );
-            }
-            else
-            {
-                RtcStopAlarm( );
-                TimerListHead = NULL;
-            }
-        }
-        else // Stop the head before it is started
+        if( TimerHeapRoot != NULL )
         {
-            if( TimerListHead->Next != NULL )
-            {
-                TimerListHead = TimerListHead->Next;
-            }
-            else
-            {
-                TimerListHead = NULL;
-            }
+            TimerSetTimeout( TimerHeapRoot );
         }
-    }
-    else // Stop an object within the list
-    {
-        while( cur != NULL )
+        else
         {
-            if( cur == obj )
-            {
-                if( cur->Next != NULL )
-                {
-                    cur = cur->Next;
-                    prev->Next = cur;
-                }
-                else
-                {
-                    cur = NULL;
-                    prev->Next = cur;
-                }
-                break;
-            }
-            else
-            {
-                prev = cur;
-                cur = cur->Next;
-            }
+            RtcStopAlarm( );
         }
     }
     CRITICAL_SECTION_END( );
 }
 
-static bool TimerExists( TimerEvent_t *obj )
-{
-    TimerEvent_t* cur = TimerListHead;
-
-    while( cur != NULL )
-    {
-        if( cur == obj )
-        {
-            return true;
-        }
-        cur = cur->Next;
-    }
-    return false;
-}
-
 void TimerReset( TimerEvent_t *obj )
 {
     TimerStop( obj );
@@ -338,11 +388,26 @@ void TimerSetValue( TimerEvent_t *obj, uint32_t value )
     {
         ticks = minValue;
     }
+    // Expiry times are compared modulo 2^32
+    if( ticks > ( uint32_t )INT32_MAX )
+    {
+        ticks = ( uint32_t )INT32_MAX;
+    }
 
     obj->Timestamp = ticks;
     obj->ReloadValue = ticks;
 }
 
+void TimerSetSlack( TimerEvent_t *obj, uint32_t value )
+{
+    obj->Slack = RtcMs2Tick( value );
+}
+
+uint32_t TimerGetSavedWakeups( void )
+{
+    return TimerSavedWakeups;
+}
+
 TimerTime_t TimerGetCurrentTime( void )
 {
     uint32_t now = RtcGetTimerValue( );
@@ -364,15 +429,18 @@ TimerTime_t TimerGetElapsedTime( TimerTime_t past )
 
 static void TimerSetTimeout( TimerEvent_t *obj )
 {
-    int32_t minTicks= RtcGetMinimumTimeout( );
+    uint32_t minTicks = RtcGetMinimumTimeout( );
+    uint32_t now = RtcSetTimerContext( );
+    uint32_t timeout = obj->Timestamp - now; // intentional wrap around
+
     obj->IsNext2Expire = true;
 
     // In case deadline too soon
-    if( obj->Timestamp  < ( RtcGetTimerElapsedTime( ) + minTicks ) )
+    if( ( ( int32_t )timeout < 0 ) || ( timeout < minTicks ) )
     {
-        obj->Timestamp = RtcGetTimerElapsedTime( ) + minTicks;
+        timeout = minTicks;
     }
-    RtcSetAlarm( obj->Timestamp );
+    RtcSetAlarm( timeout );
 }
 
 TimerTime_t TimerTempCompensation( TimerTime_t period, float temperature )
@@ -37,13 +37,16 @@ extern "C"
  */
 typedef struct TimerEvent_s
 {
-    uint32_t Timestamp;                  //! Current timer value
+    uint32_t Timestamp;                  //! Expiry time in RTC ticks
     uint32_t ReloadValue;                //! Timer delay value
+    uint32_t Slack;                      //! Tolerated expiry delay in RTC ticks
     bool IsStarted;                      //! Is the timer currently running
     bool IsNext2Expire;                  //! Is the next timer to expire
     void ( *Callback )( void* context ); //! Timer IRQ callback function
     void *Context;                       //! User defined data object pointer to pass back
-    struct TimerEvent_s *Next;           //! Pointer to the next Timer object.
+    struct TimerEvent_s *Next;           //! Next sibling in the timer heap
+    struct TimerEvent_s *Child;          //! First child in the timer heap
+    struct TimerEvent_s *Prev;           //! Parent of a first child, previous sibling otherwise
 }TimerEvent_t;
 
 /*!
@@ -117,6 +120,27 @@ void TimerReset( TimerEvent_t *obj );
  */
 void TimerSetValue( TimerEvent_t *obj, uint32_t value );
 
+/*!
+ * \brief Sets how late the timer may expire
+ *
+ * \remark The expiry is moved to the coarsest RTC tick boundary within the
+ *         slack, so that timers whose windows overlap expire together and
+ *         wake up the MCU once. Timers are initialized without slack, which
+ *         the timers of the receive windows must keep.
+ *
+ * \param [IN] obj   Structure containing the timer object parameters
+ * \param [IN] value Tolerated expiry delay in ms, used from the next start
+ */
+void TimerSetSlack( TimerEvent_t *obj, uint32_t value );
+
+/*!
+ * \brief Returns the number of timers which expired in the same wake up as
+ *        another one
+ *
+ * \retval count Number of wake ups saved since startup
+ */
+uint32_t TimerGetSavedWakeups( void );
+
 /*!
  * \brief Read the current time
  *
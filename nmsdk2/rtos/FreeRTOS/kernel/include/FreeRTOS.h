@@ -236,6 +236,10 @@
     #define configUSE_TIMERS    0
 #endif
 
+#ifndef configUSE_TIMER_SLACK
+    #define configUSE_TIMER_SLACK    0
+#endif
+
 #ifndef configUSE_COUNTING_SEMAPHORES
     #define configUSE_COUNTING_SEMAPHORES    0
 #endif
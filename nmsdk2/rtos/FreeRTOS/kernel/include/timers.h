@@ -1283,6 +1283,47 @@ void vTimerSetReloadMode( TimerHandle_t xTimer,
  */
 UBaseType_t uxTimerGetReloadMode( TimerHandle_t xTimer ) PRIVILEGED_FUNCTION;
 
+#if ( configUSE_TIMER_SLACK == 1 )
+
+/**
+ * void vTimerSetSlack( TimerHandle_t xTimer, const TickType_t xSlackInTicks );
+ *
+ * Allows a timer to expire up to xSlackInTicks ticks after its nominal expiry
+ * time.  The timer service task then moves the expiry to the coarsest tick
+ * boundary within that window, so timers whose windows overlap tend to expire
+ * on the same tick and the processor is woken once for all of them.  The
+ * period of an auto-reload timer is still counted from its nominal expiry
+ * time, so the slack does not make the timer drift.
+ *
+ * Timers are created with no slack.  Timers that must expire on time, such as
+ * those that open a radio receive window, should keep it that way.
+ *
+ * The new slack is used the next time the timer is started, reset or reloaded.
+ *
+ * configUSE_TIMER_SLACK must be set to 1 in FreeRTOSConfig.h for this
+ * function to be available.
+ *
+ * @param xTimer The handle of the timer being updated.
+ *
+ * @param xSlackInTicks How many ticks late the timer may expire.
+ */
+    void vTimerSetSlack( TimerHandle_t xTimer,
+                         const TickType_t xSlackInTicks ) PRIVILEGED_FUNCTION;
+
+/**
+ * UBaseType_t uxTimerGetSavedWakeups( void );
+ *
+ * Returns the number of timer expiries that the timer service task processed
+ * without blocking since the previous expiry, that is expiries that shared a
+ * wake up with another timer instead of needing one of their own.
+ *
+ * configUSE_TIMER_SLACK must be set to 1 in FreeRTOSConfig.h for this
+ * function to be available.
+ */
+    UBaseType_t uxTimerGetSavedWakeups( void ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_TIMER_SLACK */
+
 /**
  * TickType_t xTimerGetPeriod( TimerHandle_t xTimer );
  *
@@ -82,6 +82,10 @@
         #if ( configUSE_TRACE_FACILITY == 1 )
             UBaseType_t uxTimerNumber;              /*<< An ID assigned by trace tools such as FreeRTOS+Trace */
         #endif
+        #if ( configUSE_TIMER_SLACK == 1 )
+            TickType_t xTimerSlackInTicks;          /*<< How late the timer may expire so that it can share a wake up with other timers. */
+            TickType_t xTimerExpiryDelay;           /*<< How late the current expiry was scheduled, that is its list item value minus its nominal expiry time. */
+        #endif
         uint8_t ucStatus;                           /*<< Holds bits to say if the timer was statically allocated or not, and if it is active or not. */
     } xTIMER;
 
@@ -143,6 +147,15 @@
     PRIVILEGED_DATA static QueueHandle_t xTimerQueue = NULL;
     PRIVILEGED_DATA static TaskHandle_t xTimerTaskHandle = NULL;
 
+    #if ( configUSE_TIMER_SLACK == 1 )
+
+/* The number of expiries processed without the timer service task blocking
+ * since the previous one, that is without a wake up of their own, and whether
+ * a timer has expired since the task last blocked. */
+        PRIVILEGED_DATA static UBaseType_t uxSavedWakeups = ( UBaseType_t ) 0U;
+        PRIVILEGED_DATA static BaseType_t xExpiredSinceBlock = pdFALSE;
+    #endif
+
 /*lint -restore */
 
 /*-----------------------------------------------------------*/
@@ -175,6 +188,17 @@
                                                   const TickType_t xTimeNow,
                                                   const TickType_t xCommandTime ) PRIVILEGED_FUNCTION;
 
+/*
+ * Return how much later than xExpiryTime the timer should expire so that its
+ * expiry falls on the coarsest tick boundary within the timer's slack.  Timers
+ * whose slack windows overlap are then likely to expire on the same tick and
+ * share a single wake up.
+ */
+    #if ( configUSE_TIMER_SLACK == 1 )
+        static TickType_t prvGetSlackDelay( const Timer_t * const pxTimer,
+                                            const TickType_t xExpiryTime ) PRIVILEGED_FUNCTION;
+    #endif
+
 /*
  * Reload the specified auto-reload timer.  If the reloading is backlogged,
  * clear the backlog, calling the callback for each additional reload.  When
@@ -374,6 +398,13 @@
         pxNewTimer->pxCallbackFunction = pxCallbackFunction;
         vListInitialiseItem( &( pxNewTimer->xTimerListItem ) );
 
+        #if ( configUSE_TIMER_SLACK == 1 )
+            {
+                pxNewTimer->xTimerSlackInTicks = ( TickType_t ) 0U;
+                pxNewTimer->xTimerExpiryDelay = ( TickType_t ) 0U;
+            }
+        #endif
+
         if( uxAutoReload != pdFALSE )
         {
             pxNewTimer->ucStatus |= tmrSTATUS_IS_AUTORELOAD;
@@ -469,6 +500,34 @@
     }
 /*-----------------------------------------------------------*/
 
+    #if ( configUSE_TIMER_SLACK == 1 )
+
+        void vTimerSetSlack( TimerHandle_t xTimer,
+                             const TickType_t xSlackInTicks )
+        {
+            Timer_t * pxTimer = xTimer;
+
+            configASSERT( xTimer );
+            taskENTER_CRITICAL();
+            {
+                pxTimer->xTimerSlackInTicks = xSlackInTicks;
+            }
+            taskEXIT_CRITICAL();
+        }
+
+    #endif /* configUSE_TIMER_SLACK */
+/*-----------------------------------------------------------*/
+
+    #if ( configUSE_TIMER_SLACK == 1 )
+
+        UBaseType_t uxTimerGetSavedWakeups( void )
+        {
+            return uxSavedWakeups;
+        }
+
+    #endif /* configUSE_TIMER_SLACK */
+/*-----------------------------------------------------------*/
+
     UBaseType_t uxTimerGetReloadMode( TimerHandle_t xTimer )
     {
         Timer_t * pxTimer = xTimer;
@@ -544,10 +603,21 @@
         ( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
 
         /* If the timer is an auto-reload timer then calculate the next
-         * expiry time and re-insert the timer in the list of active timers. */
+         * expiry time and re-insert the timer in the list of active timers.
+         * The period is counted from the nominal expiry time, not from the
+         * later time the slack moved the expiry to, so the timer does not
+         * drift. */
         if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
         {
-            prvReloadTimer( pxTimer, xNextExpireTime, xTimeNow );
+            #if ( configUSE_TIMER_SLACK == 1 )
+                {
+                    prvReloadTimer( pxTimer, xNextExpireTime - pxTimer->xTimerExpiryDelay, xTimeNow );
+                }
+            #else
+                {
+                    prvReloadTimer( pxTimer, xNextExpireTime, xTimeNow );
+                }
+            #endif
         }
         else
         {
@@ -617,6 +687,22 @@
                 if( ( xListWasEmpty == pdFALSE ) && ( xNextExpireTime <= xTimeNow ) )
                 {
                     ( void ) xTaskResumeAll();
+
+                    #if ( configUSE_TIMER_SLACK == 1 )
+                        {
+                            /* An expiry processed before the task blocks again
+                             * shares the wake up of the previous one. */
+                            if( xExpiredSinceBlock != pdFALSE )
+                            {
+                                uxSavedWakeups++;
+                            }
+                            else
+                            {
+                                xExpiredSinceBlock = pdTRUE;
+                            }
+                        }
+                    #endif
+
                     prvProcessExpiredTimer( xNextExpireTime, xTimeNow );
                 }
                 else
@@ -634,6 +720,12 @@
                         xListWasEmpty = listLIST_IS_EMPTY( pxOverflowTimerList );
                     }
 
+                    #if ( configUSE_TIMER_SLACK == 1 )
+                        {
+                            xExpiredSinceBlock = pdFALSE;
+                        }
+                    #endif
+
                     vQueueWaitForMessageRestricted( xTimerQueue, ( xNextExpireTime - xTimeNow ), xListWasEmpty );
 
                     if( xTaskResumeAll() == pdFALSE )
@@ -708,6 +800,42 @@
     }
 /*-----------------------------------------------------------*/
 
+    #if ( configUSE_TIMER_SLACK == 1 )
+
+        static TickType_t prvGetSlackDelay( const Timer_t * const pxTimer,
+                                            const TickType_t xExpiryTime )
+        {
+            const TickType_t xLatestTime = xExpiryTime + pxTimer->xTimerSlackInTicks;
+            TickType_t xMask = xExpiryTime ^ xLatestTime;
+            TickType_t xBit = ( TickType_t ) 1U;
+            TickType_t xDelay = ( TickType_t ) 0U;
+
+            /* A timer without slack, or whose slack window wraps the tick
+             * count, expires exactly when asked to. */
+            if( ( pxTimer->xTimerSlackInTicks != ( TickType_t ) 0U ) && ( xLatestTime > xExpiryTime ) )
+            {
+                /* Find the most significant bit that differs between the
+                 * nominal and the latest expiry time, and round the latest
+                 * expiry time down to a multiple of it.  That multiple is still
+                 * after the nominal expiry time. */
+                while( ( xMask >>= 1 ) != ( TickType_t ) 0U )
+                {
+                    xBit <<= 1;
+                }
+
+                xDelay = ( xLatestTime & ~( xBit - ( TickType_t ) 1U ) ) - xExpiryTime;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            return xDelay;
+        }
+
+    #endif /* configUSE_TIMER_SLACK */
+/*-----------------------------------------------------------*/
+
     static BaseType_t prvInsertTimerInActiveList( Timer_t * const pxTimer,
                                                   const TickType_t xNextExpiryTime,
                                                   const TickType_t xTimeNow,
@@ -715,7 +843,20 @@
     {
         BaseType_t xProcessTimerNow = pdFALSE;
 
-        listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xNextExpiryTime );
+        #if ( configUSE_TIMER_SLACK == 1 )
+            {
+                /* The timer is listed at its slack-aligned expiry time, but the
+                 * checks below are made against the nominal expiry time.  Both
+                 * are on the same side of a tick count overflow as the delay is
+                 * only applied if adding the slack does not overflow. */
+                pxTimer->xTimerExpiryDelay = prvGetSlackDelay( pxTimer, xNextExpiryTime );
+                listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xNextExpiryTime + pxTimer->xTimerExpiryDelay );
+            }
+        #else
+            {
+                listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xNextExpiryTime );
+            }
+        #endif
         listSET_LIST_ITEM_OWNER( &( pxTimer->xTimerListItem ), pxTimer );
 
         if( xNextExpiryTime <= xTimeNow )
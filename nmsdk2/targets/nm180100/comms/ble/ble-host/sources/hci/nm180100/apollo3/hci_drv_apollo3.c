@@ -96,6 +96,7 @@
 //
 //*****************************************************************************
 #define HEARTBEAT_TIMEOUT_MS            (10000)   //milli-seconds
+#define HEARTBEAT_SLACK_MS              (2000)    //milli-seconds
 #define HCI_DRV_MAX_IRQ_TIMEOUT          2000
 #define HCI_DRV_MAX_XTAL_RETRIES         10
 #define HCI_DRV_MAX_TX_RETRIES           10000
@@ -895,6 +896,7 @@ HciDrvHandlerInit(wsfHandlerId_t handlerId)
 
     g_HeartBeatTimer.handlerId = handlerId;
     g_HeartBeatTimer.msg.event = BLE_HEARTBEAT_EVENT;
+    WsfTimerSetSlackMs(&g_HeartBeatTimer, HEARTBEAT_SLACK_MS);
 
     g_WakeTimer.handlerId = handlerId;
     g_WakeTimer.msg.event = BLE_SET_WAKEUP;
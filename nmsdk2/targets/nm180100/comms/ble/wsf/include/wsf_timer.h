@@ -52,11 +52,15 @@ typedef uint32_t wsfTimerTicks_t;
 /*! \brief Timer structure */
 typedef struct wsfTimer_tag
 {
-  struct wsfTimer_tag *pNext;             /*!< \brief pointer to next timer in queue */
+  struct wsfTimer_tag *pNext;             /*!< \brief pointer to next timer in wheel slot */
+  struct wsfTimer_tag *pPrev;             /*!< \brief pointer to previous timer in wheel slot */
   wsfMsgHdr_t         msg;                /*!< \brief application-defined timer event parameters */
-  wsfTimerTicks_t     ticks;              /*!< \brief number of ticks until expiration */
+  wsfTimerTicks_t     ticks;              /*!< \brief number of ticks the timer was started with */
+  wsfTimerTicks_t     expiry;             /*!< \brief timer service time of expiration */
+  wsfTimerTicks_t     slack;              /*!< \brief ticks the expiration may be delayed by */
   wsfHandlerId_t      handlerId;          /*!< \brief event handler for this timer */
   bool_t              isStarted;          /*!< \brief TRUE if timer has been started */
+  uint8_t             slot;               /*!< \brief timer wheel slot */
 } wsfTimer_t;
 
 /**************************************************************************************************
@@ -99,6 +103,31 @@ void WsfTimerStartSec(wsfTimer_t *pTimer, wsfTimerTicks_t sec);
 /*************************************************************************************************/
 void WsfTimerStartMs(wsfTimer_t *pTimer, wsfTimerTicks_t ms);
 
+/*************************************************************************************************/
+/*!
+ *  \brief  Set how late a timer may expire.  The expiration is moved to the coarsest tick
+ *          boundary within the slack, so that timers whose windows overlap expire together
+ *          and wake up the system once.  The slack of a timer in static storage is zero,
+ *          which timers with exact timing must keep.
+ *
+ *  \param  pTimer  Pointer to timer.
+ *  \param  ms      Milliseconds the expiration may be delayed by, used from the next start.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void WsfTimerSetSlackMs(wsfTimer_t *pTimer, wsfTimerTicks_t ms);
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Return the number of timers which expired in the same timer service update as
+ *          another one.
+ *
+ *  \return Number of wake-ups saved since initialization.
+ */
+/*************************************************************************************************/
+uint32_t WsfTimerGetSavedWakeups(void);
+
 /*************************************************************************************************/
 /*!
  *  \brief  Stop a timer.
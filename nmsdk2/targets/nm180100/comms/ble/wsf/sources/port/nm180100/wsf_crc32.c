@@ -0,0 +1,63 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*************************************************************************************************/
+/*!
+ *  \file   wsf_crc32.c
+ *
+ *  \brief  CRC-32 utilities backed by the nm180100 shared CRC-32 table.
+ *
+ *  Replaces the generic WSF util/crc32.c on this target so that the BLE and LoRaWAN stacks share
+ *  one set of tables (utils/crc32_table.c, built into the HAL library).  The table size is
+ *  selected with CRC32_METHOD rather than WSF_CRC_SIZE_OPTIMIZE.
+ */
+/*************************************************************************************************/
+
+#include "wsf_types.h"
+#include "util/crc32.h"
+#include "crc32_table.h"
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Calculate the CRC-32 of the given buffer.
+ *
+ *  \param  crcInit  Initial value of the CRC.
+ *  \param  len      Length of the buffer.
+ *  \param  pBuf     Buffer to compute the CRC.
+ *
+ *  \return CRC-32 of the buffer.
+ */
+/*************************************************************************************************/
+uint32_t CalcCrc32(uint32_t crcInit, uint32_t len, const uint8_t *pBuf)
+{
+  return crc32_update(crcInit, pBuf, len) ^ 0xFFFFFFFFU;
+}
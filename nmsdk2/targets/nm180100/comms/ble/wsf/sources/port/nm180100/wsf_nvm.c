@@ -22,31 +22,72 @@
  */
 /*************************************************************************************************/
 
+#include <string.h>
+
+#include "am_mcu_apollo.h"
 #include "wsf_types.h"
 #include "wsf_assert.h"
 #include "wsf_nvm.h"
+#include "wsf_trace.h"
 #include "util/crc32.h"
 
+#include "ble_config.h"
+
 /**************************************************************************************************
   Macros
 **************************************************************************************************/
 
-/*! NVM data start address. */
-#define WSF_NVM_START_ADDR                        0x0000
-
 /*! Reserved filecode. */
 #define WSF_NVM_RESERVED_FILECODE                 ((uint32_t)0)
 
 /* Unused (erased) filecode. */
-/* TODO: May depend on flash type */
 #define WSF_NVM_UNUSED_FILECODE                   ((uint32_t)0xFFFFFFFF)
 
+/*! Flash word size. */
+#define WSF_FLASH_WORD_SIZE                       4
+
 /*! Align value to word boundary. */
-#define WSF_NVM_WORD_ALIGN(x)                     (((x) + (PAL_NVM_WORD_SIZE - 1)) & \
-                                                         ~(PAL_NVM_WORD_SIZE - 1))
+#define WSF_NVM_WORD_ALIGN(x)                     (((x) + (WSF_FLASH_WORD_SIZE - 1)) & \
+                                                         ~(WSF_FLASH_WORD_SIZE - 1))
+
+/*! Flash space taken by a record of the given data length. */
+#define WSF_NVM_RECORD_SIZE(len)                  (sizeof(WsfNvmHeader_t) + WSF_NVM_WORD_ALIGN(len))
 
 #define WSF_NVM_CRC_INIT_VALUE                    0xFEDCBA98
 
+#if (WSF_NVM_NUM_OF_PAGES < 2) || (WSF_NVM_NUM_OF_PAGES % 2)
+#error "WSF_NVM_NUM_OF_PAGES must be an even number of at least 2"
+#endif
+
+/*! The NVM pages are split into two sectors.  Records are appended to the active sector; when it
+ *  runs out of space the live records are copied to the other sector and the active one is erased. */
+#define WSF_NVM_SECTOR_SIZE                       ((WSF_NVM_NUM_OF_PAGES / 2) * WSF_NVM_PAGE_SIZE)
+
+/*! Sector status, stored in the first word of each sector.  Each status only clears bits of the
+ *  previous one, so a sector goes from erased to superseded without an erase. */
+#define WSF_NVM_SECTOR_ERASED                     ((uint32_t)0xFFFFFFFF)
+#define WSF_NVM_SECTOR_MIGRATING                  ((uint32_t)0xFFFFEEEE)
+#define WSF_NVM_SECTOR_RECEIVING                  ((uint32_t)0xEEEEEEEE)
+#define WSF_NVM_SECTOR_ACTIVE                     ((uint32_t)0xCCCCCCCC)
+#define WSF_NVM_SECTOR_SUPERSEDED                 ((uint32_t)0x00000000)
+
+/*! Size of the sector status. */
+#define WSF_NVM_SECTOR_HDR_SIZE                   sizeof(uint32_t)
+
+/*! A write compacts the active sector when its free space drops below this threshold and at least
+ *  as many bytes can be reclaimed. */
+#ifndef WSF_NVM_COMPACTION_THRESHOLD
+#define WSF_NVM_COMPACTION_THRESHOLD              (WSF_NVM_SECTOR_SIZE / 4)
+#endif
+
+/*! Number of IDs tracked by the RAM directory.  Records beyond it are found by walking the sector. */
+#ifndef WSF_NVM_DIRECTORY_SIZE
+#define WSF_NVM_DIRECTORY_SIZE                    32
+#endif
+
+/*! Size of the RAM buffer flash is programmed from, in words. */
+#define WSF_NVM_COPY_BUF_WORDS                    16
+
 /**************************************************************************************************
   Data Types
 **************************************************************************************************/
@@ -60,6 +101,534 @@ typedef struct
   uint32_t          dataCrc;    /*!< CRC of subsequent data. */
 } WsfNvmHeader_t;
 
+/*! \brief      Directory entry. */
+typedef struct
+{
+  uint32_t          id;         /*!< Stored data ID. */
+  uint32_t          addr;       /*!< Address of the record holding the data. */
+} wsfNvmDirEntry_t;
+
+/*! \brief      Control block. */
+typedef struct
+{
+  uint32_t          sectorAddr; /*!< Start of the active sector, 0 until initialized. */
+  uint32_t          freeAddr;   /*!< First unused address of the active sector. */
+  uint32_t          usedAddr;   /*!< End of the valid records of the active sector. */
+  uint32_t          deadBytes;  /*!< Bytes taken by scratched out records. */
+  wsfNvmDirEntry_t  dir[WSF_NVM_DIRECTORY_SIZE]; /*!< Latest valid record of each ID. */
+  uint16_t          dirCount;   /*!< Number of directory entries in use. */
+  bool_t            dirOverflow; /*!< Some IDs did not fit in the directory. */
+} wsfNvmCb_t;
+
+/**************************************************************************************************
+  Local Variables
+**************************************************************************************************/
+
+/*! Control block. */
+static wsfNvmCb_t wsfNvmCb;
+
+/*! Buffer flash is programmed from. */
+static uint32_t wsfNvmCopyBuf[WSF_NVM_COPY_BUF_WORDS];
+
+/**************************************************************************************************
+  Local Functions
+**************************************************************************************************/
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Program flash, padding the last partial word with erased bytes.
+ *
+ *  \param  addr  Word aligned flash address.
+ *  \param  pBuf  Data to program, may be unaligned or in flash.
+ *  \param  len   Data length.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfNvmProgram(uint32_t addr, const uint8_t *pBuf, uint32_t len)
+{
+  uint32_t chunk;
+
+  while (len > 0)
+  {
+    chunk = (len < sizeof(wsfNvmCopyBuf)) ? len : sizeof(wsfNvmCopyBuf);
+
+    memset(wsfNvmCopyBuf, 0xFF, sizeof(wsfNvmCopyBuf));
+    memcpy(wsfNvmCopyBuf, pBuf, chunk);
+    am_hal_flash_program_main(AM_HAL_FLASH_PROGRAM_KEY, wsfNvmCopyBuf, (uint32_t *)addr,
+                              WSF_NVM_WORD_ALIGN(chunk) / WSF_FLASH_WORD_SIZE);
+
+    addr += chunk;
+    pBuf += chunk;
+    len -= chunk;
+  }
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Program the status of a sector.
+ *
+ *  \param  sectorAddr  Start of the sector.
+ *  \param  status      New status.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfNvmSetStatus(uint32_t sectorAddr, uint32_t status)
+{
+  wsfNvmProgram(sectorAddr, (const uint8_t *)&status, sizeof(status));
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Erase a sector.
+ *
+ *  \param  sectorAddr  Start of the sector.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfNvmSectorErase(uint32_t sectorAddr)
+{
+  /* Erase the page holding the status last, so that an erased status means an erased sector. */
+  for (uint32_t addr = sectorAddr + WSF_NVM_SECTOR_SIZE; addr > sectorAddr; )
+  {
+    addr -= WSF_NVM_PAGE_SIZE;
+    am_hal_flash_page_erase(AM_HAL_FLASH_PROGRAM_KEY,
+                            AM_HAL_FLASH_ADDR2INST(addr), AM_HAL_FLASH_ADDR2PAGE(addr));
+  }
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Read the header of a record.
+ *
+ *  \param  addr     Address of the record.
+ *  \param  endAddr  End of the area holding the record.
+ *  \param  pHeader  Header read.
+ *
+ *  \return FALSE at the end of the records or on a corrupt header.
+ */
+/*************************************************************************************************/
+static bool_t wsfNvmReadHeader(uint32_t addr, uint32_t endAddr, WsfNvmHeader_t *pHeader)
+{
+  if (addr + sizeof(*pHeader) > endAddr)
+  {
+    return FALSE;
+  }
+
+  memcpy(pHeader, (const void *)addr, sizeof(*pHeader));
+
+  if (pHeader->id == WSF_NVM_UNUSED_FILECODE)
+  {
+    /* Found unused entry at end of used storage. */
+    return FALSE;
+  }
+
+  /* Scratched out headers keep their length but not their CRC. */
+  if ((pHeader->id != WSF_NVM_RESERVED_FILECODE) &&
+      (CalcCrc32(WSF_NVM_CRC_INIT_VALUE, sizeof(pHeader->id) + sizeof(pHeader->len),
+                 (uint8_t *)pHeader) != pHeader->headerCrc))
+  {
+    /* Corrupt header, e.g. interrupted while it was programmed. */
+    return FALSE;
+  }
+
+  return ((pHeader->len < WSF_NVM_SECTOR_SIZE) &&
+          (addr + WSF_NVM_RECORD_SIZE(pHeader->len) <= endAddr));
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Check the data of a record.
+ *
+ *  \param  addr     Address of the record.
+ *  \param  pHeader  Header of the record.
+ *
+ *  \return TRUE if the data matches its CRC.
+ */
+/*************************************************************************************************/
+static bool_t wsfNvmDataValid(uint32_t addr, const WsfNvmHeader_t *pHeader)
+{
+  return (CalcCrc32(WSF_NVM_CRC_INIT_VALUE, pHeader->len,
+                    (const uint8_t *)(addr + sizeof(*pHeader))) == pHeader->dataCrc);
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Find the directory entry of an ID.
+ *
+ *  \param  id  Stored data ID.
+ *
+ *  \return Directory entry or NULL if the ID is not in the directory.
+ */
+/*************************************************************************************************/
+static wsfNvmDirEntry_t *wsfNvmDirFind(uint32_t id)
+{
+  for (uint16_t i = 0; i < wsfNvmCb.dirCount; i++)
+  {
+    if (wsfNvmCb.dir[i].id == id)
+    {
+      return &wsfNvmCb.dir[i];
+    }
+  }
+
+  return NULL;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Add an ID to the directory.
+ *
+ *  \param  id    Stored data ID, not yet in the directory.
+ *  \param  addr  Address of the record.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfNvmDirAdd(uint32_t id, uint32_t addr)
+{
+  if (wsfNvmCb.dirCount < WSF_NVM_DIRECTORY_SIZE)
+  {
+    wsfNvmCb.dir[wsfNvmCb.dirCount].id = id;
+    wsfNvmCb.dir[wsfNvmCb.dirCount].addr = addr;
+    wsfNvmCb.dirCount++;
+  }
+  else
+  {
+    wsfNvmCb.dirOverflow = TRUE;
+  }
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Scratch out a record.
+ *
+ *  \param  addr  Address of the record.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfNvmScratchRecord(uint32_t addr)
+{
+  WsfNvmHeader_t header;
+
+  /* Scratch header out, keeping its length. */
+  memcpy(&header, (const void *)addr, sizeof(header));
+  header.id = WSF_NVM_RESERVED_FILECODE;
+  header.headerCrc = 0;
+  header.dataCrc = 0;
+  wsfNvmProgram(addr, (const uint8_t *)&header, sizeof(header));
+
+  wsfNvmCb.deadBytes += WSF_NVM_RECORD_SIZE(header.len);
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Find the active sector's free space and build the directory.
+ *
+ *  Older valid copies of an ID, left behind by an interrupted write, are scratched out so that the
+ *  directory entry is the only one.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfNvmScan(void)
+{
+  WsfNvmHeader_t header;
+  wsfNvmDirEntry_t *pEntry;
+  uint32_t addr = wsfNvmCb.sectorAddr + WSF_NVM_SECTOR_HDR_SIZE;
+
+  wsfNvmCb.deadBytes = 0;
+  wsfNvmCb.dirCount = 0;
+  wsfNvmCb.dirOverflow = FALSE;
+
+  while (wsfNvmReadHeader(addr, wsfNvmCb.sectorAddr + WSF_NVM_SECTOR_SIZE, &header))
+  {
+    if (header.id == WSF_NVM_RESERVED_FILECODE)
+    {
+      wsfNvmCb.deadBytes += WSF_NVM_RECORD_SIZE(header.len);
+    }
+    else if (wsfNvmDataValid(addr, &header))
+    {
+      if ((pEntry = wsfNvmDirFind(header.id)) != NULL)
+      {
+        wsfNvmScratchRecord(pEntry->addr);
+        pEntry->addr = addr;
+      }
+      else
+      {
+        wsfNvmDirAdd(header.id, addr);
+      }
+    }
+    addr += WSF_NVM_RECORD_SIZE(header.len);
+  }
+
+  wsfNvmCb.usedAddr = addr;
+  wsfNvmCb.freeAddr = addr;
+
+  /* Anything but erased flash after the last record is a torn header.  Treat the sector as full so
+   * that the next write compacts it. */
+  if ((addr + sizeof(header) <= wsfNvmCb.sectorAddr + WSF_NVM_SECTOR_SIZE) &&
+      ((header.id != WSF_NVM_UNUSED_FILECODE) || (header.len != WSF_NVM_UNUSED_FILECODE) ||
+       (header.headerCrc != WSF_NVM_UNUSED_FILECODE) || (header.dataCrc != WSF_NVM_UNUSED_FILECODE)))
+  {
+    wsfNvmCb.freeAddr = wsfNvmCb.sectorAddr + WSF_NVM_SECTOR_SIZE;
+  }
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Check whether a record is the latest valid copy of its data.
+ *
+ *  \param  addr     Address of the record.
+ *  \param  pHeader  Header of the record.
+ *
+ *  \return TRUE if no later record with the same ID holds valid data.
+ */
+/*************************************************************************************************/
+static bool_t wsfNvmIsLatest(uint32_t addr, const WsfNvmHeader_t *pHeader)
+{
+  WsfNvmHeader_t header;
+  wsfNvmDirEntry_t *pEntry = wsfNvmDirFind(pHeader->id);
+
+  if (pEntry != NULL)
+  {
+    return (pEntry->addr == addr);
+  }
+
+  /* Records below usedAddr have been validated by wsfNvmScan(). */
+  for (addr += WSF_NVM_RECORD_SIZE(pHeader->len); addr < wsfNvmCb.usedAddr;
+       addr += WSF_NVM_RECORD_SIZE(header.len))
+  {
+    memcpy(&header, (const void *)addr, sizeof(header));
+
+    if ((header.id == pHeader->id) && wsfNvmDataValid(addr, &header))
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Copy the live records to the other sector and erase the active one.
+ *
+ *  The destination is marked receiving while records are copied.  The source is then marked
+ *  superseded before it is erased, and the destination only becomes active once the erase is done.
+ *  A receiving sector next to an active one is an interrupted copy and is redone, next to a
+ *  superseded or erased one it is complete and WsfNvmInit() finishes the compaction.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfNvmCompact(void)
+{
+  WsfNvmHeader_t header;
+  wsfNvmDirEntry_t *pEntry;
+  uint32_t srcAddr = wsfNvmCb.sectorAddr;
+  uint32_t dstAddr = (srcAddr == WSF_NVM_START_ADDR) ? (srcAddr + WSF_NVM_SECTOR_SIZE) :
+                                                       WSF_NVM_START_ADDR;
+  uint32_t storageAddr = dstAddr + WSF_NVM_SECTOR_HDR_SIZE;
+
+  if (*(const uint32_t *)dstAddr != WSF_NVM_SECTOR_ERASED)
+  {
+    wsfNvmSectorErase(dstAddr);
+  }
+  wsfNvmSetStatus(dstAddr, WSF_NVM_SECTOR_RECEIVING);
+
+  for (uint32_t addr = srcAddr + WSF_NVM_SECTOR_HDR_SIZE; addr < wsfNvmCb.usedAddr;
+       addr += WSF_NVM_RECORD_SIZE(header.len))
+  {
+    memcpy(&header, (const void *)addr, sizeof(header));
+
+    if ((header.id != WSF_NVM_RESERVED_FILECODE) && wsfNvmDataValid(addr, &header) &&
+        wsfNvmIsLatest(addr, &header))
+    {
+      wsfNvmProgram(storageAddr, (const uint8_t *)addr, sizeof(header) + header.len);
+
+      if ((pEntry = wsfNvmDirFind(header.id)) != NULL)
+      {
+        pEntry->addr = storageAddr;
+      }
+      storageAddr += WSF_NVM_RECORD_SIZE(header.len);
+    }
+  }
+
+  /* A sector of several pages is erased one page at a time, its status page last. */
+  wsfNvmSetStatus(srcAddr, WSF_NVM_SECTOR_SUPERSEDED);
+  wsfNvmSectorErase(srcAddr);
+  wsfNvmSetStatus(dstAddr, WSF_NVM_SECTOR_ACTIVE);
+
+  wsfNvmCb.sectorAddr = dstAddr;
+  wsfNvmCb.usedAddr = storageAddr;
+  wsfNvmCb.freeAddr = storageAddr;
+  wsfNvmCb.deadBytes = 0;
+
+  /* Only one copy of each ID is left, pick up those that did not fit in the directory. */
+  if (wsfNvmCb.dirOverflow)
+  {
+    wsfNvmScan();
+  }
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Scratch out the records of an ID.
+ *
+ *  \param  id       Stored data ID.
+ *  \param  endAddr  Records at or above this address are kept.
+ *
+ *  \return TRUE if a record was scratched out.
+ */
+/*************************************************************************************************/
+static bool_t wsfNvmScratch(uint32_t id, uint32_t endAddr)
+{
+  WsfNvmHeader_t header;
+  wsfNvmDirEntry_t *pEntry = wsfNvmDirFind(id);
+  bool_t scratched = FALSE;
+
+  if (pEntry != NULL)
+  {
+    /* The directory entry is the only valid copy. */
+    if (pEntry->addr < endAddr)
+    {
+      wsfNvmScratchRecord(pEntry->addr);
+      *pEntry = wsfNvmCb.dir[--wsfNvmCb.dirCount];
+      scratched = TRUE;
+    }
+    return scratched;
+  }
+
+  if (!wsfNvmCb.dirOverflow)
+  {
+    return FALSE;
+  }
+
+  for (uint32_t addr = wsfNvmCb.sectorAddr + WSF_NVM_SECTOR_HDR_SIZE; addr < endAddr;
+       addr += WSF_NVM_RECORD_SIZE(header.len))
+  {
+    memcpy(&header, (const void *)addr, sizeof(header));
+
+    if (header.id == id)
+    {
+      wsfNvmScratchRecord(addr);
+      scratched = TRUE;
+    }
+  }
+
+  return scratched;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Check whether the storage holds the legacy layout.
+ *
+ *  The legacy layout is a single log of records starting at WSF_NVM_START_ADDR, without a sector
+ *  status.  A scratched out first record reads as a superseded status; a superseded sector is told
+ *  apart by the copy next to it or by the record after its status.  A migrating second sector
+ *  holds an interrupted migration, the legacy records are still intact.
+ *
+ *  \param  status  Status words of the two sectors.
+ *
+ *  \return TRUE if the first sector starts with a legacy record.
+ */
+/*************************************************************************************************/
+static bool_t wsfNvmIsLegacy(const uint32_t *status)
+{
+  WsfNvmHeader_t header;
+  uint32_t endAddr = WSF_NVM_START_ADDR + WSF_NVM_SECTOR_SIZE;
+
+  if (status[1] == WSF_NVM_SECTOR_MIGRATING)
+  {
+    return TRUE;
+  }
+
+  if ((status[0] == WSF_NVM_SECTOR_ERASED) || (status[0] == WSF_NVM_SECTOR_RECEIVING) ||
+      (status[0] == WSF_NVM_SECTOR_ACTIVE))
+  {
+    return FALSE;
+  }
+
+  if ((status[0] == WSF_NVM_SECTOR_SUPERSEDED) &&
+      ((status[1] == WSF_NVM_SECTOR_RECEIVING) ||
+       wsfNvmReadHeader(WSF_NVM_START_ADDR + WSF_NVM_SECTOR_HDR_SIZE, endAddr, &header)))
+  {
+    return FALSE;
+  }
+
+  return wsfNvmReadHeader(WSF_NVM_START_ADDR, endAddr, &header);
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Copy the records of the legacy layout to the second sector and make it active.
+ *
+ *  The second sector is marked migrating while records are copied and receiving once the copy is
+ *  complete, from there on the steps are those of a compaction.  A copy cut short is redone by
+ *  WsfNvmInit().
+ *  Legacy records past the first sector are lost when the second one is erased, and records that
+ *  do not fit are dropped.
+ *
+ *  \param  status  Status words of the two sectors.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfNvmMigrate(const uint32_t *status)
+{
+  WsfNvmHeader_t header;
+  uint32_t srcAddr = WSF_NVM_START_ADDR;
+  uint32_t dstAddr = WSF_NVM_START_ADDR + WSF_NVM_SECTOR_SIZE;
+  uint32_t storageAddr = dstAddr + WSF_NVM_SECTOR_HDR_SIZE;
+  bool_t dropped = FALSE;
+
+  WSF_TRACE_WARN0("WsfNvm: migrating legacy records");
+
+  /* A migrating second sector holds an interrupted copy, anything else a longer legacy log. */
+  if (status[1] != WSF_NVM_SECTOR_ERASED)
+  {
+    dropped = (status[1] != WSF_NVM_SECTOR_MIGRATING);
+    wsfNvmSectorErase(dstAddr);
+  }
+  wsfNvmSetStatus(dstAddr, WSF_NVM_SECTOR_MIGRATING);
+
+  for (uint32_t addr = srcAddr; wsfNvmReadHeader(addr, dstAddr, &header);
+       addr += WSF_NVM_RECORD_SIZE(header.len))
+  {
+    /* The legacy write dropped unaligned data tails, those records never read back. */
+    if ((header.id == WSF_NVM_RESERVED_FILECODE) || !wsfNvmDataValid(addr, &header))
+    {
+      continue;
+    }
+
+    if (storageAddr + WSF_NVM_RECORD_SIZE(header.len) > dstAddr + WSF_NVM_SECTOR_SIZE)
+    {
+      dropped = TRUE;
+      continue;
+    }
+
+    wsfNvmProgram(storageAddr, (const uint8_t *)addr, sizeof(header) + header.len);
+    storageAddr += WSF_NVM_RECORD_SIZE(header.len);
+  }
+
+  wsfNvmSetStatus(dstAddr, WSF_NVM_SECTOR_RECEIVING);
+  wsfNvmSetStatus(srcAddr, WSF_NVM_SECTOR_SUPERSEDED);
+  wsfNvmSectorErase(srcAddr);
+  wsfNvmSetStatus(dstAddr, WSF_NVM_SECTOR_ACTIVE);
+
+  if (dropped)
+  {
+    WSF_TRACE_WARN0("WsfNvm: legacy records dropped");
+  }
+
+  /* The legacy log may hold several valid copies of an ID, the scan keeps the last one. */
+  wsfNvmCb.sectorAddr = dstAddr;
+  wsfNvmScan();
+}
+
 /**************************************************************************************************
   Global Functions
 **************************************************************************************************/
@@ -73,6 +642,74 @@ typedef struct
 /*************************************************************************************************/
 void WsfNvmInit(void)
 {
+  uint32_t sectorAddr[2] = { WSF_NVM_START_ADDR, WSF_NVM_START_ADDR + WSF_NVM_SECTOR_SIZE };
+  uint32_t status[2] = { *(const uint32_t *)sectorAddr[0], *(const uint32_t *)sectorAddr[1] };
+  uint32_t active, other;
+
+  if (status[0] == WSF_NVM_SECTOR_ACTIVE)
+  {
+    active = 0;
+  }
+  else if (status[1] == WSF_NVM_SECTOR_ACTIVE)
+  {
+    active = 1;
+  }
+  else if (wsfNvmIsLegacy(status))
+  {
+    wsfNvmMigrate(status);
+    return;
+  }
+  else if ((status[1] == WSF_NVM_SECTOR_RECEIVING) && (status[0] != WSF_NVM_SECTOR_RECEIVING))
+  {
+    /* The copy to sector 1 completed, the source erase may not have. */
+    active = 1;
+  }
+  else if (status[0] == WSF_NVM_SECTOR_RECEIVING)
+  {
+    active = 0;
+  }
+  else if ((status[0] == WSF_NVM_SECTOR_SUPERSEDED) || (status[1] == WSF_NVM_SECTOR_SUPERSEDED))
+  {
+    /* A superseded sector without a receiving one was left active by the previous status values.
+     * Compact it so that it gets the current ones. */
+    active = (status[0] == WSF_NVM_SECTOR_SUPERSEDED) ? 0 : 1;
+    other = 1 - active;
+    if (status[other] != WSF_NVM_SECTOR_ERASED)
+    {
+      wsfNvmSectorErase(sectorAddr[other]);
+    }
+
+    wsfNvmCb.sectorAddr = sectorAddr[active];
+    wsfNvmScan();
+    wsfNvmCompact();
+    return;
+  }
+  else
+  {
+    /* The storage is new or unrecognized. */
+    active = 0;
+    if (status[0] != WSF_NVM_SECTOR_ERASED)
+    {
+      WSF_TRACE_WARN0("WsfNvm: unrecognized storage erased");
+      wsfNvmSectorErase(sectorAddr[0]);
+    }
+  }
+  other = 1 - active;
+
+  /* Next to an active sector, a receiving one holds an interrupted copy and the source is intact.
+   * Next to a complete copy, the source is superseded and may be partly erased. */
+  if (status[other] != WSF_NVM_SECTOR_ERASED)
+  {
+    wsfNvmSectorErase(sectorAddr[other]);
+  }
+
+  if (*(const uint32_t *)sectorAddr[active] != WSF_NVM_SECTOR_ACTIVE)
+  {
+    wsfNvmSetStatus(sectorAddr[active], WSF_NVM_SECTOR_ACTIVE);
+  }
+
+  wsfNvmCb.sectorAddr = sectorAddr[active];
+  wsfNvmScan();
 }
 
 /*************************************************************************************************/
@@ -90,54 +727,46 @@ void WsfNvmInit(void)
 bool_t WsfNvmReadData(uint32_t id, uint8_t *pData, uint16_t len, WsfNvmCompEvent_t compCback)
 {
   WsfNvmHeader_t header;
-  uint32_t headerCrc, dataCrc;
-  uint32_t storageAddr = WSF_NVM_START_ADDR;
+  wsfNvmDirEntry_t *pEntry;
+  uint32_t storageAddr = 0;
   bool_t findId = FALSE;
 
   WSF_ASSERT(!((id == WSF_NVM_RESERVED_FILECODE) || (id == WSF_NVM_UNUSED_FILECODE)));
 
-  /* Read first header. */
-  memcpy(&header, (const void *)storageAddr, sizeof(header));
+  if (wsfNvmCb.sectorAddr == 0)
+  {
+    WsfNvmInit();
+  }
 
-  do
+  if ((pEntry = wsfNvmDirFind(id)) != NULL)
   {
-    if (header.id == WSF_NVM_UNUSED_FILECODE)
+    memcpy(&header, (const void *)pEntry->addr, sizeof(header));
+
+    if ((header.len == len) && wsfNvmDataValid(pEntry->addr, &header))
     {
-      /* Found unused entry at end of used storage. */
-      break;
+      storageAddr = pEntry->addr;
     }
-
-    /* Iterate through stored data headers, looking for existing matching stored data header. */
-    if (header.id != WSF_NVM_RESERVED_FILECODE)
+  }
+  else if (wsfNvmCb.dirOverflow)
+  {
+    /* The last valid copy wins, an older one is only left behind by an interrupted write. */
+    for (uint32_t addr = wsfNvmCb.sectorAddr + WSF_NVM_SECTOR_HDR_SIZE; addr < wsfNvmCb.usedAddr;
+         addr += WSF_NVM_RECORD_SIZE(header.len))
     {
-      /* Calculate CRC of header itself. */
-      headerCrc = CalcCrc32(WSF_NVM_CRC_INIT_VALUE, sizeof(header.id) + sizeof(header.len),
-                            (uint8_t *)&header);
+      memcpy(&header, (const void *)addr, sizeof(header));
 
-      if (headerCrc != header.headerCrc)
-      {
-        /* Corrupt header. */
-        /* TODO: Catastrophic failure? */
-        break;
-      }
-      else if ((header.id == id) && (header.len == len))
+      if ((header.id == id) && (header.len == len) && wsfNvmDataValid(addr, &header))
       {
-        /* Valid header and matching ID - read data after header. */
-        storageAddr += sizeof(header);
-        memcpy(pData, (const void *)storageAddr, sizeof(header.len));
-        dataCrc = CalcCrc32(WSF_NVM_CRC_INIT_VALUE, header.len, pData);
-        if (dataCrc == header.dataCrc)
-        {
-          findId = TRUE;
-        }
-        break;
+        storageAddr = addr;
       }
     }
+  }
 
-    /* Move to next stored data block and read header. */
-    storageAddr += WSF_NVM_WORD_ALIGN(header.len) + sizeof(header);
-    memcpy(&header, (const void *)storageAddr, sizeof(header));
-  } while(1);
+  if (storageAddr != 0)
+  {
+    memcpy(pData, (const void *)(storageAddr + sizeof(header)), len);
+    findId = TRUE;
+  }
 
   if (compCback)
   {
@@ -161,70 +790,57 @@ bool_t WsfNvmReadData(uint32_t id, uint8_t *pData, uint16_t len, WsfNvmCompEvent
 bool_t WsfNvmWriteData(uint32_t id, const uint8_t *pData, uint16_t len, WsfNvmCompEvent_t compCback)
 {
   WsfNvmHeader_t header;
-  uint32_t headerCrc;
-  uint32_t storageAddr = WSF_NVM_START_ADDR;
+  uint32_t storageAddr;
+  uint32_t endAddr;
+  bool_t written = FALSE;
 
   WSF_ASSERT(!((id == WSF_NVM_RESERVED_FILECODE) || (id == WSF_NVM_UNUSED_FILECODE)));
 
-  /* Read first header. */
-  memcpy(&header, (const void *)storageAddr, sizeof(header));
+  if (wsfNvmCb.sectorAddr == 0)
+  {
+    WsfNvmInit();
+  }
 
-  do
+  endAddr = wsfNvmCb.sectorAddr + WSF_NVM_SECTOR_SIZE;
+  if (wsfNvmCb.freeAddr + WSF_NVM_RECORD_SIZE(len) > endAddr)
   {
-    if (header.id == WSF_NVM_UNUSED_FILECODE)
-    {
-      /* Found unused entry at end of used storage. */
-      break;
-    }
+    wsfNvmCompact();
+    endAddr = wsfNvmCb.sectorAddr + WSF_NVM_SECTOR_SIZE;
+  }
 
-    /* Iterate through stored data headers, looking for existing matching stored data header. */
-    if (header.id != WSF_NVM_RESERVED_FILECODE)
+  if (wsfNvmCb.freeAddr + WSF_NVM_RECORD_SIZE(len) <= endAddr)
+  {
+    storageAddr = wsfNvmCb.freeAddr;
+
+    /* Create a new stored data header and store data. */
+    header.id = id;
+    header.len = len;
+    header.headerCrc = CalcCrc32(WSF_NVM_CRC_INIT_VALUE, sizeof(header.id) + sizeof(header.len),
+                                 (uint8_t *)&header);
+    header.dataCrc = CalcCrc32(WSF_NVM_CRC_INIT_VALUE, len, pData);
+    wsfNvmProgram(storageAddr, (const uint8_t *)&header, sizeof(header));
+    wsfNvmProgram(storageAddr + sizeof(header), pData, len);
+
+    wsfNvmCb.freeAddr += WSF_NVM_RECORD_SIZE(len);
+    wsfNvmCb.usedAddr = wsfNvmCb.freeAddr;
+
+    /* Scratch out the previous copy only once the new one is complete. */
+    wsfNvmScratch(id, storageAddr);
+    wsfNvmDirAdd(id, storageAddr);
+    written = TRUE;
+
+    if ((endAddr - wsfNvmCb.freeAddr < WSF_NVM_COMPACTION_THRESHOLD) &&
+        (wsfNvmCb.deadBytes >= WSF_NVM_COMPACTION_THRESHOLD))
     {
-      /* Calculate CRC of header itself. */
-      headerCrc = CalcCrc32(WSF_NVM_CRC_INIT_VALUE, sizeof(header.id) + sizeof(header.len),
-                            (uint8_t *)&header);
-
-      if (headerCrc != header.headerCrc)
-      {
-        /* Corrupt header. */
-        /* TODO: Catastrophic failure? */
-        break;
-      }
-      else if (header.id == id)
-      {
-        /* Valid header and matching ID - scratch header out. */
-        header.id = WSF_NVM_RESERVED_FILECODE;
-        header.headerCrc = 0;
-        header.dataCrc = 0;
-        am_hal_flash_program_main(
-          AM_HAL_FLASH_PROGRAM_KEY, (uint32_t *)&header,
-          (uint32_t *)storageAddr, sizeof(header) / WSF_FLASH_WORD_SIZE);
-      }
+      wsfNvmCompact();
     }
-
-    /* Move to next stored data block and read header. */
-    storageAddr += WSF_NVM_WORD_ALIGN(header.len) + sizeof(header);
-    memcpy(&header, (const void *)storageAddr, sizeof(header));
-  } while(1);
-
-  /* After cycling through all headers, create a new stored data header and store data */
-  header.id = id;
-  header.len = len;
-  header.headerCrc = CalcCrc32(WSF_NVM_CRC_INIT_VALUE, sizeof(header.id) + sizeof(header.len),
-                               (uint8_t *)&header);
-  header.dataCrc = CalcCrc32(WSF_NVM_CRC_INIT_VALUE, len, pData);
-  am_hal_flash_program_main(
-    AM_HAL_FLASH_PROGRAM_KEY, (uint32_t *)&header,
-    (uint32_t *)storageAddr, sizeof(header) / WSF_FLASH_WORD_SIZE);
-  am_hal_flash_program_main(
-    AM_HAL_FLASH_PROGRAM_KEY, (uint32_t *)pData,
-    (uint32_t *)(storageAddr + sizeof(header)), len / WSF_FLASH_WORD_SIZE);
+  }
 
   if (compCback)
   {
-    compCback(TRUE);
+    compCback(written);
   }
-  return TRUE;
+  return written;
 }
 
 /*************************************************************************************************/
@@ -239,53 +855,16 @@ bool_t WsfNvmWriteData(uint32_t id, const uint8_t *pData, uint16_t len, WsfNvmCo
 /*************************************************************************************************/
 bool_t WsfNvmEraseData(uint32_t id, WsfNvmCompEvent_t compCback)
 {
-  WsfNvmHeader_t header;
-  uint32_t headerCrc;
-  uint32_t storageAddr = WSF_NVM_START_ADDR;
-  bool_t erased = FALSE;
+  bool_t erased;
 
   WSF_ASSERT(!((id == WSF_NVM_RESERVED_FILECODE) || (id == WSF_NVM_UNUSED_FILECODE)));
 
-  /* Read first header. */
-  memcpy(&header, (const void *)storageAddr, sizeof(header));
-
-  do
+  if (wsfNvmCb.sectorAddr == 0)
   {
-    if (header.id == WSF_NVM_UNUSED_FILECODE)
-    {
-      /* Found unused entry at end of used storage. */
-      break;
-    }
-
-    /* Iterate through stored data headers, looking for existing matching stored data header. */
-    if (header.id != WSF_NVM_RESERVED_FILECODE)
-    {
-      headerCrc = CalcCrc32(WSF_NVM_CRC_INIT_VALUE, sizeof(header.id) + sizeof(header.len),
-                            (uint8_t *)&header);
-
-      if (headerCrc != header.headerCrc)
-      {
-        /* Corrupt header. */
-        /* TODO: Catastrophic failure? */
-        break;
-      }
-      else if (header.id == id)
-      {
-        header.id = WSF_NVM_RESERVED_FILECODE;
-        header.headerCrc = 0;
-        header.dataCrc = 0;
-        am_hal_flash_program_main(
-          AM_HAL_FLASH_PROGRAM_KEY, (uint32_t *)&header,
-          (uint32_t *)storageAddr, sizeof(header) / WSF_FLASH_WORD_SIZE);
-
-        erased = TRUE;
-      }
-    }
+    WsfNvmInit();
+  }
 
-    /* Move to next stored data block and read header. */
-    storageAddr += WSF_NVM_WORD_ALIGN(header.len) + sizeof(header);
-    memcpy(&header, (const void *)storageAddr, sizeof(header));
-  } while(1);
+  erased = wsfNvmScratch(id, wsfNvmCb.usedAddr);
 
   if (compCback)
   {
@@ -302,18 +881,22 @@ bool_t WsfNvmEraseData(uint32_t id, WsfNvmCompEvent_t compCback)
  *  \param  compCback          Erase callback.
  *
  *  \return if erase NVM successfully.
+ *
+ *  numOfSectors counts flash pages from WSF_NVM_START_ADDR.  Storage sectors are erased whole, so a
+ *  partly covered one is erased too.
  */
 /*************************************************************************************************/
 void WsfNvmEraseSector(uint32_t numOfSectors, WsfNvmCompEvent_t compCback)
 {
-  PalNvmEraseSector(numOfSectors * PAL_NVM_SECTOR_SIZE, WSF_NVM_START_ADDR);
-  for (uint32_t eraseAddr = WSF_NVM_START_ADDR; eraseAddr < wsfNvmCb.availAddr; eraseAddr += wsfNvmCb.sectorSize)
+  uint32_t endAddr = WSF_NVM_START_ADDR + WSF_NVM_PAGE_SIZE *
+                     ((numOfSectors < WSF_NVM_NUM_OF_PAGES) ? numOfSectors : WSF_NVM_NUM_OF_PAGES);
+
+  for (uint32_t sectorAddr = WSF_NVM_START_ADDR; sectorAddr < endAddr;
+       sectorAddr += WSF_NVM_SECTOR_SIZE)
   {
-    am_hal_flash_page_erase(
-        AM_HAL_FLASH_PROGRAM_KEY,
-        AM_HAL_FLASH_ADDR2INST(eraseAddr),
-        AM_HAL_FLASH_ADDR2PAGE(eraseAddr));
+    wsfNvmSectorErase(sectorAddr);
   }
+  WsfNvmInit();
 
   if (compCback)
   {
@@ -21,19 +21,20 @@
  *  limitations under the License.
  */
 /*************************************************************************************************/
+#include <string.h>
+
 #include "am_mcu_apollo.h"
 
 #include "wsf_types.h"
-#include "wsf_queue.h"
 #include "wsf_timer.h"
 #include "wsf_assert.h"
 #include "wsf_cs.h"
 #include "wsf_trace.h"
 
 #include "ble_config.h"
+#include "stimer_mux.h"
 
 #define CLOCK_PERIOD      WSF_OS_CLOCK_PERIOD
-#define CLOCK_SOURCE      WSF_OS_CLOCK_SOURCE
 
 /* convert seconds to timer ticks */
 #define WSF_TIMER_SEC_TO_TICKS(sec)         ((1000 / WSF_MS_PER_TICK) * (sec))
@@ -43,63 +44,210 @@
 
 #define CLK_TICKS_PER_WSF_TICKS             (WSF_MS_PER_TICK*CLOCK_PERIOD / 1000)
 
+/* Hierarchical timer wheel.  Level n has WSF_TIMER_WHEEL_SLOTS slots of
+ * WSF_TIMER_WHEEL_SLOTS^n ticks.  A timer sits in the highest level where its
+ * expiration and the current time differ, in the slot of its expiration digit
+ * at that level, and cascades down when the current time reaches the slot. */
+#define WSF_TIMER_WHEEL_BITS                5
+#define WSF_TIMER_WHEEL_SLOTS               (1 << WSF_TIMER_WHEEL_BITS)
+#define WSF_TIMER_WHEEL_MASK                (WSF_TIMER_WHEEL_SLOTS - 1)
+#define WSF_TIMER_WHEEL_LEVELS              4
+
+/* expirations beyond the range are kept at the range and placed again */
+#define WSF_TIMER_WHEEL_RANGE               (1UL << (WSF_TIMER_WHEEL_BITS * WSF_TIMER_WHEEL_LEVELS))
+
+#define WSF_TIMER_SHIFT(level)              ((level) * WSF_TIMER_WHEEL_BITS)
+#define WSF_TIMER_DIGIT(time, level)        (((time) >> WSF_TIMER_SHIFT(level)) & WSF_TIMER_WHEEL_MASK)
+
+/* slot of the expired timers list */
+#define WSF_TIMER_SLOT_EXPIRED              0xFF
+
 /**************************************************************************************************
   Global Variables
 **************************************************************************************************/
 
-wsfQueue_t  wsfTimerTimerQueue;     /*!< Timer queue */
+/*! \brief  Timer wheel slots. */
+static wsfTimer_t *wsfTimerWheel[WSF_TIMER_WHEEL_LEVELS * WSF_TIMER_WHEEL_SLOTS];
+
+/*! \brief  Non-empty slots of each level. */
+static uint32_t wsfTimerWheelMap[WSF_TIMER_WHEEL_LEVELS];
+
+/*! \brief  Expired timers in order of expiration. */
+static wsfTimer_t *wsfTimerExpiredHead;
+static wsfTimer_t *wsfTimerExpiredTail;
+
+/*! \brief  Current time of the timer service. */
+static wsfTimerTicks_t wsfTimerNow;
 
 /*! \brief  Last RTC value read. */
 static uint32_t wsfTimerRtcLastTicks = 0;
 
-void am_stimer_cmpr4_isr(void)
-{
-  am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREE);
-
-  am_hal_stimer_int_disable(AM_HAL_STIMER_INT_COMPAREF);
-  am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREF);
+/*! \brief  Timers expired by the current update, and those which did not need a wake-up. */
+static uint32_t wsfTimerUpdateExpired;
+static uint32_t wsfTimerSavedWakeups;
 
+/*************************************************************************************************/
+/*!
+ *  \brief  Wake the timer service, called by the STIMER deadline multiplexer.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfTimerWakeHandler(void)
+{
   WsfTaskSetReady(0, WSF_TIMER_EVENT);
 }
 
-void am_stimer_cmpr5_isr(void)
+/*************************************************************************************************/
+/*!
+ *  \brief  Add a timer to the expired list and set its task ready.
+ *
+ *  \param  pTimer  Pointer to timer.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfTimerExpire(wsfTimer_t *pTimer)
 {
-  am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREF);
+  pTimer->slot = WSF_TIMER_SLOT_EXPIRED;
+  pTimer->pNext = NULL;
+  pTimer->pPrev = wsfTimerExpiredTail;
 
-  WsfTaskSetReady(0, WSF_TIMER_EVENT);
+  if (wsfTimerExpiredTail != NULL)
+  {
+    wsfTimerExpiredTail->pNext = pTimer;
+  }
+  else
+  {
+    wsfTimerExpiredHead = pTimer;
+  }
+  wsfTimerExpiredTail = pTimer;
+  wsfTimerUpdateExpired++;
+
+  /* timer expired; set task for this timer as ready */
+  WsfTaskSetReady(pTimer->handlerId, WSF_TIMER_EVENT);
 }
 
 /*************************************************************************************************/
 /*!
- *  \brief  Remove a timer from queue.  Note this function does not lock task scheduling.
+ *  \brief  Place a timer in the wheel slot of its expiration, or in the expired list.
  *
  *  \param  pTimer  Pointer to timer.
  *
  *  \return None.
  */
 /*************************************************************************************************/
-static void wsfTimerRemove(wsfTimer_t *pTimer)
+static void wsfTimerPlace(wsfTimer_t *pTimer)
 {
-  wsfTimer_t  *pElem;
-  wsfTimer_t  *pPrev = NULL;
+  wsfTimerTicks_t delta = pTimer->expiry - wsfTimerNow;
+  wsfTimerTicks_t key;
+  wsfTimerTicks_t diff;
+  uint8_t level;
+  uint8_t slot;
 
-  pElem = (wsfTimer_t *) wsfTimerTimerQueue.pHead;
+  if ((int32_t)delta <= 0)
+  {
+    wsfTimerExpire(pTimer);
+    return;
+  }
 
-  /* find timer in queue */
-  while (pElem != NULL)
+  key = (delta < WSF_TIMER_WHEEL_RANGE) ? pTimer->expiry : (wsfTimerNow + WSF_TIMER_WHEEL_RANGE - 1);
+
+  /* highest level where the key and the current time differ, the top level also takes the
+   * expirations past the end of the current top level round */
+  diff = key ^ wsfTimerNow;
+  for (level = WSF_TIMER_WHEEL_LEVELS - 1; level > 0; level--)
   {
-    if (pElem == pTimer)
+    if ((diff >> WSF_TIMER_SHIFT(level)) != 0)
     {
       break;
     }
-    pPrev = pElem;
-    pElem = pElem->pNext;
   }
 
-  /* if timer found remove from queue */
-  if (pElem != NULL)
+  slot = (level * WSF_TIMER_WHEEL_SLOTS) + WSF_TIMER_DIGIT(key, level);
+
+  pTimer->slot = slot;
+  pTimer->pPrev = NULL;
+  pTimer->pNext = wsfTimerWheel[slot];
+  if (pTimer->pNext != NULL)
   {
-    WsfQueueRemove(&wsfTimerTimerQueue, pTimer, pPrev);
+    pTimer->pNext->pPrev = pTimer;
+  }
+  wsfTimerWheel[slot] = pTimer;
+  wsfTimerWheelMap[level] |= 1UL << WSF_TIMER_DIGIT(key, level);
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Unlink a timer from its wheel slot or from the expired list.
+ *
+ *  \param  pTimer  Pointer to timer.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfTimerUnlink(wsfTimer_t *pTimer)
+{
+  if (pTimer->slot == WSF_TIMER_SLOT_EXPIRED)
+  {
+    if (pTimer->pPrev != NULL)
+    {
+      pTimer->pPrev->pNext = pTimer->pNext;
+    }
+    else
+    {
+      wsfTimerExpiredHead = pTimer->pNext;
+    }
+    if (pTimer->pNext != NULL)
+    {
+      pTimer->pNext->pPrev = pTimer->pPrev;
+    }
+    else
+    {
+      wsfTimerExpiredTail = pTimer->pPrev;
+    }
+  }
+  else
+  {
+    if (pTimer->pPrev != NULL)
+    {
+      pTimer->pPrev->pNext = pTimer->pNext;
+    }
+    else
+    {
+      wsfTimerWheel[pTimer->slot] = pTimer->pNext;
+    }
+    if (pTimer->pNext != NULL)
+    {
+      pTimer->pNext->pPrev = pTimer->pPrev;
+    }
+
+    if (wsfTimerWheel[pTimer->slot] == NULL)
+    {
+      wsfTimerWheelMap[pTimer->slot / WSF_TIMER_WHEEL_SLOTS] &=
+        ~(1UL << (pTimer->slot % WSF_TIMER_WHEEL_SLOTS));
+    }
+  }
+
+  pTimer->pNext = NULL;
+  pTimer->pPrev = NULL;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Remove a timer from the timer service.  Note this function does not lock task
+ *          scheduling.
+ *
+ *  \param  pTimer  Pointer to timer.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfTimerRemove(wsfTimer_t *pTimer)
+{
+  if (pTimer->isStarted)
+  {
+    wsfTimerUnlink(pTimer);
 
     pTimer->isStarted = FALSE;
   }
@@ -107,7 +255,75 @@ static void wsfTimerRemove(wsfTimer_t *pTimer)
 
 /*************************************************************************************************/
 /*!
- *  \brief  Insert a timer into the queue sorted by the timer expiration.
+ *  \brief  Find the next non-empty wheel slot.
+ *
+ *  \param  pTime   Returns the time the slot is reached.
+ *  \param  pLevel  Returns the level of the slot.
+ *
+ *  \return TRUE if a slot was found, FALSE if the wheel is empty.
+ */
+/*************************************************************************************************/
+static bool_t wsfTimerNextSlot(wsfTimerTicks_t *pTime, uint8_t *pLevel)
+{
+  wsfTimerTicks_t digit;
+  wsfTimerTicks_t base;
+  uint32_t later;
+  uint8_t level;
+
+  /* the slots of a level up to the current digit are empty, except at the top level, and a
+   * lower level slot is always reached before a higher level slot */
+  for (level = 0; level < WSF_TIMER_WHEEL_LEVELS; level++)
+  {
+    digit = WSF_TIMER_DIGIT(wsfTimerNow, level);
+    later = (digit == WSF_TIMER_WHEEL_MASK) ? 0 : (wsfTimerWheelMap[level] & (~0UL << (digit + 1)));
+    base = wsfTimerNow & ~((1UL << WSF_TIMER_SHIFT(level + 1)) - 1);
+
+    if (later == 0 && level == WSF_TIMER_WHEEL_LEVELS - 1 && wsfTimerWheelMap[level] != 0)
+    {
+      /* next top level round */
+      later = wsfTimerWheelMap[level];
+      base += 1UL << WSF_TIMER_SHIFT(level + 1);
+    }
+
+    if (later != 0)
+    {
+      *pTime = base | ((wsfTimerTicks_t)__builtin_ctz(later) << WSF_TIMER_SHIFT(level));
+      *pLevel = level;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Place again the timers of a wheel slot.
+ *
+ *  \param  slot    Wheel slot.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+static void wsfTimerCascade(uint8_t slot)
+{
+  wsfTimer_t  *pElem = wsfTimerWheel[slot];
+  wsfTimer_t  *pNext;
+
+  wsfTimerWheel[slot] = NULL;
+  wsfTimerWheelMap[slot / WSF_TIMER_WHEEL_SLOTS] &= ~(1UL << (slot % WSF_TIMER_WHEEL_SLOTS));
+
+  while (pElem != NULL)
+  {
+    pNext = pElem->pNext;
+    wsfTimerPlace(pElem);
+    pElem = pNext;
+  }
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Insert a timer into the timer wheel.
  *
  *  \param  pTimer  Pointer to timer.
  *  \param  ticks   Timer ticks until expiration.
@@ -117,8 +333,9 @@ static void wsfTimerRemove(wsfTimer_t *pTimer)
 /*************************************************************************************************/
 static void wsfTimerInsert(wsfTimer_t *pTimer, wsfTimerTicks_t ticks)
 {
-  wsfTimer_t  *pElem;
-  wsfTimer_t  *pPrev = NULL;
+  wsfTimerTicks_t slack;
+  wsfTimerTicks_t latest;
+  wsfTimerTicks_t bit;
 
   /* task schedule lock */
   WsfTaskLock();
@@ -129,24 +346,27 @@ static void wsfTimerInsert(wsfTimer_t *pTimer, wsfTimerTicks_t ticks)
     wsfTimerRemove(pTimer);
   }
 
+  /* expirations are compared modulo 2^32 */
+  if (ticks > INT32_MAX)
+  {
+    ticks = INT32_MAX;
+  }
+
   pTimer->isStarted = TRUE;
   pTimer->ticks = ticks;
+  pTimer->expiry = wsfTimerNow + ticks;
 
-  pElem = (wsfTimer_t *) wsfTimerTimerQueue.pHead;
-
-  /* find insertion point in queue */
-  while (pElem != NULL)
+  /* round the latest tolerated expiration down on the highest bit where it differs from the
+   * nominal one, unless the slack wraps */
+  slack = (pTimer->slack < (INT32_MAX - ticks)) ? pTimer->slack : (INT32_MAX - ticks);
+  latest = pTimer->expiry + slack;
+  if (slack > 0 && latest > pTimer->expiry)
   {
-    if (pTimer->ticks < pElem->ticks)
-    {
-      break;
-    }
-    pPrev = pElem;
-    pElem = pElem->pNext;
+    bit = 1UL << (31 - __builtin_clz(latest ^ pTimer->expiry));
+    pTimer->expiry = latest & ~(bit - 1);
   }
 
-  /* insert timer into queue */
-  WsfQueueInsert(&wsfTimerTimerQueue, pTimer, pPrev);
+  wsfTimerPlace(pTimer);
 
   /* task schedule unlock */
   WsfTaskUnlock();
@@ -162,22 +382,15 @@ static void wsfTimerInsert(wsfTimer_t *pTimer, wsfTimerTicks_t ticks)
 /*************************************************************************************************/
 void WsfTimerInit(void)
 {
-  WSF_QUEUE_INIT(&wsfTimerTimerQueue);
-
-  am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPAREE);
-  am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPAREF);
-  NVIC_EnableIRQ(STIMER_CMPR4_IRQn);
-  NVIC_EnableIRQ(STIMER_CMPR5_IRQn);
-
-  uint32_t oldCfg = am_hal_stimer_config(AM_HAL_STIMER_CFG_FREEZE);
-
-  am_hal_stimer_config(
-      (oldCfg & ~(AM_HAL_STIMER_CFG_FREEZE | CTIMER_STCFG_CLKSEL_Msk))
-      | CLOCK_SOURCE
-      | AM_HAL_STIMER_CFG_COMPARE_E_ENABLE
-      | AM_HAL_STIMER_CFG_COMPARE_F_ENABLE
-      );
+  memset(wsfTimerWheel, 0, sizeof(wsfTimerWheel));
+  memset(wsfTimerWheelMap, 0, sizeof(wsfTimerWheelMap));
+  wsfTimerExpiredHead = NULL;
+  wsfTimerExpiredTail = NULL;
+  wsfTimerNow = 0;
+  wsfTimerSavedWakeups = 0;
 
+  stimer_mux_init();
+  stimer_mux_register(STIMER_MUX_BLE, wsfTimerWakeHandler, STIMER_MUX_TOLERANCE_BLE);
 
   wsfTimerRtcLastTicks = am_hal_stimer_counter_get();
 }
@@ -218,6 +431,33 @@ void WsfTimerStartMs(wsfTimer_t *pTimer, wsfTimerTicks_t ms)
   wsfTimerInsert(pTimer, WSF_TIMER_MS_TO_TICKS(ms));
 }
 
+/*************************************************************************************************/
+/*!
+ *  \brief  Set how late a timer may expire.
+ *
+ *  \param  pTimer  Pointer to timer.
+ *  \param  ms      Milliseconds the expiration may be delayed by.
+ *
+ *  \return None.
+ */
+/*************************************************************************************************/
+void WsfTimerSetSlackMs(wsfTimer_t *pTimer, wsfTimerTicks_t ms)
+{
+  pTimer->slack = WSF_TIMER_MS_TO_TICKS(ms);
+}
+
+/*************************************************************************************************/
+/*!
+ *  \brief  Return the number of timers which expired in the same update as another one.
+ *
+ *  \return Number of wake-ups saved.
+ */
+/*************************************************************************************************/
+uint32_t WsfTimerGetSavedWakeups(void)
+{
+  return wsfTimerSavedWakeups;
+}
+
 /*************************************************************************************************/
 /*!
  *  \brief  Stop a timer.
@@ -251,30 +491,59 @@ void WsfTimerStop(wsfTimer_t *pTimer)
 /*************************************************************************************************/
 void WsfTimerUpdate(wsfTimerTicks_t ticks)
 {
-  wsfTimer_t  *pElem;
+  wsfTimerTicks_t target;
+  wsfTimerTicks_t time;
+  wsfTimer_t      *pElem;
+  wsfTimer_t      *pNext;
+  uint8_t         level;
+  uint8_t         slot;
 
   /* task schedule lock */
   WsfTaskLock();
 
-  pElem = (wsfTimer_t *) wsfTimerTimerQueue.pHead;
+  target = wsfTimerNow + ticks;
+  wsfTimerUpdateExpired = 0;
 
-  /* iterate over timer queue */
-  while (pElem != NULL)
+  /* jump from one non-empty slot to the next */
+  while (wsfTimerNow != target)
   {
-    /* decrement ticks while preventing underflow */
-    if (pElem->ticks > ticks)
+    if (!wsfTimerNextSlot(&time, &level) || ((time - wsfTimerNow) > (target - wsfTimerNow)))
     {
-      pElem->ticks -= ticks;
+      wsfTimerNow = target;
+      break;
     }
-    else
+
+    wsfTimerNow = time;
+
+    /* cascade the slots reached on each level */
+    for (level = WSF_TIMER_WHEEL_LEVELS - 1; level > 0; level--)
     {
-      pElem->ticks = 0;
+      if ((wsfTimerNow & ((1UL << WSF_TIMER_SHIFT(level)) - 1)) == 0)
+      {
+        slot = (level * WSF_TIMER_WHEEL_SLOTS) + WSF_TIMER_DIGIT(wsfTimerNow, level);
+        if (wsfTimerWheel[slot] != NULL)
+        {
+          wsfTimerCascade(slot);
+        }
+      }
+    }
 
-      /* timer expired; set task for this timer as ready */
-      WsfTaskSetReady(pElem->handlerId, WSF_TIMER_EVENT);
+    /* expire the level 0 slot, timers kept at the wheel range are placed again */
+    slot = WSF_TIMER_DIGIT(wsfTimerNow, 0);
+    pElem = wsfTimerWheel[slot];
+    while (pElem != NULL)
+    {
+      pNext = pElem->pNext;
+      wsfTimerUnlink(pElem);
+      wsfTimerPlace(pElem);
+      pElem = pNext;
     }
+  }
 
-    pElem = pElem->pNext;
+  /* all but the first timer expired by the update shared its wake-up */
+  if (wsfTimerUpdateExpired > 1)
+  {
+    wsfTimerSavedWakeups += wsfTimerUpdateExpired - 1;
   }
 
   /* task schedule unlock */
@@ -294,20 +563,49 @@ void WsfTimerUpdate(wsfTimerTicks_t ticks)
 /*************************************************************************************************/
 wsfTimerTicks_t WsfTimerNextExpiration(bool_t *pTimerRunning)
 {
-  wsfTimerTicks_t ticks;
+  wsfTimerTicks_t ticks = 0;
+  wsfTimerTicks_t time;
+  wsfTimerTicks_t span;
+  wsfTimerTicks_t delta;
+  wsfTimer_t      *pElem;
+  uint8_t         level;
 
   /* task schedule lock */
   WsfTaskLock();
 
-  if (wsfTimerTimerQueue.pHead == NULL)
+  *pTimerRunning = TRUE;
+
+  if (wsfTimerExpiredHead != NULL)
   {
-    *pTimerRunning = FALSE;
     ticks = 0;
   }
+  else if (wsfTimerNextSlot(&time, &level))
+  {
+    ticks = time - wsfTimerNow;
+
+    /* the first expiration in a higher level slot, or the slot itself if it only holds
+     * timers kept at the wheel range */
+    if (level > 0)
+    {
+      span = ticks + (1UL << WSF_TIMER_SHIFT(level));
+      delta = span;
+      for (pElem = wsfTimerWheel[(level * WSF_TIMER_WHEEL_SLOTS) + WSF_TIMER_DIGIT(time, level)];
+           pElem != NULL; pElem = pElem->pNext)
+      {
+        if ((pElem->expiry - wsfTimerNow) < delta)
+        {
+          delta = pElem->expiry - wsfTimerNow;
+        }
+      }
+      if (delta < span)
+      {
+        ticks = delta;
+      }
+    }
+  }
   else
   {
-    *pTimerRunning = TRUE;
-    ticks = ((wsfTimer_t *) wsfTimerTimerQueue.pHead)->ticks;
+    *pTimerRunning = FALSE;
   }
 
   /* task schedule unlock */
@@ -328,7 +626,6 @@ wsfTimerTicks_t WsfTimerNextExpiration(bool_t *pTimerRunning)
 wsfTimer_t *WsfTimerServiceExpired(wsfTaskId_t taskId)
 {
   wsfTimer_t  *pElem;
-  wsfTimer_t  *pPrev = NULL;
 
   /* Unused parameters */
   (void)taskId;
@@ -336,12 +633,10 @@ wsfTimer_t *WsfTimerServiceExpired(wsfTaskId_t taskId)
   /* task schedule lock */
   WsfTaskLock();
 
-  /* find expired timers in queue */
-  if (((pElem = (wsfTimer_t *) wsfTimerTimerQueue.pHead) != NULL) &&
-      (pElem->ticks == 0))
+  /* take the first expired timer */
+  if ((pElem = wsfTimerExpiredHead) != NULL)
   {
-    /* remove timer from queue */
-    WsfQueueRemove(&wsfTimerTimerQueue, pElem, pPrev);
+    wsfTimerUnlink(pElem);
 
     pElem->isStarted = FALSE;
 
@@ -377,24 +672,12 @@ void WsfTimerSleep(void)
 
   if (nextExpiration > 0)
   {
-    uint32_t sleep_ticks = nextExpiration * CLK_TICKS_PER_WSF_TICKS;
-    am_hal_stimer_compare_delta_set(4, sleep_ticks);
-    am_hal_stimer_compare_delta_set(5, sleep_ticks+1);
-
-    /* enable RTC interrupt */
-    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREE);
-    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREF);
-
-    am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPAREE);
-    am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPAREF);
+    /* the expiration is counted from the last update of the timer service */
+    stimer_mux_set(STIMER_MUX_BLE, wsfTimerRtcLastTicks + nextExpiration * CLK_TICKS_PER_WSF_TICKS);
   }
   else
   {
-    am_hal_stimer_int_disable(AM_HAL_STIMER_INT_COMPAREE);
-    am_hal_stimer_int_disable(AM_HAL_STIMER_INT_COMPAREF);
-
-    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREE);
-    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREF);
+    stimer_mux_clear(STIMER_MUX_BLE);
   }
 }
 
@@ -421,8 +704,8 @@ void WsfTimerSleepUpdate(void)
 
     if (wsfElapsed)
     {
-      /* update last ticks */
-      wsfTimerRtcLastTicks = current_ticks;
+      /* update last ticks, keeping the remainder of a timer tick */
+      wsfTimerRtcLastTicks += wsfElapsed * CLK_TICKS_PER_WSF_TICKS;
 
       /* update wsf timers */
       WsfTimerUpdate(wsfElapsed);
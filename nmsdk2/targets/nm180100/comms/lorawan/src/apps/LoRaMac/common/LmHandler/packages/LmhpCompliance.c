@@ -284,6 +284,9 @@ static void LmhpComplianceProcess( void )
     {
         ComplianceTestState.IsResetCmdPending = false;
 
+        // Store the pending context changes before they are lost
+        NvmDataMgmtFlush( );
+
         // Call platform MCU reset API
         BoardResetMcu( );
     }
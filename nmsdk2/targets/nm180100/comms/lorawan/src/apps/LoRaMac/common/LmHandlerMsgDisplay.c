@@ -31,6 +31,18 @@
 
 #include "LmHandlerMsgDisplay.h"
 
+/*!
+ * With DEFERRED_LOG_ENABLED the messages are recorded and printed later by
+ * the log consumer. Arguments must then be integers or constant strings.
+ */
+#if defined( DEFERRED_LOG_ENABLED )
+#include "deferred_log.h"
+
+#define DisplayPrintf( ... )    DEFERRED_LOG( __VA_ARGS__ )
+#else
+#define DisplayPrintf( ... )    am_util_stdio_printf( __VA_ARGS__ )
+#endif
+
 /*!
  * MAC status strings
  */
@@ -93,60 +105,55 @@ const char* EventInfoStatusStrings[] =
  */
 void PrintHexBuffer( uint8_t *buffer, uint8_t size )
 {
+#if defined( DEFERRED_LOG_ENABLED )
+    deferred_log_hex( buffer, size );
+#else
     uint8_t newline = 0;
 
     for( uint8_t i = 0; i < size; i++ )
     {
         if( newline != 0 )
         {
-            am_util_stdio_printf( "\n\r" );
+            DisplayPrintf( "\n\r" );
             newline = 0;
         }
 
-        am_util_stdio_printf( "%02X ", buffer[i] );
+        DisplayPrintf( "%02X ", buffer[i] );
 
         if( ( ( i + 1 ) % 16 ) == 0 )
         {
             newline = 1;
         }
     }
-    am_util_stdio_printf( "\n\r" );
+    DisplayPrintf( "\n\r" );
+#endif
 }
 
 void DisplayNvmDataChange( LmHandlerNvmContextStates_t state, uint16_t size )
 {
     if( state == LORAMAC_HANDLER_NVM_STORE )
     {
-        am_util_stdio_printf( "\n\r###### ============ CTXS STORED ============ ######\n\r" );
+        DisplayPrintf( "\n\r###### ============ CTXS STORED ============ ######\n\r" );
 
     }
     else
     {
-        am_util_stdio_printf( "\n\r###### =========== CTXS RESTORED =========== ######\n\r" );
+        DisplayPrintf( "\n\r###### =========== CTXS RESTORED =========== ######\n\r" );
     }
-    am_util_stdio_printf( "Size        : %i\n\r\n\r", size );
+    DisplayPrintf( "Size        : %i\n\r\n\r", size );
 }
 
 void DisplayNetworkParametersUpdate( CommissioningParams_t *commissioningParams )
 {
-    am_util_stdio_printf( "DevEui      : %02X", commissioningParams->DevEui[0] );
-    for( int i = 1; i < 8; i++ )
-    {
-        am_util_stdio_printf( "-%02X", commissioningParams->DevEui[i] );
-    }
-    am_util_stdio_printf( "\n\r" );
-    am_util_stdio_printf( "JoinEui     : %02X", commissioningParams->JoinEui[0] );
-    for( int i = 1; i < 8; i++ )
-    {
-        am_util_stdio_printf( "-%02X", commissioningParams->JoinEui[i] );
-    }
-    am_util_stdio_printf( "\n\r" );
-    am_util_stdio_printf( "Pin         : %02X", commissioningParams->SePin[0] );
-    for( int i = 1; i < 4; i++ )
-    {
-        am_util_stdio_printf( "-%02X", commissioningParams->SePin[i] );
-    }
-    am_util_stdio_printf( "\n\r\n\r" );
+    uint8_t *devEui = commissioningParams->DevEui;
+    uint8_t *joinEui = commissioningParams->JoinEui;
+    uint8_t *pin = commissioningParams->SePin;
+
+    DisplayPrintf( "DevEui      : %02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X\n\r",
+                   devEui[0], devEui[1], devEui[2], devEui[3], devEui[4], devEui[5], devEui[6], devEui[7] );
+    DisplayPrintf( "JoinEui     : %02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X\n\r",
+                   joinEui[0], joinEui[1], joinEui[2], joinEui[3], joinEui[4], joinEui[5], joinEui[6], joinEui[7] );
+    DisplayPrintf( "Pin         : %02X-%02X-%02X-%02X\n\r\n\r", pin[0], pin[1], pin[2], pin[3] );
 }
 
 void DisplayMacMcpsRequestUpdate( LoRaMacStatus_t status, McpsReq_t *mcpsReq, TimerTime_t nextTxIn )
@@ -155,37 +162,37 @@ void DisplayMacMcpsRequestUpdate( LoRaMacStatus_t status, McpsReq_t *mcpsReq, Ti
     {
         case MCPS_CONFIRMED:
         {
-            am_util_stdio_printf( "\n\r###### =========== MCPS-Request ============ ######\n\r" );
-            am_util_stdio_printf( "######            MCPS_CONFIRMED             ######\n\r");
-            am_util_stdio_printf( "###### ===================================== ######\n\r");
+            DisplayPrintf( "\n\r###### =========== MCPS-Request ============ ######\n\r"
+                           "######            MCPS_CONFIRMED             ######\n\r"
+                           "###### ===================================== ######\n\r" );
             break;
         }
         case MCPS_UNCONFIRMED:
         {
-            am_util_stdio_printf( "\n\r###### =========== MCPS-Request ============ ######\n\r" );
-            am_util_stdio_printf( "######           MCPS_UNCONFIRMED            ######\n\r");
-            am_util_stdio_printf( "###### ===================================== ######\n\r");
+            DisplayPrintf( "\n\r###### =========== MCPS-Request ============ ######\n\r"
+                           "######           MCPS_UNCONFIRMED            ######\n\r"
+                           "###### ===================================== ######\n\r" );
             break;
         }
         case MCPS_PROPRIETARY:
         {
-            am_util_stdio_printf( "\n\r###### =========== MCPS-Request ============ ######\n\r" );
-            am_util_stdio_printf( "######           MCPS_PROPRIETARY            ######\n\r");
-            am_util_stdio_printf( "###### ===================================== ######\n\r");
+            DisplayPrintf( "\n\r###### =========== MCPS-Request ============ ######\n\r"
+                           "######           MCPS_PROPRIETARY            ######\n\r"
+                           "###### ===================================== ######\n\r" );
             break;
         }
         default:
         {
-            am_util_stdio_printf( "\n\r###### =========== MCPS-Request ============ ######\n\r" );
-            am_util_stdio_printf( "######                MCPS_ERROR             ######\n\r");
-            am_util_stdio_printf( "###### ===================================== ######\n\r");
+            DisplayPrintf( "\n\r###### =========== MCPS-Request ============ ######\n\r"
+                           "######                MCPS_ERROR             ######\n\r"
+                           "###### ===================================== ######\n\r" );
             break;
         }
     }
-    am_util_stdio_printf( "STATUS      : %s\n\r", MacStatusStrings[status] );
+    DisplayPrintf( "STATUS      : %s\n\r", MacStatusStrings[status] );
     if( status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED )
     {
-        am_util_stdio_printf( "Next Tx in  : %lu [ms]\n\r", nextTxIn );
+        DisplayPrintf( "Next Tx in  : %lu [ms]\n\r", nextTxIn );
     }
 }
 
@@ -195,44 +202,44 @@ void DisplayMacMlmeRequestUpdate( LoRaMacStatus_t status, MlmeReq_t *mlmeReq, Ti
     {
         case MLME_JOIN:
         {
-            am_util_stdio_printf( "\n\r###### =========== MLME-Request ============ ######\n\r" );
-            am_util_stdio_printf( "######               MLME_JOIN               ######\n\r");
-            am_util_stdio_printf( "###### ===================================== ######\n\r");
+            DisplayPrintf( "\n\r###### =========== MLME-Request ============ ######\n\r"
+                           "######               MLME_JOIN               ######\n\r"
+                           "###### ===================================== ######\n\r" );
             break;
         }
         case MLME_LINK_CHECK:
         {
-            am_util_stdio_printf( "\n\r###### =========== MLME-Request ============ ######\n\r" );
-            am_util_stdio_printf( "######            MLME_LINK_CHECK            ######\n\r");
-            am_util_stdio_printf( "###### ===================================== ######\n\r");
+            DisplayPrintf( "\n\r###### =========== MLME-Request ============ ######\n\r"
+                           "######            MLME_LINK_CHECK            ######\n\r"
+                           "###### ===================================== ######\n\r" );
             break;
         }
         case MLME_DEVICE_TIME:
         {
-            am_util_stdio_printf( "\n\r###### =========== MLME-Request ============ ######\n\r" );
-            am_util_stdio_printf( "######            MLME_DEVICE_TIME           ######\n\r");
-            am_util_stdio_printf( "###### ===================================== ######\n\r");
+            DisplayPrintf( "\n\r###### =========== MLME-Request ============ ######\n\r"
+                           "######            MLME_DEVICE_TIME           ######\n\r"
+                           "###### ===================================== ######\n\r" );
             break;
         }
         case MLME_TXCW:
         {
-            am_util_stdio_printf( "\n\r###### =========== MLME-Request ============ ######\n\r" );
-            am_util_stdio_printf( "######               MLME_TXCW               ######\n\r");
-            am_util_stdio_printf( "###### ===================================== ######\n\r");
+            DisplayPrintf( "\n\r###### =========== MLME-Request ============ ######\n\r"
+                           "######               MLME_TXCW               ######\n\r"
+                           "###### ===================================== ######\n\r" );
             break;
         }
         default:
         {
-            am_util_stdio_printf( "\n\r###### =========== MLME-Request ============ ######\n\r" );
-            am_util_stdio_printf( "######              MLME_UNKNOWN             ######\n\r");
-            am_util_stdio_printf( "###### ===================================== ######\n\r");
+            DisplayPrintf( "\n\r###### =========== MLME-Request ============ ######\n\r"
+                           "######              MLME_UNKNOWN             ######\n\r"
+                           "###### ===================================== ######\n\r" );
             break;
         }
     }
-    am_util_stdio_printf( "STATUS      : %s\n\r", MacStatusStrings[status] );
+    DisplayPrintf( "STATUS      : %s\n\r", MacStatusStrings[status] );
     if( status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED )
     {
-        am_util_stdio_printf( "Next Tx in  : %lu [ms]\n\r", nextTxIn );
+        DisplayPrintf( "Next Tx in  : %lu [ms]\n\r", nextTxIn );
     }
 }
 
@@ -242,20 +249,21 @@ void DisplayJoinRequestUpdate( LmHandlerJoinParams_t *params )
     {
         if( params->Status == LORAMAC_HANDLER_SUCCESS )
         {
-            am_util_stdio_printf( "###### ===========   JOINED     ============ ######\n\r" );
-            am_util_stdio_printf( "\n\rOTAA\n\r\n\r" );
-            am_util_stdio_printf( "DevAddr     :  %08lX\n\r", params->CommissioningParams->DevAddr );
-            am_util_stdio_printf( "\n\r\n\r" );
-            am_util_stdio_printf( "DATA RATE   : DR_%d\n\r\n\r", params->Datarate );
+            DisplayPrintf( "###### ===========   JOINED     ============ ######\n\r"
+                           "\n\rOTAA\n\r\n\r"
+                           "DevAddr     :  %08lX\n\r"
+                           "\n\r\n\r"
+                           "DATA RATE   : DR_%d\n\r\n\r",
+                           params->CommissioningParams->DevAddr, params->Datarate );
         }
     }
 #if ( OVER_THE_AIR_ACTIVATION == 0 )
     else
     {
-        am_util_stdio_printf( "###### ===========   JOINED     ============ ######\n\r" );
-        am_util_stdio_printf( "\n\rABP\n\r\n\r" );
-        am_util_stdio_printf( "DevAddr     : %08lX\n\r", params->CommissioningParams->DevAddr );
-        am_util_stdio_printf( "\n\r\n\r" );
+        DisplayPrintf( "###### ===========   JOINED     ============ ######\n\r" );
+        DisplayPrintf( "\n\rABP\n\r\n\r" );
+        DisplayPrintf( "DevAddr     : %08lX\n\r", params->CommissioningParams->DevAddr );
+        DisplayPrintf( "\n\r\n\r" );
     }
 #endif
 }
@@ -266,50 +274,50 @@ void DisplayTxUpdate( LmHandlerTxParams_t *params )
 
     if( params->IsMcpsConfirm == 0 )
     {
-        am_util_stdio_printf( "\n\r###### =========== MLME-Confirm ============ ######\n\r" );
-        am_util_stdio_printf( "STATUS      : %s\n\r", EventInfoStatusStrings[params->Status] );
+        DisplayPrintf( "\n\r###### =========== MLME-Confirm ============ ######\n\r" );
+        DisplayPrintf( "STATUS      : %s\n\r", EventInfoStatusStrings[params->Status] );
         return;
     }
 
-    am_util_stdio_printf( "\n\r###### =========== MCPS-Confirm ============ ######\n\r" );
-    am_util_stdio_printf( "STATUS      : %s\n\r", EventInfoStatusStrings[params->Status] );
-
-    am_util_stdio_printf( "\n\r###### =====   UPLINK FRAME %8lu   ===== ######\n\r", params->UplinkCounter );
-    am_util_stdio_printf( "\n\r" );
-
-    am_util_stdio_printf( "CLASS       : %c\n\r", "ABC"[LmHandlerGetCurrentClass( )] );
-    am_util_stdio_printf( "\n\r" );
-    am_util_stdio_printf( "TX PORT     : %d\n\r", params->AppData.Port );
+    DisplayPrintf( "\n\r###### =========== MCPS-Confirm ============ ######\n\r"
+                   "STATUS      : %s\n\r"
+                   "\n\r###### =====   UPLINK FRAME %8lu   ===== ######\n\r"
+                   "\n\r"
+                   "CLASS       : %c\n\r"
+                   "\n\r"
+                   "TX PORT     : %d\n\r",
+                   EventInfoStatusStrings[params->Status], params->UplinkCounter,
+                   "ABC"[LmHandlerGetCurrentClass( )], params->AppData.Port );
 
     if( params->AppData.BufferSize != 0 )
     {
-        am_util_stdio_printf( "TX DATA     : " );
+        DisplayPrintf( "TX DATA     : " );
         if( params->MsgType == LORAMAC_HANDLER_CONFIRMED_MSG )
         {
-            am_util_stdio_printf( "CONFIRMED - %s\n\r", ( params->AckReceived != 0 ) ? "ACK" : "NACK" );
+            DisplayPrintf( "CONFIRMED - %s\n\r", ( params->AckReceived != 0 ) ? "ACK" : "NACK" );
         }
         else
         {
-            am_util_stdio_printf( "UNCONFIRMED\n\r" );
+            DisplayPrintf( "UNCONFIRMED\n\r" );
         }
         PrintHexBuffer( params->AppData.Buffer, params->AppData.BufferSize );
     }
 
-    am_util_stdio_printf( "\n\r" );
-    am_util_stdio_printf( "DATA RATE   : DR_%d\n\r", params->Datarate );
+    DisplayPrintf( "\n\r"
+                   "DATA RATE   : DR_%d\n\r", params->Datarate );
 
     mibGet.Type  = MIB_CHANNELS;
     if( LoRaMacMibGetRequestConfirm( &mibGet ) == LORAMAC_STATUS_OK )
     {
-        am_util_stdio_printf( "U/L FREQ    : %lu\n\r", mibGet.Param.ChannelList[params->Channel].Frequency );
+        DisplayPrintf( "U/L FREQ    : %lu\n\r", mibGet.Param.ChannelList[params->Channel].Frequency );
     }
 
-    am_util_stdio_printf( "TX POWER    : %d\n\r", params->TxPower );
+    DisplayPrintf( "TX POWER    : %d\n\r", params->TxPower );
 
     mibGet.Type  = MIB_CHANNELS_MASK;
     if( LoRaMacMibGetRequestConfirm( &mibGet ) == LORAMAC_STATUS_OK )
     {
-        am_util_stdio_printf("CHANNEL MASK: ");
+        DisplayPrintf("CHANNEL MASK: ");
         switch( LmHandlerGetActiveRegion( ) )
         {
             case LORAMAC_REGION_AS923:
@@ -320,7 +328,7 @@ void DisplayTxUpdate( LmHandlerTxParams_t *params )
             case LORAMAC_REGION_EU433:
             case LORAMAC_REGION_RU864:
             {
-                am_util_stdio_printf( "%04X ", mibGet.Param.ChannelsMask[0] );
+                DisplayPrintf( "%04X ", mibGet.Param.ChannelsMask[0] );
                 break;
             }
             case LORAMAC_REGION_AU915:
@@ -329,20 +337,20 @@ void DisplayTxUpdate( LmHandlerTxParams_t *params )
             {
                 for( uint8_t i = 0; i < 5; i++)
                 {
-                    am_util_stdio_printf( "%04X ", mibGet.Param.ChannelsMask[i] );
+                    DisplayPrintf( "%04X ", mibGet.Param.ChannelsMask[i] );
                 }
                 break;
             }
             default:
             {
-                am_util_stdio_printf( "\n\r###### ========= Unknown Region ============ ######" );
+                DisplayPrintf( "\n\r###### ========= Unknown Region ============ ######" );
                 break;
             }
         }
-        am_util_stdio_printf("\n\r");
+        DisplayPrintf("\n\r");
     }
 
-    am_util_stdio_printf( "\n\r" );
+    DisplayPrintf( "\n\r" );
 }
 
 void DisplayRxUpdate( LmHandlerAppData_t *appData, LmHandlerRxParams_t *params )
@@ -351,32 +359,31 @@ void DisplayRxUpdate( LmHandlerAppData_t *appData, LmHandlerRxParams_t *params )
 
     if( params->IsMcpsIndication == 0 )
     {
-        am_util_stdio_printf( "\n\r###### ========== MLME-Indication ========== ######\n\r" );
-        am_util_stdio_printf( "STATUS      : %s\n\r", EventInfoStatusStrings[params->Status] );
+        DisplayPrintf( "\n\r###### ========== MLME-Indication ========== ######\n\r" );
+        DisplayPrintf( "STATUS      : %s\n\r", EventInfoStatusStrings[params->Status] );
         return;
     }
 
-    am_util_stdio_printf( "\n\r###### ========== MCPS-Indication ========== ######\n\r" );
-    am_util_stdio_printf( "STATUS      : %s\n\r", EventInfoStatusStrings[params->Status] );
-
-    am_util_stdio_printf( "\n\r###### =====  DOWNLINK FRAME %8lu  ===== ######\n\r", params->DownlinkCounter );
-
-    am_util_stdio_printf( "RX WINDOW   : %s\n\r", slotStrings[params->RxSlot] );
-    
-    am_util_stdio_printf( "RX PORT     : %d\n\r", appData->Port );
+    DisplayPrintf( "\n\r###### ========== MCPS-Indication ========== ######\n\r"
+                   "STATUS      : %s\n\r"
+                   "\n\r###### =====  DOWNLINK FRAME %8lu  ===== ######\n\r"
+                   "RX WINDOW   : %s\n\r"
+                   "RX PORT     : %d\n\r",
+                   EventInfoStatusStrings[params->Status], params->DownlinkCounter,
+                   slotStrings[params->RxSlot], appData->Port );
 
     if( appData->BufferSize != 0 )
     {
-        am_util_stdio_printf( "RX DATA     : \n\r" );
+        DisplayPrintf( "RX DATA     : \n\r" );
         PrintHexBuffer( appData->Buffer, appData->BufferSize );
     }
 
-    am_util_stdio_printf( "\n\r" );
-    am_util_stdio_printf( "DATA RATE   : DR_%d\n\r", params->Datarate );
-    am_util_stdio_printf( "RX RSSI     : %d\n\r", params->Rssi );
-    am_util_stdio_printf( "RX SNR      : %d\n\r", params->Snr );
-
-    am_util_stdio_printf( "\n\r" );
+    DisplayPrintf( "\n\r"
+                   "DATA RATE   : DR_%d\n\r"
+                   "RX RSSI     : %d\n\r"
+                   "RX SNR      : %d\n\r"
+                   "\n\r",
+                   params->Datarate, params->Rssi, params->Snr );
 }
 
 void DisplayBeaconUpdate( LoRaMacHandlerBeaconParams_t *params )
@@ -386,31 +393,31 @@ void DisplayBeaconUpdate( LoRaMacHandlerBeaconParams_t *params )
         default:
         case LORAMAC_HANDLER_BEACON_ACQUIRING:
         {
-            am_util_stdio_printf( "\n\r###### ========= BEACON ACQUIRING ========== ######\n\r" );
+            DisplayPrintf( "\n\r###### ========= BEACON ACQUIRING ========== ######\n\r" );
             break;
         }
         case LORAMAC_HANDLER_BEACON_LOST:
         {
-            am_util_stdio_printf( "\n\r###### ============ BEACON LOST ============ ######\n\r" );
+            DisplayPrintf( "\n\r###### ============ BEACON LOST ============ ######\n\r" );
             break;
         }
         case LORAMAC_HANDLER_BEACON_RX:
         {
-            am_util_stdio_printf( "\n\r###### ===== BEACON %8lu ==== ######\n\r", params->Info.Time.Seconds );
-            am_util_stdio_printf( "GW DESC     : %d\n\r", params->Info.GwSpecific.InfoDesc );
-            am_util_stdio_printf( "GW INFO     : " );
+            DisplayPrintf( "\n\r###### ===== BEACON %8lu ==== ######\n\r", params->Info.Time.Seconds );
+            DisplayPrintf( "GW DESC     : %d\n\r", params->Info.GwSpecific.InfoDesc );
+            DisplayPrintf( "GW INFO     : " );
             PrintHexBuffer( params->Info.GwSpecific.Info, 6 );
-            am_util_stdio_printf( "\n\r" );
-            am_util_stdio_printf( "FREQ        : %lu\n\r", params->Info.Frequency );
-            am_util_stdio_printf( "DATA RATE   : DR_%d\n\r", params->Info.Datarate );
-            am_util_stdio_printf( "RX RSSI     : %d\n\r", params->Info.Rssi );
-            am_util_stdio_printf( "RX SNR      : %d\n\r", params->Info.Snr );
-            am_util_stdio_printf( "\n\r" );
+            DisplayPrintf( "\n\r" );
+            DisplayPrintf( "FREQ        : %lu\n\r", params->Info.Frequency );
+            DisplayPrintf( "DATA RATE   : DR_%d\n\r", params->Info.Datarate );
+            DisplayPrintf( "RX RSSI     : %d\n\r", params->Info.Rssi );
+            DisplayPrintf( "RX SNR      : %d\n\r", params->Info.Snr );
+            DisplayPrintf( "\n\r" );
             break;
         }
         case LORAMAC_HANDLER_BEACON_NRX:
         {
-            am_util_stdio_printf( "\n\r###### ======== BEACON NOT RECEIVED ======== ######\n\r" );
+            DisplayPrintf( "\n\r###### ======== BEACON NOT RECEIVED ======== ######\n\r" );
             break;
         }
     }
@@ -418,14 +425,14 @@ void DisplayBeaconUpdate( LoRaMacHandlerBeaconParams_t *params )
 
 void DisplayClassUpdate( DeviceClass_t deviceClass )
 {
-    am_util_stdio_printf( "\n\r\n\r###### ===== Switch to Class %c done.  ===== ######\n\r\n\r", "ABC"[deviceClass] );
+    DisplayPrintf( "\n\r\n\r###### ===== Switch to Class %c done.  ===== ######\n\r\n\r", "ABC"[deviceClass] );
 }
 
 void DisplayAppInfo( const char* appName, const Version_t* appVersion, const Version_t* gitHubVersion )
 {
-    am_util_stdio_printf( "\n\r###### ===================================== ######\n\r\n\r" );
-    am_util_stdio_printf( "Application name   : %s\n\r", appName );
-    am_util_stdio_printf( "Application version: %d.%d.%d\n\r", appVersion->Fields.Major, appVersion->Fields.Minor, appVersion->Fields.Patch );
-    am_util_stdio_printf( "GitHub base version: %d.%d.%d\n\r", gitHubVersion->Fields.Major, gitHubVersion->Fields.Minor, gitHubVersion->Fields.Patch );
-    am_util_stdio_printf( "\n\r###### ===================================== ######\n\r\n\r" );
+    DisplayPrintf( "\n\r###### ===================================== ######\n\r\n\r" );
+    DisplayPrintf( "Application name   : %s\n\r", appName );
+    DisplayPrintf( "Application version: %d.%d.%d\n\r", appVersion->Fields.Major, appVersion->Fields.Minor, appVersion->Fields.Patch );
+    DisplayPrintf( "GitHub base version: %d.%d.%d\n\r", gitHubVersion->Fields.Major, gitHubVersion->Fields.Minor, gitHubVersion->Fields.Patch );
+    DisplayPrintf( "\n\r###### ===================================== ######\n\r\n\r" );
 }
@@ -34,8 +34,11 @@
 #include <stdio.h>
 #include "utilities.h"
 #include "nvmm.h"
+#include "timer.h"
 #include "LoRaMac.h"
+#include "LoRaMacCrypto.h"
 #include "NvmDataMgmt.h"
+#include "lorawan_config.h"
 
 /*!
  * Enables/Disables the context storage management storage.
@@ -45,14 +48,326 @@
 #define CONTEXT_MANAGEMENT_ENABLED         1
 #endif
 
+/*!
+ * Enables/Disables the delta storage. When enabled, a RAM shadow of the
+ * stored context is kept and only the bytes that changed since the last
+ * store are written to the NVM.
+ */
+#ifndef NVM_DATA_MGMT_DELTA_ENABLED
+#define NVM_DATA_MGMT_DELTA_ENABLED        1
+#endif
+
+/*!
+ * Unchanged bytes between two changed ranges that are written anyway to
+ * merge both ranges into a single NVM write.
+ */
+#ifndef NVM_DATA_MGMT_DELTA_GAP
+#define NVM_DATA_MGMT_DELTA_GAP            8
+#endif
+
+/*!
+ * Time in ms during which context changes are accumulated before being
+ * stored together. Meanwhile only the frame counter record is written.
+ * Changes of the secure element, which happen on join, are always stored
+ * immediately. Set to 0 to store all changes immediately.
+ */
+#ifndef NVM_DATA_MGMT_COALESCE_WINDOW
+#define NVM_DATA_MGMT_COALESCE_WINDOW      0
+#endif
+
+/*!
+ * Time in ms by which the end of the coalescing window may be delayed, so
+ * that the store shares a wake up with another timer.
+ */
+#ifndef NVM_DATA_MGMT_COALESCE_SLACK
+#define NVM_DATA_MGMT_COALESCE_SLACK       ( NVM_DATA_MGMT_COALESCE_WINDOW / 8 )
+#endif
+
+/*!
+ * Frame counter record, stored after the context. It is written on every
+ * store so that the counters which must never be reused or rolled back
+ * survive a reset that happens before the pending context changes are
+ * stored.
+ */
+typedef struct sNvmDataMgmtFCnt
+{
+    /*!
+     * Uplink frame counter
+     */
+    uint32_t FCntUp;
+    /*!
+     * Network downlink frame counter
+     */
+    uint32_t NFCntDown;
+    /*!
+     * Application downlink frame counter
+     */
+    uint32_t AFCntDown;
+    /*!
+     * LoRaWAN 1.0 downlink frame counter
+     */
+    uint32_t FCntDown;
+    /*!
+     * Device nonce of the last JoinRequest
+     */
+    uint16_t DevNonce;
+    /*!
+     * Unused, keeps the CRC aligned
+     */
+    uint16_t Reserved;
+    /*!
+     * CRC32 value of the record
+     */
+    uint32_t Crc32;
+}NvmDataMgmtFCnt_t;
+
+/*!
+ * Shadow flag of the frame counter record
+ */
+#define NVM_DATA_MGMT_FLAG_FCNT            0x8000
 
 static uint16_t NvmNotifyFlags = 0;
 
+#if( ( CONTEXT_MANAGEMENT_ENABLED == 1 ) && ( NVM_DATA_MGMT_COALESCE_WINDOW > 0 ) )
+/*!
+ * Timer ending the coalescing window
+ */
+static TimerEvent_t NvmCommitTimer;
+
+/*!
+ * Set when the accumulated changes are to be stored
+ */
+static volatile bool NvmCommitDue = false;
+
+/*!
+ * Last frame counter record written, valid when NvmFCntStored is set
+ */
+static NvmDataMgmtFCnt_t NvmFCntLast;
+static bool NvmFCntStored = false;
+
+static void OnNvmCommitTimerEvent( void* context )
+{
+    NvmCommitDue = true;
+}
+#endif
+
+#if( ( CONTEXT_MANAGEMENT_ENABLED == 1 ) && ( NVM_DATA_MGMT_DELTA_ENABLED == 1 ) )
+/*!
+ * Copy of the context and frame counter record as they are stored in the NVM
+ */
+static struct
+{
+    LoRaMacNvmData_t Context;
+    NvmDataMgmtFCnt_t FCnt;
+}NvmShadow;
+
+/*!
+ * Notify flags of the groups for which NvmShadow matches the NVM
+ */
+static uint16_t NvmShadowFlags = LORAMAC_NVM_NOTIFY_FLAG_NONE;
+#endif
+
 void NvmDataMgmtEvent( uint16_t notifyFlags )
 {
-    NvmNotifyFlags = notifyFlags;
+    NvmNotifyFlags |= notifyFlags;
+
+#if( ( CONTEXT_MANAGEMENT_ENABLED == 1 ) && ( NVM_DATA_MGMT_COALESCE_WINDOW > 0 ) )
+    // The window starts with the first change which is not stored yet. The
+    // timer interrupt wakes up the stack to process the store.
+    if( ( notifyFlags != LORAMAC_NVM_NOTIFY_FLAG_NONE ) && ( NvmCommitDue == false ) &&
+        ( TimerIsStarted( &NvmCommitTimer ) == false ) )
+    {
+        TimerInit( &NvmCommitTimer, OnNvmCommitTimerEvent );
+        TimerSetValue( &NvmCommitTimer, NVM_DATA_MGMT_COALESCE_WINDOW );
+        TimerSetSlack( &NvmCommitTimer, NVM_DATA_MGMT_COALESCE_SLACK );
+        TimerStart( &NvmCommitTimer );
+    }
+#endif
 }
 
+#if( CONTEXT_MANAGEMENT_ENABLED == 1 )
+/*!
+ * \brief Stores one group of the context
+ *
+ * \param [IN] data   Group data
+ * \param [IN] size   Size of the group
+ * \param [IN] offset Offset of the group in the context
+ * \param [IN] flag   Notify flag of the group
+ *
+ * \retval Number of bytes which were written to the NVM.
+ */
+static uint16_t NvmDataMgmtWrite( uint8_t* data, uint16_t size, uint16_t offset, uint16_t flag )
+{
+#if( NVM_DATA_MGMT_DELTA_ENABLED == 1 )
+    uint8_t* shadow = ( uint8_t* ) &NvmShadow + offset;
+    uint16_t dataSize = 0;
+    uint16_t start;
+    uint16_t end;
+    uint16_t length;
+
+    if( ( NvmShadowFlags & flag ) != flag )
+    {
+        // The NVM content is unknown, store the whole group
+        dataSize = NvmmWrite( data, size, offset );
+        if( dataSize == size )
+        {
+            memcpy1( shadow, data, size );
+            NvmShadowFlags |= flag;
+        }
+        return dataSize;
+    }
+
+    for( start = 0; start < size; start = end )
+    {
+        // Find the next changed range, absorbing short unchanged gaps
+        while( ( start < size ) && ( data[start] == shadow[start] ) )
+        {
+            start++;
+        }
+        if( start == size )
+        {
+            break;
+        }
+
+        end = start + 1;
+        for( uint16_t i = end; ( i < size ) && ( ( i - end ) < NVM_DATA_MGMT_DELTA_GAP ); i++ )
+        {
+            if( data[i] != shadow[i] )
+            {
+                end = i + 1;
+            }
+        }
+
+        length = end - start;
+        if( NvmmWrite( data + start, length, offset + start ) != length )
+        {
+            // Part of the group may have been written, store it whole next time
+            NvmShadowFlags &= ~flag;
+            break;
+        }
+        memcpy1( shadow + start, data + start, length );
+        dataSize += length;
+    }
+    return dataSize;
+#else
+    return NvmmWrite( data, size, offset );
+#endif
+}
+#endif
+
+#if( ( CONTEXT_MANAGEMENT_ENABLED == 1 ) && ( NVM_DATA_MGMT_COALESCE_WINDOW > 0 ) )
+/*!
+ * \brief Stores the frame counter record
+ *
+ * \param [IN] nvm Context holding the counters
+ *
+ * \retval Number of bytes which were written to the NVM.
+ */
+static uint16_t NvmDataMgmtStoreFCnt( LoRaMacNvmData_t* nvm )
+{
+    NvmDataMgmtFCnt_t record;
+    uint16_t dataSize;
+
+    record.FCntUp = nvm->Crypto.FCntList.FCntUp;
+    record.NFCntDown = nvm->Crypto.FCntList.NFCntDown;
+    record.AFCntDown = nvm->Crypto.FCntList.AFCntDown;
+    record.FCntDown = nvm->Crypto.FCntList.FCntDown;
+    record.DevNonce = nvm->Crypto.DevNonce;
+    record.Reserved = 0;
+    record.Crc32 = Crc32( ( uint8_t* ) &record, sizeof( record ) - sizeof( record.Crc32 ) );
+
+    dataSize = NvmDataMgmtWrite( ( uint8_t* ) &record, sizeof( record ), sizeof( LoRaMacNvmData_t ),
+                                 NVM_DATA_MGMT_FLAG_FCNT );
+
+    memcpy1( ( uint8_t* ) &NvmFCntLast, ( uint8_t* ) &record, sizeof( record ) );
+    NvmFCntStored = true;
+    return dataSize;
+}
+
+/*!
+ * \brief Checks whether the counters changed since the last frame counter
+ *        record was written
+ *
+ * \param [IN] nvm Context holding the counters
+ *
+ * \retval true if the frame counter record has to be written
+ */
+static bool NvmDataMgmtFCntChanged( LoRaMacNvmData_t* nvm )
+{
+    return ( NvmFCntStored == false ) ||
+           ( NvmFCntLast.FCntUp != nvm->Crypto.FCntList.FCntUp ) ||
+           ( NvmFCntLast.NFCntDown != nvm->Crypto.FCntList.NFCntDown ) ||
+           ( NvmFCntLast.AFCntDown != nvm->Crypto.FCntList.AFCntDown ) ||
+           ( NvmFCntLast.FCntDown != nvm->Crypto.FCntList.FCntDown ) ||
+           ( NvmFCntLast.DevNonce != nvm->Crypto.DevNonce );
+}
+
+/*!
+ * \brief Picks the most recent of two downlink frame counters
+ *
+ * \param [IN] stored Counter held by the frame counter record
+ * \param [IN] current Counter held by the restored context
+ *
+ * \retval Counter to be used
+ */
+static uint32_t NvmDataMgmtFCntDownMax( uint32_t stored, uint32_t current )
+{
+    // FCNT_DOWN_INITAL_VALUE means no downlink was received yet
+    if( current == FCNT_DOWN_INITAL_VALUE )
+    {
+        return stored;
+    }
+    if( stored == FCNT_DOWN_INITAL_VALUE )
+    {
+        return current;
+    }
+    return MAX( stored, current );
+}
+
+/*!
+ * \brief Applies the frame counter record to a restored context
+ *
+ * \param [IN] nvm Restored context
+ */
+static void NvmDataMgmtRestoreFCnt( LoRaMacNvmData_t* nvm )
+{
+    NvmDataMgmtFCnt_t record;
+    FCntList_t fCntList;
+
+    if( ( NvmmCrc32Check( sizeof( record ), sizeof( LoRaMacNvmData_t ) ) == false ) ||
+        ( NvmmRead( ( uint8_t* ) &record, sizeof( record ), sizeof( LoRaMacNvmData_t ) ) !=
+          sizeof( record ) ) )
+    {
+#if( NVM_DATA_MGMT_DELTA_ENABLED == 1 )
+        NvmShadowFlags &= ~NVM_DATA_MGMT_FLAG_FCNT;
+#endif
+        return;
+    }
+#if( NVM_DATA_MGMT_DELTA_ENABLED == 1 )
+    memcpy1( ( uint8_t* ) &NvmShadow.FCnt, ( uint8_t* ) &record, sizeof( record ) );
+#endif
+
+    // The context may predate the last uplinks, downlinks and join requests
+    fCntList = nvm->Crypto.FCntList;
+    fCntList.FCntUp = MAX( record.FCntUp, fCntList.FCntUp );
+    fCntList.NFCntDown = NvmDataMgmtFCntDownMax( record.NFCntDown, fCntList.NFCntDown );
+    fCntList.AFCntDown = NvmDataMgmtFCntDownMax( record.AFCntDown, fCntList.AFCntDown );
+    fCntList.FCntDown = NvmDataMgmtFCntDownMax( record.FCntDown, fCntList.FCntDown );
+
+    if( ( fCntList.FCntUp != nvm->Crypto.FCntList.FCntUp ) ||
+        ( fCntList.NFCntDown != nvm->Crypto.FCntList.NFCntDown ) ||
+        ( fCntList.AFCntDown != nvm->Crypto.FCntList.AFCntDown ) ||
+        ( fCntList.FCntDown != nvm->Crypto.FCntList.FCntDown ) ||
+        ( record.DevNonce > nvm->Crypto.DevNonce ) )
+    {
+        nvm->Crypto.FCntList = fCntList;
+        nvm->Crypto.DevNonce = MAX( record.DevNonce, nvm->Crypto.DevNonce );
+        nvm->Crypto.Crc32 = Crc32( ( uint8_t* ) &nvm->Crypto, sizeof( nvm->Crypto ) -
+                                                            sizeof( nvm->Crypto.Crc32 ) );
+    }
+}
+#endif
+
 uint16_t NvmDataMgmtStore( void )
 {
 #if( CONTEXT_MANAGEMENT_ENABLED == 1 )
@@ -69,17 +384,43 @@ uint16_t NvmDataMgmtStore( void )
         // There was no update.
         return 0;
     }
+
+#if( NVM_DATA_MGMT_COALESCE_WINDOW > 0 )
+    if( ( NvmCommitDue == false ) &&
+        ( ( NvmNotifyFlags & LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT ) == 0 ) )
+    {
+        // Keep accumulating changes, only the counters are stored meanwhile
+        if( NvmDataMgmtFCntChanged( nvm ) == false )
+        {
+            return 0;
+        }
+        if( LoRaMacStop( ) != LORAMAC_STATUS_OK )
+        {
+            return 0;
+        }
+        dataSize = NvmDataMgmtStoreFCnt( nvm );
+        LoRaMacStart( );
+        return dataSize;
+    }
+#endif
+
     if( LoRaMacStop( ) != LORAMAC_STATUS_OK )
     {
         return 0;
     }
 
+#if( NVM_DATA_MGMT_COALESCE_WINDOW > 0 )
+    dataSize += NvmDataMgmtStoreFCnt( nvm );
+    TimerStop( &NvmCommitTimer );
+    NvmCommitDue = false;
+#endif
+
     // Crypto
     if( ( NvmNotifyFlags & LORAMAC_NVM_NOTIFY_FLAG_CRYPTO ) ==
         LORAMAC_NVM_NOTIFY_FLAG_CRYPTO )
     {
-        dataSize += NvmmWrite( ( uint8_t* ) &nvm->Crypto, sizeof( nvm->Crypto ),
-                               offset );
+        dataSize += NvmDataMgmtWrite( ( uint8_t* ) &nvm->Crypto, sizeof( nvm->Crypto ),
+                                      offset, LORAMAC_NVM_NOTIFY_FLAG_CRYPTO );
     }
     offset += sizeof( nvm->Crypto );
 
@@ -87,8 +428,8 @@ uint16_t NvmDataMgmtStore( void )
     if( ( NvmNotifyFlags & LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 ) ==
         LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 )
     {
-        dataSize += NvmmWrite( ( uint8_t* ) &nvm->MacGroup1,
-                               sizeof( nvm->MacGroup1 ), offset );
+        dataSize += NvmDataMgmtWrite( ( uint8_t* ) &nvm->MacGroup1, sizeof( nvm->MacGroup1 ),
+                                      offset, LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1 );
     }
     offset += sizeof( nvm->MacGroup1 );
 
@@ -96,8 +437,8 @@ uint16_t NvmDataMgmtStore( void )
     if( ( NvmNotifyFlags & LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 ) ==
         LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 )
     {
-        dataSize += NvmmWrite( ( uint8_t* ) &nvm->MacGroup2,
-                               sizeof( nvm->MacGroup2 ), offset );
+        dataSize += NvmDataMgmtWrite( ( uint8_t* ) &nvm->MacGroup2, sizeof( nvm->MacGroup2 ),
+                                      offset, LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2 );
     }
     offset += sizeof( nvm->MacGroup2 );
 
@@ -105,8 +446,8 @@ uint16_t NvmDataMgmtStore( void )
     if( ( NvmNotifyFlags & LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT ) ==
         LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT )
     {
-        dataSize += NvmmWrite( ( uint8_t* ) &nvm->SecureElement, sizeof( nvm->SecureElement ),
-                               offset );
+        dataSize += NvmDataMgmtWrite( ( uint8_t* ) &nvm->SecureElement, sizeof( nvm->SecureElement ),
+                                      offset, LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT );
     }
     offset += sizeof( nvm->SecureElement );
 
@@ -114,8 +455,8 @@ uint16_t NvmDataMgmtStore( void )
     if( ( NvmNotifyFlags & LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 ) ==
         LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 )
     {
-        dataSize += NvmmWrite( ( uint8_t* ) &nvm->RegionGroup1,
-                               sizeof( nvm->RegionGroup1 ), offset );
+        dataSize += NvmDataMgmtWrite( ( uint8_t* ) &nvm->RegionGroup1, sizeof( nvm->RegionGroup1 ),
+                                      offset, LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP1 );
     }
     offset += sizeof( nvm->RegionGroup1 );
 
@@ -123,8 +464,8 @@ uint16_t NvmDataMgmtStore( void )
     if( ( NvmNotifyFlags & LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 ) ==
         LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 )
     {
-        dataSize += NvmmWrite( ( uint8_t* ) &nvm->RegionGroup2,
-                               sizeof( nvm->RegionGroup2 ), offset );
+        dataSize += NvmDataMgmtWrite( ( uint8_t* ) &nvm->RegionGroup2, sizeof( nvm->RegionGroup2 ),
+                                      offset, LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2 );
     }
     offset += sizeof( nvm->RegionGroup2 );
 
@@ -132,8 +473,8 @@ uint16_t NvmDataMgmtStore( void )
     if( ( NvmNotifyFlags & LORAMAC_NVM_NOTIFY_FLAG_CLASS_B ) ==
         LORAMAC_NVM_NOTIFY_FLAG_CLASS_B )
     {
-        dataSize += NvmmWrite( ( uint8_t* ) &nvm->ClassB, sizeof( nvm->ClassB ),
-                               offset );
+        dataSize += NvmDataMgmtWrite( ( uint8_t* ) &nvm->ClassB, sizeof( nvm->ClassB ),
+                                      offset, LORAMAC_NVM_NOTIFY_FLAG_CLASS_B );
     }
     offset += sizeof( nvm->ClassB );
 
@@ -148,6 +489,17 @@ uint16_t NvmDataMgmtStore( void )
 #endif
 }
 
+uint16_t NvmDataMgmtFlush( void )
+{
+#if( ( CONTEXT_MANAGEMENT_ENABLED == 1 ) && ( NVM_DATA_MGMT_COALESCE_WINDOW > 0 ) )
+    if( NvmNotifyFlags != LORAMAC_NVM_NOTIFY_FLAG_NONE )
+    {
+        NvmCommitDue = true;
+    }
+#endif
+    return NvmDataMgmtStore( );
+}
+
 uint16_t NvmDataMgmtRestore( void )
 {
 #if( CONTEXT_MANAGEMENT_ENABLED == 1 )
@@ -209,6 +561,13 @@ uint16_t NvmDataMgmtRestore( void )
     if( NvmmRead( ( uint8_t* ) nvm, sizeof( LoRaMacNvmData_t ), 0 ) ==
                   sizeof( LoRaMacNvmData_t ) )
     {
+#if( NVM_DATA_MGMT_DELTA_ENABLED == 1 )
+        memcpy1( ( uint8_t* ) &NvmShadow.Context, ( uint8_t* ) nvm, sizeof( LoRaMacNvmData_t ) );
+        NvmShadowFlags = 0xFFFF;
+#endif
+#if( NVM_DATA_MGMT_COALESCE_WINDOW > 0 )
+        NvmDataMgmtRestoreFCnt( nvm );
+#endif
         return sizeof( LoRaMacNvmData_t );
     }
 #endif
@@ -219,6 +578,13 @@ bool NvmDataMgmtFactoryReset( void )
 {
     uint16_t offset = 0;
 #if( CONTEXT_MANAGEMENT_ENABLED == 1 )
+#if( NVM_DATA_MGMT_DELTA_ENABLED == 1 )
+    NvmShadowFlags = LORAMAC_NVM_NOTIFY_FLAG_NONE;
+#endif
+#if( NVM_DATA_MGMT_COALESCE_WINDOW > 0 )
+    NvmFCntStored = false;
+#endif
+
     // Crypto
     if( NvmmReset( sizeof( LoRaMacCryptoNvmData_t ), offset ) == false )
     {
@@ -267,6 +633,12 @@ bool NvmDataMgmtFactoryReset( void )
         return false;
     }
     offset += sizeof( LoRaMacClassBNvmData_t );
+
+    // Frame counter record
+    if( NvmmReset( sizeof( NvmDataMgmtFCnt_t ), offset ) == false )
+    {
+        return false;
+    }
 #endif
     return true;
 }
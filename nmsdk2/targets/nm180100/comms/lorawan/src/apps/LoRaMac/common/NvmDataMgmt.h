@@ -56,6 +56,16 @@ void NvmDataMgmtEvent( uint16_t notifyFlags );
  */
 uint16_t NvmDataMgmtStore( void );
 
+/*!
+ * \brief Function which stores all the MAC data changed since the last
+ *        complete store into NVM, without waiting for the coalescing window
+ *        to elapse. To be called before the stack is stopped or the device
+ *        powered down.
+ *
+ * \retval Number of bytes which were stored.
+ */
+uint16_t NvmDataMgmtFlush( void );
+
 /*!
  * \brief Function which restores the MAC data from NVM, if required.
  *
@@ -33,14 +33,19 @@
 #include <am_mcu_apollo.h>
 #include <am_util.h>
 
+#include "NvmDataMgmt.h"
 #include "board.h"
 #include "eeprom_emulation.h"
 #include "lorawan_eeprom_config.h"
+#include "random_pool.h"
 #include "rtc-board.h"
 #include <sx126x-board.h>
 
 eeprom_handle_t lorawan_eeprom_handle;
 eeprom_page_t lorawan_eeprom_pages[LORAWAN_EEPROM_NUMBER_OF_PAGES];
+#if LORAWAN_EEPROM_INDEX_SIZE > 0
+static uint16_t lorawan_eeprom_index[LORAWAN_EEPROM_INDEX_SIZE];
+#endif
 
 void BoardCriticalSectionBegin(uint32_t *mask)
 {
@@ -57,6 +62,11 @@ void BoardInitPeriph(void)
     RtcInit();
 
     lorawan_eeprom_handle.pages = lorawan_eeprom_pages;
+#if LORAWAN_EEPROM_INDEX_SIZE > 0
+    lorawan_eeprom_handle.index = lorawan_eeprom_index;
+    lorawan_eeprom_handle.index_size = LORAWAN_EEPROM_INDEX_SIZE;
+#endif
+    lorawan_eeprom_handle.compaction_threshold = LORAWAN_EEPROM_COMPACTION_THRESHOLD;
     if (!eeprom_init(LORAWAN_EEPROM_START_ADDRESS, LORAWAN_EEPROM_NUMBER_OF_PAGES, &lorawan_eeprom_handle)) {
         eeprom_format(&lorawan_eeprom_handle);
     }
@@ -66,27 +76,16 @@ void BoardInitMcu(void) { SX126xIoInit(); }
 
 void BoardResetMcu(void)
 {
+    // Store the context changes still held back by the coalescing window.
+    NvmDataMgmtFlush();
+
     CRITICAL_SECTION_BEGIN();
     NVIC_SystemReset();
 }
 
 void BoardDeInitMcu(void) { SX126xIoDeInit(); }
 
-uint32_t BoardGetRandomSeed(void)
-{
-    am_util_id_t i;
-    uint32_t     ret;
-
-    am_util_id_device(&i);
-    ret = ~(i.sMcuCtrlDevice.ui32ChipID0);
-    ret ^= i.sMcuCtrlDevice.ui32ChipID1;
-    ret ^= i.sMcuCtrlDevice.ui32ChipRev << 3;
-    ret ^= i.sMcuCtrlDevice.ui32VendorID >> 3;
-    ret ^= i.sMcuCtrlDevice.ui32SKU << 6;
-    ret ^= i.sMcuCtrlDevice.ui32Qualified >> 6;
-
-    return ret;
-}
+uint32_t BoardGetRandomSeed(void) { return random_pool_get_u32(); }
 
 uint16_t BoardBatteryMeasureVolage(void) { return 0; }
 
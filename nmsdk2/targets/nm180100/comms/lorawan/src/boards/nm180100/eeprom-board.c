@@ -28,13 +28,21 @@
 
 uint8_t EepromMcuWriteBuffer( uint16_t addr, uint8_t *buffer, uint16_t size )
 {
+    eeprom_lock(&lorawan_eeprom_handle);
     eeprom_write_array_len(&lorawan_eeprom_handle, addr + 1, buffer, size);
+    eeprom_unlock(&lorawan_eeprom_handle);
     return 1;
 }
 
 uint8_t EepromMcuReadBuffer( uint16_t addr, uint8_t *buffer, uint16_t size )
 {
-    if (!eeprom_read_array_len(&lorawan_eeprom_handle, addr + 1, buffer, size))
+    uint32_t status;
+
+    eeprom_lock(&lorawan_eeprom_handle);
+    status = eeprom_read_array_len(&lorawan_eeprom_handle, addr + 1, buffer, size);
+    eeprom_unlock(&lorawan_eeprom_handle);
+
+    if (!status)
     {
         return 0;
     }
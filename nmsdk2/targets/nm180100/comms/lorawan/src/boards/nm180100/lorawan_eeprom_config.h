@@ -35,6 +35,18 @@
 #include "lorawan_config.h"
 #include "eeprom_emulation.h"
 
+#ifndef LORAWAN_EEPROM_INDEX_SIZE
+#define LORAWAN_EEPROM_INDEX_SIZE (0)
+#endif
+
+#ifndef LORAWAN_EEPROM_COMPACTION_THRESHOLD
+#define LORAWAN_EEPROM_COMPACTION_THRESHOLD (0)
+#endif
+
+#ifndef LORAWAN_EEPROM_COMPACTION_BUDGET
+#define LORAWAN_EEPROM_COMPACTION_BUDGET (64)
+#endif
+
 extern eeprom_handle_t lorawan_eeprom_handle;
 
 #endif /* EEPROM_EMULATION_CONF_H_ */
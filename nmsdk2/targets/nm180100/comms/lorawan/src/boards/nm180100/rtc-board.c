@@ -42,6 +42,7 @@
 
 #include "lorawan_power.h"
 #include "lorawan_config.h"
+#include "stimer_mux.h"
 
 // The typical transition time from deep-sleep to run mode is 25us (Chapter 22.4).
 // A single alarm tick using a 32.768kHz crystal is about 30.5us.  At the nominal
@@ -54,7 +55,6 @@
 #define CLOCK_SHIFT   15
 #define CLOCK_MS_MASK 0x7FFF
 #define TICKS_IN_MS   (CLOCK_PERIOD * 1e-3)
-#define CLOCK_SOURCE  LORAWAN_CLOCK_SOURCE
 
 static bool    RtcInitialized           = false;
 static bool    McuWakeUpTimeInitialized = false;
@@ -69,32 +69,14 @@ typedef struct {
 static RtcTimerContext_t RtcTimerContext;
 static uint32_t rtc_backup[2];
 
-void am_stimer_cmpr2_isr(void)
+// Called by the STIMER deadline multiplexer in its compare interrupt
+static void RtcAlarmHandler(void)
 {
-    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREC);
-
-    am_hal_stimer_int_disable(AM_HAL_STIMER_INT_COMPARED);
-    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPARED);
-
     if (RtcTimerContext.Running) {
-        if (am_hal_stimer_counter_get() >= RtcTimerContext.Alarm_Ticks) {
+        if (RtcGetTimerElapsedTime() >= RtcTimerContext.Alarm_Ticks) {
             RtcTimerContext.Running = false;
             TimerIrqHandler();
-            
-            lorawan_wake_on_timer_irq();
-        }
-    }
-}
-
-void am_stimer_cmpr3_isr(void)
-{
-    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPARED);
 
-    if (RtcTimerContext.Running) {
-        if (am_hal_stimer_counter_get() >= RtcTimerContext.Alarm_Ticks) {
-            RtcTimerContext.Running = false;
-            TimerIrqHandler();
-            
             lorawan_wake_on_timer_irq();
         }
     }
@@ -103,19 +85,8 @@ void am_stimer_cmpr3_isr(void)
 void RtcInit(void)
 {
     if (RtcInitialized == false) {
-        am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPAREC);
-        am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPARED);
-        NVIC_EnableIRQ(STIMER_CMPR2_IRQn);
-        NVIC_EnableIRQ(STIMER_CMPR3_IRQn);
-
-        uint32_t oldCfg = am_hal_stimer_config(AM_HAL_STIMER_CFG_FREEZE);
-
-        am_hal_stimer_config(
-            (oldCfg & ~(AM_HAL_STIMER_CFG_FREEZE | CTIMER_STCFG_CLKSEL_Msk))
-            | CLOCK_SOURCE
-            | AM_HAL_STIMER_CFG_COMPARE_C_ENABLE
-            | AM_HAL_STIMER_CFG_COMPARE_D_ENABLE
-            );
+        stimer_mux_init();
+        stimer_mux_register(STIMER_MUX_LORAWAN, RtcAlarmHandler, STIMER_MUX_TOLERANCE_LORAWAN);
 
         RtcSetTimerContext();
 
@@ -165,30 +136,21 @@ void RtcSetAlarm(uint32_t timeout) { RtcStartAlarm(timeout); }
 
 void RtcStopAlarm(void)
 {
-    am_hal_stimer_int_disable(AM_HAL_STIMER_INT_COMPAREC);
-    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREC);
-
-    am_hal_stimer_int_disable(AM_HAL_STIMER_INT_COMPARED);
-    am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPARED);
+    stimer_mux_clear(STIMER_MUX_LORAWAN);
 
     RtcTimerContext.Running = false;
 }
 
 void RtcStartAlarm(uint32_t timeout)
 {
-    RtcStopAlarm();
+    // the deadline is replaced below, without programming the compare twice
+    RtcTimerContext.Running = false;
 
-    // timeout is already in ticks
+    // timeout is already in ticks, relative to the timer context
     RtcTimerContext.Alarm_Ticks = timeout;
-
-    uint32_t relative = timeout - RtcGetTimerElapsedTime();
-
     RtcTimerContext.Running     = true;
-    am_hal_stimer_compare_delta_set(2, relative);
-    am_hal_stimer_compare_delta_set(3, relative+1);
 
-    am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPAREC);
-    am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPARED);
+    stimer_mux_set(STIMER_MUX_LORAWAN, RtcTimerContext.Ref_Ticks + timeout);
 }
 
 uint32_t RtcGetTimerValue(void) { return am_hal_stimer_counter_get(); }
@@ -2,6 +2,7 @@ BLE_DEFINES += -DWDXS_INCLUDED=1
 BLE_DEFINES += -DSEC_CMAC_CFG=1
 BLE_DEFINES += -DSEC_ECC_CFG=2
 BLE_DEFINES += -DSEC_CCM_CFG=1
+BLE_DEFINES += -DSEC_RAND_CFG=1
 BLE_DEFINES += -DHCI_TR_UART=1
 #BLE_DEFINES += -DWSF_CS_STATS=1
 #BLE_DEFINES += -DWSF_BUF_STATS=1
@@ -7,6 +7,8 @@ LORAWAN_DEFINES += -D"REGION_IN865"
 LORAWAN_DEFINES += -DLORAMAC_CLASSB_ENABLED
 LORAWAN_DEFINES += -DSOFT_SE
 LORAWAN_DEFINES += -DCONTEXT_MANAGEMENT_ENABLED
+LORAWAN_DEFINES += -DRANDOM_POOL_ENABLED
+LORAWAN_DEFINES += -DDEFERRED_LOG_ENABLED
 
 LORAWAN_INC += -I$(LORAWAN)/src/radio
 LORAWAN_INC += -I$(LORAWAN)/src/radio/sx126x
@@ -230,7 +230,7 @@ VPATH += $(BLE)/wsf/sources/util
 BLE_SRC += bda.c
 BLE_SRC += bstream.c
 BLE_SRC += calc128.c
-BLE_SRC += crc32.c
+#BLE_SRC += crc32.c
 BLE_SRC += fcs.c
 BLE_SRC += prand.c
 BLE_SRC += print.c
@@ -242,12 +242,15 @@ VPATH += ./comms/ble/wsf/sources/port/nm180100
 BLE_SRC += wsf_assert.c
 BLE_SRC += wsf_buf.c
 #BLE_SRC += wsf_bufio.c
+# CalcCrc32() on top of the shared utils/crc32_table.c (HAL library)
+# instead of the WSF util/crc32.c private table.
+BLE_SRC += wsf_crc32.c
 BLE_SRC += wsf_cs.c
 BLE_SRC += wsf_detoken.c
 BLE_SRC += wsf_efs.c
 BLE_SRC += wsf_heap.c
 BLE_SRC += wsf_msg.c
-#BLE_SRC += wsf_nvm.c
+BLE_SRC += wsf_nvm.c
 BLE_SRC += wsf_os.c
 BLE_SRC += wsf_queue.c
 BLE_SRC += wsf_timer.c
@@ -49,4 +49,9 @@ HAL_SRC += am_util_string.c
 HAL_SRC += am_util_time.c
 
 VPATH += ./utils
-HAL_SRC += eeprom_emulation.c
\ No newline at end of file
+HAL_SRC += crc32_table.c
+HAL_SRC += deferred_log.c
+HAL_SRC += eeprom_emulation.c
+HAL_SRC += random_pool.c
+HAL_SRC += stimer_mux.c
+HAL_SRC += rtos_stats.c
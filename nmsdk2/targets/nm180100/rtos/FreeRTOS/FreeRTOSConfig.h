@@ -83,9 +83,15 @@ extern "C"
 #define configCHECK_FOR_STACK_OVERFLOW          2
 #define configUSE_MALLOC_FAILED_HOOK            1
 
-/* Run time and task stats gathering related definitions. */
+/* Run time and task stats gathering related definitions, only built with
+ * RTOS_STATS_ENABLED, see rtos_stats.h. */
+#if defined(RTOS_STATS_ENABLED)
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_TRACE_FACILITY                1
+#else
 #define configGENERATE_RUN_TIME_STATS           0
 #define configUSE_TRACE_FACILITY                0
+#endif
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
 /* Software timer related definitions. */
@@ -93,6 +99,7 @@ extern "C"
 #define configTIMER_TASK_PRIORITY               (configMAX_PRIORITIES - 1)
 #define configTIMER_QUEUE_LENGTH                16
 #define configTIMER_TASK_STACK_DEPTH            2048
+#define configUSE_TIMER_SLACK                   1
 
 /* Interrupt nesting behaviour configuration. */
 #define configKERNEL_INTERRUPT_PRIORITY         (0x7 << 5)
@@ -142,6 +149,17 @@ extern void am_freertos_wakeup(uint32_t);
     } while (0);
 
 #define configPOST_SLEEP_PROCESSING(time)    am_freertos_wakeup(time)
+
+#if defined(RTOS_STATS_ENABLED)
+/* Run-time statistics on the STIMER, see rtos_stats.h. */
+extern void rtos_stats_init(void);
+extern uint32_t rtos_stats_counter_get(void);
+extern void rtos_stats_task_switched_in(uint32_t);
+
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()    rtos_stats_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()            rtos_stats_counter_get()
+#define traceTASK_SWITCHED_IN()                     rtos_stats_task_switched_in(pxCurrentTCB->uxTCBNumber)
+#endif
 #endif
 /*-----------------------------------------------------------*/
 
@@ -36,6 +36,18 @@
 /* hardware includes */
 #include "am_mcu_apollo.h"
 
+// Deep sleep residency of the run-time statistics
+#include "rtos_stats.h"
+
+#ifdef AM_FREERTOS_USE_STIMER_FOR_TICK
+// The tick shares the STIMER compare with the LoRaMac and WSF timers
+#include "stimer_mux.h"
+
+#if STIMER_MUX_IRQ_PRIORITY != NVIC_configKERNEL_INTERRUPT_PRIORITY
+#error "STIMER_MUX_IRQ_PRIORITY must be the kernel interrupt priority"
+#endif
+#endif
+
 // A Possible clock glitch could rarely cause the Stimer interrupt to be lost.
 // Set up a backup comparator to handle this case
 #define AM_FREERTOS_STIMER_BACKUP
@@ -123,6 +135,7 @@ static uint32_t g_lastSTimerVal = 0;
 #define portMAX_16_BIT_NUMBER		( 0x0000ffffUL )
 /* The Stimer is a 32-bit counter. */
 #define portMAX_32_BIT_NUMBER		( 0xffffffffUL )
+#define portMAX_31_BIT_NUMBER		( 0x7fffffffUL )
 
 
 #endif
@@ -951,10 +964,7 @@ void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
         ulReloadValue -= elapsed_time;
         // Initialize new timeout value
 #ifdef AM_FREERTOS_USE_STIMER_FOR_TICK
-        am_hal_stimer_compare_delta_set(0, ulReloadValue);
-#ifdef AM_FREERTOS_STIMER_BACKUP
-        am_hal_stimer_compare_delta_set(1, ulReloadValue+1);
-#endif
+        stimer_mux_set(STIMER_MUX_RTOS, curTime + ulReloadValue);
 #else
         am_hal_ctimer_clear(configCTIMER_NUM, AM_HAL_CTIMER_BOTH);
         am_hal_ctimer_compare_set(configCTIMER_NUM, AM_HAL_CTIMER_BOTH, 0, ulReloadValue);
@@ -968,6 +978,8 @@ void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
 		time variable must remain unmodified, so a copy is taken. */
 		xModifiableIdleTime = xExpectedIdleTime;
 
+        rtos_stats_sleep_enter();
+
 		configPRE_SLEEP_PROCESSING( xModifiableIdleTime );       // Turn OFF all Periphials in this function
 
 		if( xModifiableIdleTime > 0 )
@@ -979,6 +991,8 @@ void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
 
 		configPOST_SLEEP_PROCESSING( xExpectedIdleTime );       // Turn ON all Periphials in this function
 
+        rtos_stats_sleep_exit();
+
         // Any interrupt may have woken us up
 
         // Before renable interrupts, check how many ticks the processor has been in SLEEP
@@ -1014,16 +1028,9 @@ void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
 		/* Restart System Tick */
 #ifdef AM_FREERTOS_USE_STIMER_FOR_TICK
 
-        // Clear the interrupt - to avoid extra tick counting in ISR
-#ifdef AM_FREERTOS_STIMER_BACKUP
-        am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREA | AM_HAL_STIMER_INT_COMPAREB);
-#else
-        am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREA);
-#endif
-        am_hal_stimer_compare_delta_set(0, ulTimerCountsForOneTick);
-#ifdef AM_FREERTOS_STIMER_BACKUP
-        am_hal_stimer_compare_delta_set(1, ulTimerCountsForOneTick+1);
-#endif
+        // Move the tick past the sleep - to avoid extra tick counting in ISR.
+        // The compare interrupt may still be pending for the other clients.
+        stimer_mux_set(STIMER_MUX_RTOS, g_lastSTimerVal + ulTimerCountsForOneTick);
 #else
         am_hal_ctimer_clear(configCTIMER_NUM, AM_HAL_CTIMER_BOTH);
         am_hal_ctimer_compare_set(configCTIMER_NUM, AM_HAL_CTIMER_BOTH, 0, ulTimerCountsForOneTick);
@@ -1061,7 +1068,7 @@ void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
 //
 //*****************************************************************************
 void
-xPortStimerTickHandler(uint32_t delta)
+xPortStimerTickHandler(void)
 {
     uint32_t remainder = 0;
     uint32_t curSTimer;
@@ -1070,19 +1077,17 @@ xPortStimerTickHandler(uint32_t delta)
     BaseType_t ctxtSwitchReqd = pdFALSE;
 
     curSTimer = am_hal_stimer_counter_get();
-    //
-    // Configure the STIMER->COMPARE_0
-    //
-    am_hal_stimer_compare_delta_set(0, (ulTimerCountsForOneTick-delta));
-#ifdef AM_FREERTOS_STIMER_BACKUP
-    am_hal_stimer_compare_delta_set(1, (ulTimerCountsForOneTick-delta+1));
-#endif
-    
+
     timerCounts = curSTimer - g_lastSTimerVal;
     numTicksElapsed = timerCounts/ulTimerCountsForOneTick;
     remainder = timerCounts % ulTimerCountsForOneTick;
     g_lastSTimerVal = curSTimer - remainder;
 
+    //
+    // Set the deadline of the next tick
+    //
+    stimer_mux_set(STIMER_MUX_RTOS, g_lastSTimerVal + ulTimerCountsForOneTick);
+
     //
     // This is a timer a0 interrupt, perform the necessary functions
     // for the tick ISR.
@@ -1112,57 +1117,6 @@ xPortStimerTickHandler(uint32_t delta)
 }
 
 
-//*****************************************************************************
-//
-// Interrupt handler for the STIMER module Compare 0.
-//
-//*****************************************************************************
-void
-am_stimer_cmpr0_isr(void)
-{
-
-    //
-    // Check the timer interrupt status.
-    //
-    uint32_t ui32Status = am_hal_stimer_int_status_get(false);
-    if (ui32Status & AM_HAL_STIMER_INT_COMPAREA)
-    {
-        am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREA);
-
-        //
-        // Run handlers for the various possible timer events.
-        //
-        xPortStimerTickHandler(0);
-    }
-}
-
-#ifdef AM_FREERTOS_STIMER_BACKUP
-uint32_t gNumCmpB = 0;
-//*****************************************************************************
-//
-// Interrupt handler for the STIMER module Compare 0.
-//
-//*****************************************************************************
-void
-am_stimer_cmpr1_isr(void)
-{
-
-    //
-    // Check the timer interrupt status.
-    //
-    uint32_t ui32Status = am_hal_stimer_int_status_get(false);
-    if (ui32Status & AM_HAL_STIMER_INT_COMPAREB)
-    {
-        am_hal_stimer_int_clear(AM_HAL_STIMER_INT_COMPAREB);
-        gNumCmpB++;
-        //
-        // Run handlers for the various possible timer events.
-        //
-        xPortStimerTickHandler(1);
-    }
-}
-#endif
-
 #else // Use CTimer
 //*****************************************************************************
 //
@@ -1208,68 +1162,23 @@ xPortCTimer0TickHandler(void)
 void vPortSetupTimerInterrupt( void )
 {
 #ifdef AM_FREERTOS_USE_STIMER_FOR_TICK
-    uint32_t oldCfg;
     /* Calculate the constants required to configure the tick interrupt. */
     #if configUSE_TICKLESS_IDLE == 2
     {
         ulTimerCountsForOneTick = (configSTIMER_CLOCK_HZ /configTICK_RATE_HZ) ; //( configSYSTICK_CLOCK_HZ / configTICK_RATE_HZ );
-#ifdef AM_FREERTOS_STIMER_BACKUP
-        xMaximumPossibleSuppressedTicks = portMAX_32_BIT_NUMBER / ulTimerCountsForOneTick - 1;
-#else
-        xMaximumPossibleSuppressedTicks = portMAX_32_BIT_NUMBER / ulTimerCountsForOneTick;
-#endif
+        // The multiplexer compares deadlines as signed 32-bit differences
+        xMaximumPossibleSuppressedTicks = portMAX_31_BIT_NUMBER / ulTimerCountsForOneTick - 1;
     }
     #endif /* configUSE_TICKLESS_IDLE */
     //
+    // The STIMER deadline multiplexer owns compare A and B and runs the tick
+    // handler at the kernel interrupt priority.
     //
-    //
-#ifdef AM_FREERTOS_STIMER_BACKUP
-    am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPAREA | AM_HAL_STIMER_INT_COMPAREB);
-#else
-    am_hal_stimer_int_enable(AM_HAL_STIMER_INT_COMPAREA);
-#endif
-    
-    //
-    // Enable the timer interrupt in the NVIC, making sure to use the
-    // appropriate priority level.
-    //
-#if AM_CMSIS_REGS
-    NVIC_SetPriority(STIMER_CMPR0_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
-    NVIC_EnableIRQ(STIMER_CMPR0_IRQn);
-#else // AM_CMSIS_REGS
-    am_hal_interrupt_priority_set(AM_HAL_INTERRUPT_STIMER_CMPR0, configKERNEL_INTERRUPT_PRIORITY);
-    am_hal_interrupt_enable(AM_HAL_INTERRUPT_STIMER_CMPR0);
-#endif // AM_CMSIS_REGS
-#ifdef AM_FREERTOS_STIMER_BACKUP
-#if AM_CMSIS_REGS
-    NVIC_SetPriority(STIMER_CMPR1_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
-    NVIC_EnableIRQ(STIMER_CMPR1_IRQn);
-#else // AM_CMSIS_REGS
-    am_hal_interrupt_priority_set(AM_HAL_INTERRUPT_STIMER_CMPR1, configKERNEL_INTERRUPT_PRIORITY);
-    am_hal_interrupt_enable(AM_HAL_INTERRUPT_STIMER_CMPR1);
-#endif // AM_CMSIS_REGS
-#endif
-    //
-    // Configure the STIMER
-    //
-    oldCfg = am_hal_stimer_config(AM_HAL_STIMER_CFG_FREEZE);
+    stimer_mux_init();
+    stimer_mux_register(STIMER_MUX_RTOS, xPortStimerTickHandler, STIMER_MUX_TOLERANCE_RTOS);
+
     g_lastSTimerVal = am_hal_stimer_counter_get();
-    am_hal_stimer_compare_delta_set(0, ulTimerCountsForOneTick);
-#ifdef AM_FREERTOS_STIMER_BACKUP
-    am_hal_stimer_compare_delta_set(1, ulTimerCountsForOneTick+1);
-#if AM_CMSIS_REGS
-    am_hal_stimer_config((oldCfg & ~(AM_HAL_STIMER_CFG_FREEZE | CTIMER_STCFG_CLKSEL_Msk)) | configSTIMER_CLOCK | AM_HAL_STIMER_CFG_COMPARE_A_ENABLE | AM_HAL_STIMER_CFG_COMPARE_B_ENABLE);
-#else // AM_CMSIS_REGS
-    am_hal_stimer_config((oldCfg & ~(AM_HAL_STIMER_CFG_FREEZE|AM_REG_CTIMER_STCFG_CLKSEL_M)) | configSTIMER_CLOCK | AM_HAL_STIMER_CFG_COMPARE_A_ENABLE | AM_HAL_STIMER_CFG_COMPARE_B_ENABLE);
-#endif // AM_CMSIS_REGS
-#else
-#if AM_CMSIS_REGS
-    am_hal_stimer_config((oldCfg & ~(AM_HAL_STIMER_CFG_FREEZE | CTIMER_STCFG_CLKSEL_Msk)) | configSTIMER_CLOCK | AM_HAL_STIMER_CFG_COMPARE_A_ENABLE);
-#else // AM_CMSIS_REGS
-    am_hal_stimer_config((oldCfg & ~(AM_HAL_STIMER_CFG_FREEZE|AM_REG_CTIMER_STCFG_CLKSEL_M)) | configSTIMER_CLOCK | AM_HAL_STIMER_CFG_COMPARE_A_ENABLE);
-#endif // AM_CMSIS_REGS
-    
-#endif
+    stimer_mux_set(STIMER_MUX_RTOS, g_lastSTimerVal + ulTimerCountsForOneTick);
 #else
 
     /* Calculate the constants required to configure the tick interrupt. */
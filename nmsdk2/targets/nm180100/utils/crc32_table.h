@@ -0,0 +1,65 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _CRC32_TABLE_H_
+#define _CRC32_TABLE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* CRC-32 (polynomial 0x04C11DB7, bit reversed) shared by the LoRaWAN stack
+ * (Crc32() and Crc32Update()) and the WSF CalcCrc32().
+ *
+ * CRC32_METHOD selects the trade off between speed and flash usage:
+ *   CRC32_METHOD_NIBBLE      16 entry table (64 bytes), one nibble per lookup
+ *   CRC32_METHOD_SLICE_BY_4  4 x 256 entry tables (4 kB), 4 bytes per step
+ *   CRC32_METHOD_SLICE_BY_8  8 x 256 entry tables (8 kB), 8 bytes per step */
+#define CRC32_METHOD_NIBBLE       0
+#define CRC32_METHOD_SLICE_BY_4   4
+#define CRC32_METHOD_SLICE_BY_8   8
+
+#ifndef CRC32_METHOD
+#define CRC32_METHOD              CRC32_METHOD_SLICE_BY_4
+#endif
+
+/* Feed ui32Length bytes into the running CRC register ui32Crc and return the
+ * updated register.  No initial value or final inversion is applied; callers
+ * start from 0xFFFFFFFF and invert the result to obtain the standard CRC-32. */
+uint32_t crc32_update(uint32_t ui32Crc, const uint8_t *pui8Data, uint32_t ui32Length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CRC32_TABLE_H_ */
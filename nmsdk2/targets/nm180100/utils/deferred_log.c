@@ -0,0 +1,232 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "deferred_log.h"
+
+#if (DEFERRED_LOG_RING_WORDS & (DEFERRED_LOG_RING_WORDS - 1)) || (DEFERRED_LOG_RING_WORDS < 128)
+#error "DEFERRED_LOG_RING_WORDS must be a power of two, 128 or more"
+#endif
+
+#define DEFERRED_LOG_MASK           (DEFERRED_LOG_RING_WORDS - 1)
+
+/* Record header: words in the record, including the header, and the number
+ * of arguments, or DEFERRED_LOG_HEX_RECORD.  A header is never 0, which marks
+ * a slot reserved but not yet written. */
+#define DEFERRED_LOG_HEADER(words, args) (((uintptr_t)(words) << 16) | (args))
+#define DEFERRED_LOG_HEADER_WORDS(h)     (((h) >> 16) & 0xFFFF)
+#define DEFERRED_LOG_HEADER_ARGS(h)      ((h) & 0xFFFF)
+#define DEFERRED_LOG_HEX_RECORD          0xFFFF
+
+/* Free running word indices, the ring slot is the index masked. */
+static uintptr_t deferred_log_ring[DEFERRED_LOG_RING_WORDS];
+static volatile uint32_t deferred_log_head;
+static volatile uint32_t deferred_log_tail;
+static volatile uint32_t deferred_log_drops;
+static deferred_log_notify_t deferred_log_notify;
+
+void deferred_log_init(deferred_log_notify_t pfnNotify)
+{
+    memset(deferred_log_ring, 0, sizeof(deferred_log_ring));
+    deferred_log_head = 0;
+    deferred_log_tail = 0;
+    deferred_log_drops = 0;
+    deferred_log_notify = pfnNotify;
+}
+
+/* Reserves ui32Words slots and returns the index of the first, or -1 if the
+ * ring lacks the room. */
+static int64_t deferred_log_reserve(uint32_t ui32Words, bool *pbWasEmpty)
+{
+    uint32_t ui32Head = __atomic_load_n(&deferred_log_head, __ATOMIC_RELAXED);
+    uint32_t ui32Tail;
+
+    do
+    {
+        ui32Tail = __atomic_load_n(&deferred_log_tail, __ATOMIC_ACQUIRE);
+        if (ui32Words > DEFERRED_LOG_RING_WORDS - (ui32Head - ui32Tail))
+        {
+            __atomic_fetch_add(&deferred_log_drops, 1, __ATOMIC_RELAXED);
+            return -1;
+        }
+    } while (!__atomic_compare_exchange_n(&deferred_log_head, &ui32Head, ui32Head + ui32Words, true,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+    *pbWasEmpty = (ui32Head == ui32Tail);
+
+    return ui32Head;
+}
+
+static void deferred_log_commit(uint32_t ui32Index, uintptr_t uHeader, bool bWasEmpty)
+{
+    __atomic_store_n(&deferred_log_ring[ui32Index & DEFERRED_LOG_MASK], uHeader, __ATOMIC_RELEASE);
+
+    if (bWasEmpty && deferred_log_notify)
+    {
+        deferred_log_notify();
+    }
+}
+
+bool deferred_log_write(const char *pcFormat, uint32_t ui32Args, ...)
+{
+    uint32_t ui32Words = 2 + ui32Args;
+    bool bWasEmpty;
+    int64_t i64Index;
+    uint32_t ui32Index;
+    va_list ap;
+
+    if (ui32Args > DEFERRED_LOG_MAX_ARGS)
+    {
+        return false;
+    }
+
+    i64Index = deferred_log_reserve(ui32Words, &bWasEmpty);
+    if (i64Index < 0)
+    {
+        return false;
+    }
+    ui32Index = (uint32_t)i64Index;
+
+    deferred_log_ring[(ui32Index + 1) & DEFERRED_LOG_MASK] = (uintptr_t)pcFormat;
+    va_start(ap, ui32Args);
+    for (uint32_t i = 0; i < ui32Args; i++)
+    {
+        deferred_log_ring[(ui32Index + 2 + i) & DEFERRED_LOG_MASK] = va_arg(ap, uintptr_t);
+    }
+    va_end(ap);
+
+    deferred_log_commit(ui32Index, DEFERRED_LOG_HEADER(ui32Words, ui32Args), bWasEmpty);
+
+    return true;
+}
+
+bool deferred_log_hex(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    uint32_t ui32Words;
+    bool bWasEmpty;
+    int64_t i64Index;
+    uint32_t ui32Index;
+    uintptr_t uWord;
+
+    if (ui32Length > DEFERRED_LOG_MAX_HEX)
+    {
+        ui32Length = DEFERRED_LOG_MAX_HEX;
+    }
+
+    ui32Words = 2 + (ui32Length + sizeof(uintptr_t) - 1) / sizeof(uintptr_t);
+    i64Index = deferred_log_reserve(ui32Words, &bWasEmpty);
+    if (i64Index < 0)
+    {
+        return false;
+    }
+    ui32Index = (uint32_t)i64Index;
+
+    deferred_log_ring[(ui32Index + 1) & DEFERRED_LOG_MASK] = ui32Length;
+    for (uint32_t i = 0; i < ui32Words - 2; i++)
+    {
+        uWord = 0;
+        memcpy(&uWord, &pui8Data[i * sizeof(uintptr_t)],
+               (ui32Length - i * sizeof(uintptr_t) < sizeof(uintptr_t)) ? ui32Length - i * sizeof(uintptr_t)
+                                                                       : sizeof(uintptr_t));
+        deferred_log_ring[(ui32Index + 2 + i) & DEFERRED_LOG_MASK] = uWord;
+    }
+
+    deferred_log_commit(ui32Index, DEFERRED_LOG_HEADER(ui32Words, DEFERRED_LOG_HEX_RECORD), bWasEmpty);
+
+    return true;
+}
+
+deferred_log_status_e deferred_log_read(deferred_log_record_t *pRecord)
+{
+    uint32_t ui32Tail = deferred_log_tail;
+    uint32_t ui32Words;
+    uint32_t ui32Args;
+    uintptr_t uHeader;
+
+    if (ui32Tail == __atomic_load_n(&deferred_log_head, __ATOMIC_ACQUIRE))
+    {
+        return DEFERRED_LOG_EMPTY;
+    }
+
+    uHeader = __atomic_load_n(&deferred_log_ring[ui32Tail & DEFERRED_LOG_MASK], __ATOMIC_ACQUIRE);
+    if (uHeader == 0)
+    {
+        return DEFERRED_LOG_PENDING;
+    }
+
+    ui32Words = DEFERRED_LOG_HEADER_WORDS(uHeader);
+    ui32Args = DEFERRED_LOG_HEADER_ARGS(uHeader);
+
+    if (ui32Args == DEFERRED_LOG_HEX_RECORD)
+    {
+        pRecord->pcFormat = NULL;
+        pRecord->ui32Args = 0;
+        pRecord->ui32Length = deferred_log_ring[(ui32Tail + 1) & DEFERRED_LOG_MASK];
+        for (uint32_t i = 0; i < ui32Words - 2; i++)
+        {
+            uintptr_t uWord = deferred_log_ring[(ui32Tail + 2 + i) & DEFERRED_LOG_MASK];
+            uint32_t ui32Bytes = pRecord->ui32Length - i * sizeof(uintptr_t);
+
+            memcpy(&pRecord->pui8Data[i * sizeof(uintptr_t)], &uWord,
+                   (ui32Bytes < sizeof(uintptr_t)) ? ui32Bytes : sizeof(uintptr_t));
+        }
+    }
+    else
+    {
+        pRecord->pcFormat = (const char *)deferred_log_ring[(ui32Tail + 1) & DEFERRED_LOG_MASK];
+        pRecord->ui32Args = ui32Args;
+        pRecord->ui32Length = 0;
+        for (uint32_t i = 0; i < ui32Args; i++)
+        {
+            pRecord->puArgs[i] = deferred_log_ring[(ui32Tail + 2 + i) & DEFERRED_LOG_MASK];
+        }
+    }
+
+    /* Slots go back cleared, the next writer's header is the last word it
+     * stores. */
+    for (uint32_t i = 0; i < ui32Words; i++)
+    {
+        deferred_log_ring[(ui32Tail + i) & DEFERRED_LOG_MASK] = 0;
+    }
+    __atomic_store_n(&deferred_log_tail, ui32Tail + ui32Words, __ATOMIC_RELEASE);
+
+    return DEFERRED_LOG_RECORD;
+}
+
+uint32_t deferred_log_dropped(void)
+{
+    return __atomic_load_n(&deferred_log_drops, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,125 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _DEFERRED_LOG_H_
+#define _DEFERRED_LOG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Deferred logging.
+ *
+ * DEFERRED_LOG() stores the address of its format string and its arguments,
+ * one word each, in a ring; a consumer, normally the log task, reads the
+ * records back and does the formatting and the output later on.  Writers may
+ * be tasks or interrupts and never wait: they reserve their slots with a
+ * compare-and-swap and mark the record complete last.  A record that does
+ * not fit is dropped and counted.
+ *
+ * The arguments are integers or pointers to strings that do not change, such
+ * as literals and constant tables, since they are read after the call
+ * returns.  Format strings stay in flash, a host tool can resolve their
+ * addresses through the ELF file instead of formatting on the device. */
+
+/* Ring size in words, a power of two. */
+#ifndef DEFERRED_LOG_RING_WORDS
+#define DEFERRED_LOG_RING_WORDS     1024
+#endif
+
+#define DEFERRED_LOG_MAX_ARGS       8
+#define DEFERRED_LOG_MAX_HEX        255
+
+typedef enum
+{
+    DEFERRED_LOG_EMPTY,
+    DEFERRED_LOG_RECORD,
+    DEFERRED_LOG_PENDING,   /* the next record is still being written */
+} deferred_log_status_e;
+
+typedef struct
+{
+    const char *pcFormat;   /* NULL for the bytes of deferred_log_hex() */
+    uint32_t ui32Args;
+    uintptr_t puArgs[DEFERRED_LOG_MAX_ARGS];
+    uint32_t ui32Length;
+    uint8_t pui8Data[DEFERRED_LOG_MAX_HEX];
+} deferred_log_record_t;
+
+typedef void (*deferred_log_notify_t)(void);
+
+#define DEFERRED_LOG(...) DEFERRED_LOG_N(DEFERRED_LOG_NARGS(__VA_ARGS__), __VA_ARGS__)
+
+#define DEFERRED_LOG_NARGS(...) DEFERRED_LOG_NARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DEFERRED_LOG_NARGS_(f, a1, a2, a3, a4, a5, a6, a7, a8, n, ...) n
+#define DEFERRED_LOG_N(n, ...)  DEFERRED_LOG_CAT(DEFERRED_LOG_, n)(__VA_ARGS__)
+#define DEFERRED_LOG_CAT(a, b)  DEFERRED_LOG_CAT_(a, b)
+#define DEFERRED_LOG_CAT_(a, b) a##b
+
+#define DEFERRED_LOG_0(f) deferred_log_write(f, 0)
+#define DEFERRED_LOG_1(f, a1) deferred_log_write(f, 1, (uintptr_t)(a1))
+#define DEFERRED_LOG_2(f, a1, a2) deferred_log_write(f, 2, (uintptr_t)(a1), (uintptr_t)(a2))
+#define DEFERRED_LOG_3(f, a1, a2, a3)                                                              \
+    deferred_log_write(f, 3, (uintptr_t)(a1), (uintptr_t)(a2), (uintptr_t)(a3))
+#define DEFERRED_LOG_4(f, a1, a2, a3, a4)                                                          \
+    deferred_log_write(f, 4, (uintptr_t)(a1), (uintptr_t)(a2), (uintptr_t)(a3), (uintptr_t)(a4))
+#define DEFERRED_LOG_5(f, a1, a2, a3, a4, a5)                                                      \
+    deferred_log_write(f, 5, (uintptr_t)(a1), (uintptr_t)(a2), (uintptr_t)(a3), (uintptr_t)(a4),   \
+                       (uintptr_t)(a5))
+#define DEFERRED_LOG_6(f, a1, a2, a3, a4, a5, a6)                                                  \
+    deferred_log_write(f, 6, (uintptr_t)(a1), (uintptr_t)(a2), (uintptr_t)(a3), (uintptr_t)(a4),   \
+                       (uintptr_t)(a5), (uintptr_t)(a6))
+#define DEFERRED_LOG_7(f, a1, a2, a3, a4, a5, a6, a7)                                              \
+    deferred_log_write(f, 7, (uintptr_t)(a1), (uintptr_t)(a2), (uintptr_t)(a3), (uintptr_t)(a4),   \
+                       (uintptr_t)(a5), (uintptr_t)(a6), (uintptr_t)(a7))
+#define DEFERRED_LOG_8(f, a1, a2, a3, a4, a5, a6, a7, a8)                                          \
+    deferred_log_write(f, 8, (uintptr_t)(a1), (uintptr_t)(a2), (uintptr_t)(a3), (uintptr_t)(a4),   \
+                       (uintptr_t)(a5), (uintptr_t)(a6), (uintptr_t)(a7), (uintptr_t)(a8))
+
+/* pfnNotify is called by the writer of a record that finds the ring empty. */
+void deferred_log_init(deferred_log_notify_t pfnNotify);
+
+bool deferred_log_write(const char *pcFormat, uint32_t ui32Args, ...);
+bool deferred_log_hex(const uint8_t *pui8Data, uint32_t ui32Length);
+
+/* Single consumer. */
+deferred_log_status_e deferred_log_read(deferred_log_record_t *pRecord);
+
+uint32_t deferred_log_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DEFERRED_LOG_H_ */
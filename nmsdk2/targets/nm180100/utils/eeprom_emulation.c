@@ -32,6 +32,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <am_hal_flash.h>
 
@@ -44,8 +45,62 @@
 #define SIZE_OF_VIRTUAL_ADDRESS 2                                 /* 2 bytes */
 #define SIZE_OF_VARIABLE (SIZE_OF_DATA + SIZE_OF_VIRTUAL_ADDRESS) /* 4 bytes */
 
+/* Virtual addresses from 0xF000 are reserved for packed record headers and
+ * cannot be used by single variables. */
+#define VARIABLE_ADDRESS_MAX 0xEFFF
+
 #define MAX_ACTIVE_VARIABLES (AM_HAL_FLASH_PAGE_SIZE / SIZE_OF_VARIABLE) - 1
 
+/* A packed record is a header word followed by its payload, four bytes per
+ * word with the first byte in the least significant lane, and a trailer word.
+ * The header has its top nibble set, which single variables never have, then
+ * the payload length in bytes and the virtual address of the first byte.  The
+ * trailer repeats the header; flash words are programmed in order, so a record
+ * torn by a reset has no valid trailer and is ignored.  A header with a length
+ * of zero is a tombstone for one deleted virtual address and has neither
+ * payload nor trailer.
+ *
+ * A trailer, a tombstone and a single variable can be told apart from the last
+ * word of a record alone, so pages can also be walked backwards from their
+ * first free word.  Records written by earlier versions end with the
+ * complement of the header instead, which looks like a single variable; when
+ * one may have been found, the page is walked forward from its start. */
+#define RECORD_MARKER           0xF0000000
+#define RECORD_MARKER_MASK      0xF0000000
+#define RECORD_LENGTH_MAX       0x03FF
+
+#define RECORD_IS_PACKED(word)  (((word) & RECORD_MARKER_MASK) == RECORD_MARKER)
+#define RECORD_LENGTH(word)     (((word) >> 16) & RECORD_LENGTH_MAX)
+#define RECORD_ADDRESS(word)    ((uint16_t)(word))
+#define RECORD_WORDS(length)    (((length) + 3) >> 2)
+#define RECORD_SIZE(length)     ((length) ? 2 + RECORD_WORDS(length) : 1)
+#define RECORD_HEADER(virtual_address, length) \
+    (RECORD_MARKER | ((uint32_t)(length) << 16) | (uint32_t)(virtual_address))
+
+#define RECORD_TRAILER(header)  (header)
+
+#if (EEPROM_RECORD_MAX_SIZE < 4) || (EEPROM_RECORD_MAX_SIZE > RECORD_LENGTH_MAX)
+#error "EEPROM_RECORD_MAX_SIZE must be between 4 and 1023 bytes"
+#endif
+
+/* RAM index entries: bit 15 marks a byte inside a packed payload, bits 14..2
+ * are the word offset in the active page and bits 1..0 the byte lane. */
+#define INDEX_PACKED            0x8000
+#define INDEX_ENTRY(offset, lane) ((uint16_t)(((offset) << 2) | (lane)))
+#define INDEX_OFFSET(entry)     (((entry) & 0x7FFF) >> 2)
+#define INDEX_LANE(entry)       ((entry) & 0x3)
+
+typedef struct {
+    uint32_t *address; /* flash word holding the value */
+    int8_t lane;       /* byte lane in a packed payload, -1 for a single variable */
+} eeprom_location_t;
+
+typedef struct {
+    uint32_t *buffer;
+    uint16_t virtual_address;
+    uint16_t length;
+} eeprom_packer_t;
+
 typedef enum {
     EEPROM_PAGE_STATUS_ERASED = 0xFF,
     EEPROM_PAGE_STATUS_RECEIVING = 0xAA,
@@ -78,6 +133,16 @@ static inline int eeprom_page_set_receiving(eeprom_page_t *page)
         page->pui32StartAddress, SIZE_OF_VARIABLE >> 2);
 }
 
+static int eeprom_page_erase(eeprom_handle_t *pHandle, eeprom_page_t *page)
+{
+    pHandle->page_erases++;
+
+    return am_hal_flash_page_erase(
+        AM_HAL_FLASH_PROGRAM_KEY,
+        AM_HAL_FLASH_ADDR2INST((uint32_t)(page->pui32StartAddress)),
+        AM_HAL_FLASH_ADDR2PAGE((uint32_t)(page->pui32StartAddress)));
+}
+
 static bool eeprom_page_validate_empty(eeprom_page_t *page)
 {
     uint32_t *address = page->pui32StartAddress;
@@ -93,48 +158,432 @@ static bool eeprom_page_validate_empty(eeprom_page_t *page)
     return true;
 }
 
-static bool eeprom_page_write(eeprom_page_t *page, uint16_t virtual_address,
-                              uint16_t data)
+/* Return the word following the record stored at address. */
+static inline uint32_t *eeprom_record_next(uint32_t *address)
+{
+    if (RECORD_IS_PACKED(*address))
+    {
+        return address + RECORD_SIZE(RECORD_LENGTH(*address));
+    }
+    return address + 1;
+}
+
+/* Check that a packed record stored at address was completely programmed. */
+static inline bool eeprom_record_valid(eeprom_page_t *page, uint32_t *address)
+{
+    uint32_t *trailer;
+
+    if (!RECORD_IS_PACKED(*address) || RECORD_LENGTH(*address) == 0)
+    {
+        return true;
+    }
+
+    trailer = address + 1 + RECORD_WORDS(RECORD_LENGTH(*address));
+
+    return (trailer <= page->pui32EndAddress) &&
+           ((*trailer == RECORD_TRAILER(*address)) || (*trailer == ~(*address)));
+}
+
+/* Check whether the record stored at address holds or deletes a virtual address. */
+static bool eeprom_record_covers(uint32_t *address, uint16_t virtual_address)
+{
+    if (RECORD_IS_PACKED(*address))
+    {
+        uint32_t ui32First = RECORD_ADDRESS(*address);
+        uint32_t ui32Length = RECORD_LENGTH(*address);
+
+        if (ui32Length == 0)
+        {
+            return virtual_address == ui32First;
+        }
+        return (virtual_address >= ui32First) && (virtual_address < ui32First + ui32Length);
+    }
+
+    return (uint16_t)(*address >> 16) == virtual_address;
+}
+
+/* Return the first free word of the page.  Records are walked from the start
+ * since a packed payload may itself contain erased words. */
+static uint32_t *eeprom_page_free(eeprom_page_t *page)
 {
     /* Start at the second word. The fist one is reserved for status and erase count. */
     uint32_t *address = page->pui32StartAddress + 1;
-    uint32_t virtualAddressAndData;
 
-    /* Iterate through the page from the beginning, and stop at the fist empty word. */
-    while (address <= page->pui32EndAddress)
+    while ((address <= page->pui32EndAddress) && (*address != 0xFFFFFFFF))
     {
-        /* Empty word found. */
-        if (*address == 0xFFFFFFFF)
+        address = eeprom_record_next(address);
+    }
+
+    return address;
+}
+
+/* Return the first word of the record that ends just before address, or NULL
+ * if the words alone cannot tell and the page must be walked from its start. */
+static uint32_t *eeprom_record_prev(eeprom_page_t *page, uint32_t *address)
+{
+    uint32_t *last = address - 1;
+    uint32_t ui32Offset = last - page->pui32StartAddress;
+    uint32_t ui32Word = *last;
+
+    if (RECORD_IS_PACKED(ui32Word))
+    {
+        if (RECORD_LENGTH(ui32Word) == 0)
         {
-            virtualAddressAndData =
-                ((uint32_t)(virtual_address << 16) & 0xFFFF0000) |
-                (uint32_t)(data);
+            return last;
+        }
 
-            if (am_hal_flash_program_main(AM_HAL_FLASH_PROGRAM_KEY,
-                                          &virtualAddressAndData, address,
-                                          SIZE_OF_VARIABLE >> 2) != 0)
+        /* The trailer of a complete record, or the erased end of a torn one. */
+        if ((ui32Word != 0xFFFFFFFF) && (ui32Offset > 1 + RECORD_WORDS(RECORD_LENGTH(ui32Word))) &&
+            (*(last - 1 - RECORD_WORDS(RECORD_LENGTH(ui32Word))) == ui32Word))
+        {
+            return last - 1 - RECORD_WORDS(RECORD_LENGTH(ui32Word));
+        }
+        return NULL;
+    }
+
+    /* A single variable, unless it may be a complemented trailer. */
+    ui32Word = ~ui32Word;
+    if (RECORD_IS_PACKED(ui32Word) && (RECORD_LENGTH(ui32Word) > 0) &&
+        (ui32Offset > 1 + RECORD_WORDS(RECORD_LENGTH(ui32Word))) &&
+        (*(last - 1 - RECORD_WORDS(RECORD_LENGTH(ui32Word))) == ui32Word))
+    {
+        return NULL;
+    }
+
+    return last;
+}
+
+/* Locate a virtual address within a record covering it.  Returns false if the
+ * record is a tombstone. */
+static bool eeprom_record_locate(uint32_t *address, uint16_t virtual_address,
+                                 eeprom_location_t *location)
+{
+    uint32_t ui32Offset;
+
+    if (!RECORD_IS_PACKED(*address))
+    {
+        location->address = address;
+        location->lane = -1;
+        return true;
+    }
+
+    if (RECORD_LENGTH(*address) == 0)
+    {
+        return false;
+    }
+
+    ui32Offset = virtual_address - RECORD_ADDRESS(*address);
+    location->address = address + 1 + (ui32Offset >> 2);
+    location->lane = ui32Offset & 0x3;
+    return true;
+}
+
+/* Walk the page forward and locate the latest copy of a virtual address. */
+static bool eeprom_page_walk(eeprom_page_t *page, uint16_t virtual_address,
+                             eeprom_location_t *location)
+{
+    uint32_t *address = page->pui32StartAddress + 1;
+    bool bFound = false;
+
+    while ((address <= page->pui32EndAddress) && (*address != 0xFFFFFFFF))
+    {
+        if (eeprom_record_covers(address, virtual_address) &&
+            eeprom_record_valid(page, address))
+        {
+            bFound = eeprom_record_locate(address, virtual_address, location);
+        }
+        address = eeprom_record_next(address);
+    }
+
+    return bFound;
+}
+
+/* Locate the latest copy of a virtual address, scanning the page backwards
+ * from its first free word at end and stopping at the first match. */
+static bool eeprom_page_find(eeprom_page_t *page, uint32_t *end, uint16_t virtual_address,
+                             eeprom_location_t *location)
+{
+    uint32_t *address = end;
+
+    if ((address == NULL) || (address > page->pui32EndAddress + 1))
+    {
+        return eeprom_page_walk(page, virtual_address, location);
+    }
+
+    while (address > page->pui32StartAddress + 1)
+    {
+        address = eeprom_record_prev(page, address);
+        if (address == NULL)
+        {
+            return eeprom_page_walk(page, virtual_address, location);
+        }
+
+        if (eeprom_record_covers(address, virtual_address) &&
+            eeprom_record_valid(page, address))
+        {
+            return eeprom_record_locate(address, virtual_address, location);
+        }
+    }
+
+    return false;
+}
+
+static inline bool eeprom_index_covers(eeprom_handle_t *pHandle, uint16_t virtual_address)
+{
+    return (pHandle->index != NULL) && (virtual_address < pHandle->index_size);
+}
+
+/* Apply the record stored at address in the active page to the RAM index. */
+static void eeprom_index_record(eeprom_handle_t *pHandle, uint32_t *address)
+{
+    uint32_t ui32Offset;
+    uint16_t virtual_address;
+
+    if ((pHandle->index == NULL) ||
+        !eeprom_record_valid(&(pHandle->pages[pHandle->active_page]), address))
+    {
+        return;
+    }
+
+    ui32Offset = address - pHandle->pages[pHandle->active_page].pui32StartAddress;
+
+    if (RECORD_IS_PACKED(*address))
+    {
+        uint16_t ui16Length = RECORD_LENGTH(*address);
+
+        virtual_address = RECORD_ADDRESS(*address);
+        if (ui16Length == 0)
+        {
+            if (eeprom_index_covers(pHandle, virtual_address))
             {
-                return false;
+                pHandle->index[virtual_address] = 0;
             }
-            return true;
+            return;
         }
-        else
+
+        for (uint16_t i = 0; i < ui16Length; i++)
         {
-            address++;
+            if (eeprom_index_covers(pHandle, virtual_address + i))
+            {
+                pHandle->index[virtual_address + i] =
+                    INDEX_PACKED | INDEX_ENTRY(ui32Offset + 1 + (i >> 2), i & 0x3);
+            }
         }
+        return;
     }
 
-    return false;
+    virtual_address = (uint16_t)(*address >> 16);
+
+    // 0x0000 and 0xFFFF are not valid virtual addresses.
+    if (virtual_address != 0x0000 && virtual_address != 0xFFFF &&
+        eeprom_index_covers(pHandle, virtual_address))
+    {
+        pHandle->index[virtual_address] = INDEX_ENTRY(ui32Offset, 0);
+    }
+}
+
+/* Rebuild the RAM index from the content of the active page.  Records are
+ * appended, so walking the page forward leaves the latest copy of each
+ * virtual address in the index. */
+static void eeprom_index_build(eeprom_handle_t *pHandle)
+{
+    uint32_t *address;
+
+    if (pHandle->index == NULL)
+    {
+        return;
+    }
+
+    memset(pHandle->index, 0, pHandle->index_size * sizeof(uint16_t));
+
+    if (pHandle->active_page == -1)
+    {
+        return;
+    }
+
+    address = pHandle->pages[pHandle->active_page].pui32StartAddress + 1;
+    while ((address <= pHandle->pages[pHandle->active_page].pui32EndAddress) &&
+           (*address != 0xFFFFFFFF))
+    {
+        eeprom_index_record(pHandle, address);
+        address = eeprom_record_next(address);
+    }
+}
+
+/* Locate the latest copy of a virtual address in the active page. */
+static bool eeprom_locate(eeprom_handle_t *pHandle, uint16_t virtual_address,
+                          eeprom_location_t *location)
+{
+    eeprom_page_t *page = &(pHandle->pages[pHandle->active_page]);
+
+    // 0x0000 and 0xFFFF are illegal addresses.
+    if (virtual_address == 0x0000 || virtual_address == 0xFFFF)
+    {
+        return false;
+    }
+
+    if (eeprom_index_covers(pHandle, virtual_address))
+    {
+        uint16_t ui16Entry = pHandle->index[virtual_address];
+
+        if (ui16Entry == 0)
+        {
+            return false;
+        }
+        location->address = page->pui32StartAddress + INDEX_OFFSET(ui16Entry);
+        location->lane = (ui16Entry & INDEX_PACKED) ? INDEX_LANE(ui16Entry) : -1;
+        return true;
+    }
+
+    return eeprom_page_find(page, pHandle->free_address, virtual_address, location);
+}
+
+static inline uint16_t eeprom_location_value(eeprom_location_t *location)
+{
+    if (location->lane < 0)
+    {
+        return (uint16_t)(*(location->address));
+    }
+    return (uint16_t)((*(location->address) >> (8 * location->lane)) & 0xFF);
+}
+
+/* Append a record at *ppFree and advance it.  Returns the flash word
+ * written, or NULL if the page is full or programming failed. */
+static uint32_t *eeprom_page_write(eeprom_page_t *page, uint32_t **ppFree,
+                                   uint32_t *record, uint32_t ui32NumWords)
+{
+    uint32_t *address = *ppFree;
+
+    if (address + ui32NumWords - 1 > page->pui32EndAddress)
+    {
+        return NULL;
+    }
+
+    if (am_hal_flash_program_main(AM_HAL_FLASH_PROGRAM_KEY, record, address,
+                                  ui32NumWords) != 0)
+    {
+        /* Resynchronize with whatever made it to flash. */
+        *ppFree = eeprom_page_free(page);
+        return NULL;
+    }
+
+    *ppFree = address + ui32NumWords;
+    return address;
+}
+
+static void eeprom_packer_start(eeprom_packer_t *packer, uint16_t virtual_address)
+{
+    packer->virtual_address = virtual_address;
+    packer->length = 0;
+}
+
+static void eeprom_packer_add(eeprom_packer_t *packer, uint8_t data)
+{
+    uint32_t *word = &(packer->buffer[1 + (packer->length >> 2)]);
+    uint32_t ui32Shift = 8 * (packer->length & 0x3);
+
+    /* Unused lanes of the last word are left erased. */
+    if ((packer->length & 0x3) == 0)
+    {
+        *word = 0xFFFFFFFF;
+    }
+    *word = (*word & ~(0xFFUL << ui32Shift)) | ((uint32_t)data << ui32Shift);
+    packer->length++;
+}
+
+/* Finalize the packed record and return its size in words. */
+static uint32_t eeprom_packer_finish(eeprom_packer_t *packer)
+{
+    uint32_t ui32Header = RECORD_HEADER(packer->virtual_address, packer->length);
+
+    packer->buffer[0] = ui32Header;
+    packer->buffer[1 + RECORD_WORDS(packer->length)] = RECORD_TRAILER(ui32Header);
+    return RECORD_SIZE(packer->length);
+}
+
+static bool eeprom_transfer_flush(eeprom_handle_t *pHandle, eeprom_packer_t *packer)
+{
+    uint32_t ui32NumWords;
+
+    if (packer->length == 0)
+    {
+        return true;
+    }
+
+    ui32NumWords = eeprom_packer_finish(packer);
+    packer->length = 0;
+
+    return eeprom_page_write(&(pHandle->pages[pHandle->receiving_page]),
+                             &(pHandle->receiving_free_address), packer->buffer,
+                             ui32NumWords) != NULL;
 }
 
-static int eeprom_page_transfer(eeprom_handle_t *pHandle, uint16_t virtual_address, uint16_t data)
+/* Copy one live value to the receiving page.  Byte values with consecutive
+ * virtual addresses are coalesced into packed records, which also migrates
+ * pages written one byte per variable to the packed format. */
+static bool eeprom_transfer_value(eeprom_handle_t *pHandle, eeprom_packer_t *packer,
+                                  uint16_t virtual_address, uint16_t data)
 {
+    if (packer->length > 0 &&
+        (data > 0xFF ||
+         virtual_address != packer->virtual_address + packer->length ||
+         packer->length == EEPROM_RECORD_MAX_SIZE))
+    {
+        if (!eeprom_transfer_flush(pHandle, packer))
+        {
+            return false;
+        }
+    }
+
+    if (data > 0xFF)
+    {
+        uint32_t virtualAddressAndData =
+            ((uint32_t)(virtual_address << 16) & 0xFFFF0000) | (uint32_t)(data);
+        return eeprom_page_write(&(pHandle->pages[pHandle->receiving_page]),
+                                 &(pHandle->receiving_free_address),
+                                 &virtualAddressAndData, 1) != NULL;
+    }
+
+    if (packer->length == 0)
+    {
+        eeprom_packer_start(packer, virtual_address);
+    }
+    eeprom_packer_add(packer, (uint8_t)data);
+
+    return true;
+}
+
+/* A value found in the active page is transferred if it is the latest copy of
+ * its virtual address.  When resuming a transfer interrupted by a reset, values
+ * the receiving page already holds are not copied again. */
+static bool eeprom_transfer_is_live(eeprom_handle_t *pHandle, uint16_t virtual_address,
+                                    eeprom_location_t *location, bool bResume)
+{
+    eeprom_location_t latest;
+
+    if (!eeprom_locate(pHandle, virtual_address, &latest) ||
+        latest.address != location->address || latest.lane != location->lane)
+    {
+        return false;
+    }
+
+    if (bResume &&
+        eeprom_page_find(&(pHandle->pages[pHandle->receiving_page]),
+                         pHandle->receiving_free_address, virtual_address, &latest) &&
+        eeprom_location_value(&latest) == eeprom_location_value(location))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/* Select and prepare the receiving page, then point the transfer cursor at the
+ * first record of the active page. */
+static int eeprom_transfer_start(eeprom_handle_t *pHandle)
+{
+    eeprom_page_t *receiving;
     int status;
-    uint32_t *pui32ActiveAddress;
-    uint32_t *pui32ReceivingAddress;
-    uint32_t *pui32EndAddress;
-    uint32_t ui32EraseCount;
-    bool bNewData = false;
 
     /* If there is no receiving page predefined, set it to cycle through all allocated pages. */
     if (pHandle->receiving_page == -1)
@@ -145,89 +594,115 @@ static int eeprom_page_transfer(eeprom_handle_t *pHandle, uint16_t virtual_addre
         {
             pHandle->receiving_page = 0;
         }
+    }
 
-        /* Check if the new receiving page really is erased. */
-        if (!eeprom_page_validate_empty(&(pHandle->pages[pHandle->receiving_page])))
+    receiving = &(pHandle->pages[pHandle->receiving_page]);
+
+    /* Check if the new receiving page really is erased. */
+    if (!eeprom_page_validate_empty(receiving))
+    {
+        /* If this page is not truly erased, it means that it has been written to
+         * from outside this API, this could be an address conflict. */
+        status = eeprom_page_erase(pHandle, receiving);
+        if (status != 0)
         {
-            /* If this page is not truly erased, it means that it has been written to
-             * from outside this API, this could be an address conflict. */
-            am_hal_flash_page_erase(
-                AM_HAL_FLASH_PROGRAM_KEY,
-                AM_HAL_FLASH_ADDR2INST(
-                    (uint32_t)(pHandle->pages[pHandle->receiving_page].pui32StartAddress)),
-                AM_HAL_FLASH_ADDR2PAGE(
-                    (uint32_t)(pHandle->pages[pHandle->receiving_page].pui32StartAddress)));
+            return status;
         }
     }
 
     /* Set the status of the receiving page */
-    eeprom_page_set_receiving(&(pHandle->pages[pHandle->receiving_page]));
-
-    /* If an address was specified, write it to the receiving page */
-    if (virtual_address != 0)
+    status = eeprom_page_set_receiving(receiving);
+    if (status != 0)
     {
-        eeprom_page_write(&(pHandle->pages[pHandle->receiving_page]), virtual_address, data);
+        return status;
     }
 
-    /* Start at the last word. */
-    pui32ActiveAddress = pHandle->pages[pHandle->active_page].pui32EndAddress;
+    pHandle->receiving_free_address = receiving->pui32StartAddress + 1;
+    pHandle->transfer_address = pHandle->pages[pHandle->active_page].pui32StartAddress + 1;
 
-    /* Iterate through all words in the active page. Each time a new virtual
-     * address is found, write it and it's data to the receiving page */
-    while (pui32ActiveAddress > pHandle->pages[pHandle->active_page].pui32StartAddress)
+    return 0;
+}
+
+/* Copy live values from the transfer cursor onward to the receiving page,
+ * stopping after ui32Budget words of the active page (0 for no limit).
+ * Records appended to the active page meanwhile are picked up by later calls,
+ * so a value rewritten after being copied is copied again.  Returns false if
+ * the receiving page ran out of room. */
+static bool eeprom_transfer_copy(eeprom_handle_t *pHandle, uint32_t ui32Budget, bool bResume)
+{
+    uint32_t *pui32ActiveAddress = pHandle->transfer_address;
+    uint32_t *pui32Limit = pHandle->transfer_address + ui32Budget;
+    eeprom_location_t location;
+    eeprom_packer_t packer;
+    bool bRoom = true;
+
+    packer.buffer = pHandle->transfer_buffer;
+    packer.length = 0;
+
+    while (bRoom && (pui32ActiveAddress < pHandle->free_address) &&
+           ((ui32Budget == 0) || (pui32ActiveAddress < pui32Limit)))
     {
-        // 0x0000 and 0xFFFF are not valid virtual addresses.
-        if ((uint16_t)(*pui32ActiveAddress >> 16) == 0x0000 ||
-            (uint16_t)(*pui32ActiveAddress >> 16) == 0xFFFF)
-        {
-            bNewData = false;
-        }
-        /*
-        // Omit when transfer is initiated from inside the eeprom_init() function.
-        else if (address != 0 && (uint16_t)(*pui32ActiveAddress >> 16) > numberOfVariablesDeclared)
+        if (!eeprom_record_valid(&(pHandle->pages[pHandle->active_page]), pui32ActiveAddress))
         {
-        // A virtual address outside the virtual address space, defined by the
-        // number of variables declared, are considered garbage.
-        newVariable = false;
+            /* Torn record, left behind. */
         }
-        */
-        else
+        else if (RECORD_IS_PACKED(*pui32ActiveAddress))
         {
-            pui32ReceivingAddress =
-                pHandle->pages[pHandle->receiving_page].pui32StartAddress + 1;
+            uint16_t virtual_address = RECORD_ADDRESS(*pui32ActiveAddress);
+            uint16_t ui16Length = RECORD_LENGTH(*pui32ActiveAddress);
 
-            /* Start at the beginning of the receiving page. Check if the variable is
-             * already transfered. */
-            pui32EndAddress = pHandle->pages[pHandle->receiving_page].pui32EndAddress;
-            while (pui32ReceivingAddress <= pui32EndAddress)
+            for (uint16_t i = 0; bRoom && (i < ui16Length); i++)
             {
-                /* Variable found, and is therefore already transferred. */
-                if ((uint16_t)(*pui32ActiveAddress >> 16) ==
-                    (uint16_t)(*pui32ReceivingAddress >> 16))
-                {
-                    bNewData = false;
-                    break;
-                }
-                /* Empty word found. All transferred variables are checked.  */
-                else if (*pui32ReceivingAddress == 0xFFFFFFFF)
+                location.address = pui32ActiveAddress + 1 + (i >> 2);
+                location.lane = i & 0x3;
+                if (eeprom_transfer_is_live(pHandle, virtual_address + i, &location, bResume))
                 {
-                    bNewData = true;
-                    break;
+                    bRoom = eeprom_transfer_value(pHandle, &packer, virtual_address + i,
+                                                  eeprom_location_value(&location));
                 }
-                pui32ReceivingAddress++;
             }
         }
-
-        if (bNewData)
+        else
         {
-            /* Write the new variable to the receiving page. */
-            eeprom_page_write(&(pHandle->pages[pHandle->receiving_page]),
-                              (uint16_t)(*pui32ActiveAddress >> 16),
-                              (uint16_t)(*pui32ActiveAddress));
+            uint16_t virtual_address = (uint16_t)(*pui32ActiveAddress >> 16);
+
+            location.address = pui32ActiveAddress;
+            location.lane = -1;
+
+            // 0x0000 and 0xFFFF are not valid virtual addresses.
+            if (virtual_address != 0x0000 && virtual_address != 0xFFFF &&
+                eeprom_transfer_is_live(pHandle, virtual_address, &location, bResume))
+            {
+                bRoom = eeprom_transfer_value(pHandle, &packer, virtual_address,
+                                              eeprom_location_value(&location));
+            }
         }
-        pui32ActiveAddress--;
+        pui32ActiveAddress = eeprom_record_next(pui32ActiveAddress);
+    }
+
+    /* Nothing is left buffered between steps, a write in between could
+     * otherwise be superseded by an older value. */
+    if (bRoom)
+    {
+        bRoom = eeprom_transfer_flush(pHandle, &packer);
     }
 
+    if (bRoom)
+    {
+        pHandle->transfer_address = pui32ActiveAddress;
+    }
+
+    return bRoom;
+}
+
+/* Make the receiving page the new active page and erase the old one. */
+static int eeprom_transfer_finish(eeprom_handle_t *pHandle)
+{
+    int status;
+    uint32_t ui32EraseCount;
+    eeprom_page_t *active = &(pHandle->pages[pHandle->active_page]);
+    eeprom_page_t *receiving = &(pHandle->pages[pHandle->receiving_page]);
+
     /* Update erase count */
     ui32EraseCount = eeprom_erase_counter(pHandle);
 
@@ -241,26 +716,21 @@ static int eeprom_page_transfer(eeprom_handle_t *pHandle, uint16_t virtual_addre
     /* Write the erase count obtained to the active page head. */
     status = am_hal_flash_program_main(
         AM_HAL_FLASH_PROGRAM_KEY, &ui32EraseCount,
-        pHandle->pages[pHandle->receiving_page].pui32StartAddress, SIZE_OF_VARIABLE >> 2);
+        receiving->pui32StartAddress, SIZE_OF_VARIABLE >> 2);
     if (status != 0)
     {
         return status;
     }
 
     /* Erase the old active page. */
-    status = am_hal_flash_page_erase(
-        AM_HAL_FLASH_PROGRAM_KEY,
-        AM_HAL_FLASH_ADDR2INST(
-            (uint32_t)(pHandle->pages[pHandle->active_page].pui32StartAddress)),
-        AM_HAL_FLASH_ADDR2PAGE(
-            (uint32_t)(pHandle->pages[pHandle->active_page].pui32StartAddress)));
+    status = eeprom_page_erase(pHandle, active);
     if (status != 0)
     {
         return status;
     }
 
     /* Set the receiving page to be the new active page. */
-    status = eeprom_page_set_active(&(pHandle->pages[pHandle->receiving_page]));
+    status = eeprom_page_set_active(receiving);
     if (status != 0)
     {
         return status;
@@ -268,10 +738,85 @@ static int eeprom_page_transfer(eeprom_handle_t *pHandle, uint16_t virtual_addre
 
     pHandle->active_page = pHandle->receiving_page;
     pHandle->receiving_page = -1;
+    pHandle->free_address = pHandle->receiving_free_address;
+    pHandle->transfer_address = NULL;
+
+    eeprom_index_build(pHandle);
 
     return 0;
 }
 
+/* Run a page transfer to completion, continuing one already in progress. */
+static int eeprom_page_transfer(eeprom_handle_t *pHandle, bool bResume)
+{
+    int status;
+
+    if (pHandle->receiving_page == -1)
+    {
+        status = eeprom_transfer_start(pHandle);
+        if (status != 0)
+        {
+            return status;
+        }
+    }
+
+    if (!eeprom_transfer_copy(pHandle, 0, bResume))
+    {
+        /* The receiving page filled up with values that were rewritten during
+         * the transfer.  Start over on a clean page, the active page does not
+         * change until the copy completes. */
+        status = eeprom_transfer_start(pHandle);
+        if (status != 0)
+        {
+            return status;
+        }
+
+        if (!eeprom_transfer_copy(pHandle, 0, false))
+        {
+            return -1;
+        }
+    }
+
+    return eeprom_transfer_finish(pHandle);
+}
+
+/* Append a record to the active page, transferring to a new page when full. */
+static bool eeprom_record_write(eeprom_handle_t *pHandle, uint32_t *record,
+                                uint32_t ui32NumWords)
+{
+    uint32_t *address;
+
+    address = eeprom_page_write(&(pHandle->pages[pHandle->active_page]),
+                                &(pHandle->free_address), record, ui32NumWords);
+    if (address == NULL)
+    {
+        if (eeprom_page_transfer(pHandle, false) != 0)
+        {
+            return false;
+        }
+
+        address = eeprom_page_write(&(pHandle->pages[pHandle->active_page]),
+                                    &(pHandle->free_address), record, ui32NumWords);
+        if (address == NULL)
+        {
+            return false;
+        }
+    }
+
+    eeprom_index_record(pHandle, address);
+    return true;
+}
+
+/* Write a single variable record. */
+static bool eeprom_variable_write(eeprom_handle_t *pHandle, uint16_t virtual_address,
+                                  uint16_t data)
+{
+    uint32_t virtualAddressAndData =
+        ((uint32_t)(virtual_address << 16) & 0xFFFF0000) | (uint32_t)(data);
+
+    return eeprom_record_write(pHandle, &virtualAddressAndData, 1);
+}
+
 uint32_t eeprom_init(uint32_t ui32StartAddress, uint32_t ui32NumberOfPages, eeprom_handle_t *pHandle)
 {
     if (pHandle == NULL)
@@ -293,6 +838,10 @@ uint32_t eeprom_init(uint32_t ui32StartAddress, uint32_t ui32NumberOfPages, eepr
     pHandle->active_page = -1;
     pHandle->receiving_page = -1;
     pHandle->allocated_pages = ui32NumberOfPages;
+    pHandle->free_address = NULL;
+    pHandle->receiving_free_address = NULL;
+    pHandle->transfer_address = NULL;
+    pHandle->page_erases = 0;
 
     /* Initialize the address of each page */
     uint32_t i;
@@ -328,35 +877,39 @@ uint32_t eeprom_init(uint32_t ui32StartAddress, uint32_t ui32NumberOfPages, eepr
         case EEPROM_PAGE_STATUS_ERASED:
             // Validate if the page is really erased, and erase it if not.
             if (!eeprom_page_validate_empty(&(pHandle->pages[i]))) {
-                am_hal_flash_page_erase(AM_HAL_FLASH_PROGRAM_KEY,
-                                        AM_HAL_FLASH_ADDR2INST((uint32_t)(
-                                            pHandle->pages[i].pui32StartAddress)),
-                                        AM_HAL_FLASH_ADDR2PAGE((uint32_t)(
-                                            pHandle->pages[i].pui32StartAddress)));
+                eeprom_page_erase(pHandle, &(pHandle->pages[i]));
             }
             break;
         default:
             // Undefined page status, erase page.
-            am_hal_flash_page_erase(
-                AM_HAL_FLASH_PROGRAM_KEY,
-                AM_HAL_FLASH_ADDR2INST((uint32_t)(pHandle->pages[i].pui32StartAddress)),
-                AM_HAL_FLASH_ADDR2PAGE((uint32_t)(pHandle->pages[i].pui32StartAddress)));
+            eeprom_page_erase(pHandle, &(pHandle->pages[i]));
             break;
         }
     }
 
     if ((pHandle->receiving_page == -1) && (pHandle->active_page == -1)) {
+        eeprom_index_build(pHandle);
         return false;
     }
 
     if (pHandle->receiving_page == -1) {
+        pHandle->free_address = eeprom_page_free(&(pHandle->pages[pHandle->active_page]));
+        eeprom_index_build(pHandle);
         return true;
     } else if (pHandle->active_page == -1) {
         pHandle->active_page = pHandle->receiving_page;
         pHandle->receiving_page = -1;
         eeprom_page_set_active(&(pHandle->pages[pHandle->active_page]));
+        pHandle->free_address = eeprom_page_free(&(pHandle->pages[pHandle->active_page]));
+        eeprom_index_build(pHandle);
     } else {
-        eeprom_page_transfer(pHandle, 0, 0);
+        /* A transfer was interrupted, complete it from the start of the active page. */
+        pHandle->free_address = eeprom_page_free(&(pHandle->pages[pHandle->active_page]));
+        pHandle->receiving_free_address =
+            eeprom_page_free(&(pHandle->pages[pHandle->receiving_page]));
+        pHandle->transfer_address = pHandle->pages[pHandle->active_page].pui32StartAddress + 1;
+        eeprom_index_build(pHandle);
+        eeprom_page_transfer(pHandle, true);
     }
 
     return true;
@@ -372,10 +925,7 @@ uint32_t eeprom_format(eeprom_handle_t *pHandle)
     {
         if (!eeprom_page_validate_empty(&(pHandle->pages[i])))
         {
-            status = am_hal_flash_page_erase(
-                AM_HAL_FLASH_PROGRAM_KEY,
-                AM_HAL_FLASH_ADDR2INST((uint32_t)(pHandle->pages[i].pui32StartAddress)),
-                AM_HAL_FLASH_ADDR2PAGE((uint32_t)(pHandle->pages[i].pui32StartAddress)));
+            status = eeprom_page_erase(pHandle, &(pHandle->pages[i]));
             if (status != 0)
             {
                 return false;
@@ -385,6 +935,10 @@ uint32_t eeprom_format(eeprom_handle_t *pHandle)
 
     pHandle->active_page = 0;
     pHandle->receiving_page = -1;
+    pHandle->free_address = pHandle->pages[pHandle->active_page].pui32StartAddress + 1;
+    pHandle->transfer_address = NULL;
+
+    eeprom_index_build(pHandle);
 
     status = am_hal_flash_program_main(
         AM_HAL_FLASH_PROGRAM_KEY, &ui32EraseCount,
@@ -406,24 +960,17 @@ uint32_t eeprom_format(eeprom_handle_t *pHandle)
 
 uint32_t eeprom_read(eeprom_handle_t *pHandle, uint16_t virtual_address, uint16_t *data)
 {
-    uint32_t *pui32Address;
+    eeprom_location_t location;
 
     if (!pHandle->allocated) {
         return false;
     }
 
-    pui32Address = (pHandle->pages[pHandle->active_page].pui32EndAddress);
-
-    // 0x0000 and 0xFFFF are illegal addresses.
-    if (virtual_address != 0x0000 && virtual_address != 0xFFFF) {
-        while (pui32Address > pHandle->pages[pHandle->active_page].pui32StartAddress) {
-            if ((uint16_t)(*pui32Address >> 16) == virtual_address) {
-                *data = (uint16_t)(*pui32Address);
-                return true;
-            }
-            pui32Address--;
-        }
+    if (eeprom_locate(pHandle, virtual_address, &location)) {
+        *data = eeprom_location_value(&location);
+        return true;
     }
+
     // Variable not found, return null value.
     *data = 0x0000;
 
@@ -485,15 +1032,17 @@ uint32_t eeprom_write(eeprom_handle_t *pHandle, uint16_t virtual_address, uint16
 
     uint16_t stored_value;
 
+    if (virtual_address > VARIABLE_ADDRESS_MAX) {
+        return false;
+    }
+
     if (eeprom_read(pHandle, virtual_address, &stored_value)) {
         if (stored_value == data) {
             return true;
         }
     }
 
-    if (!eeprom_page_write(&(pHandle->pages[pHandle->active_page]), virtual_address, data)) {
-        eeprom_page_transfer(pHandle, virtual_address, data);
-    }
+    eeprom_variable_write(pHandle, virtual_address, data);
 
     return true;
 }
@@ -506,6 +1055,10 @@ uint32_t eeprom_write_array(eeprom_handle_t *pHandle, uint16_t virtual_address,
 
     uint16_t stored_value;
 
+    if (len == 0 || virtual_address + len - 1 > VARIABLE_ADDRESS_MAX) {
+        return false;
+    }
+
     if (eeprom_read(pHandle, virtual_address, &stored_value)) {
         uint8_t stored_len = (stored_value >> 8) & 0xFF;
         if (stored_len != len) {
@@ -517,20 +1070,13 @@ uint32_t eeprom_write_array(eeprom_handle_t *pHandle, uint16_t virtual_address,
     }
 
     uint16_t value = (len << 8) | data[0];
-    if (!eeprom_page_write(
-            &(pHandle->pages[pHandle->active_page]),
-            virtual_address, value)) {
-        eeprom_page_transfer(pHandle, virtual_address, value);
-    }
+    eeprom_variable_write(pHandle, virtual_address, value);
 
     for (int i = 1; i < len; i++)
     {
-        if (!eeprom_page_write(
-                &(pHandle->pages[pHandle->active_page]), virtual_address + i, data[i])) {
-            eeprom_page_transfer(pHandle, virtual_address + i, data[i]);
-        }
+        eeprom_variable_write(pHandle, virtual_address + i, data[i]);
     }
-    
+
     return true;
 }
 
@@ -540,9 +1086,87 @@ uint32_t eeprom_write_array_len(eeprom_handle_t *pHandle, uint16_t virtual_addre
         return false;
     }
 
-    for (int i = 0; i < size; i++)
+    if (virtual_address == 0x0000 || (uint32_t)virtual_address + size > 0xFFFF) {
+        return false;
+    }
+
+    /* The array is stored as packed records of up to EEPROM_RECORD_MAX_SIZE
+     * bytes.  Bytes at either end of a record that already hold the requested
+     * value are trimmed, and unchanged records are not written at all. */
+    for (uint16_t i = 0; i < size; i += EEPROM_RECORD_MAX_SIZE)
+    {
+        uint16_t first = i;
+        uint16_t last = i + EEPROM_RECORD_MAX_SIZE;
+        eeprom_packer_t packer;
+        uint16_t stored_value;
+
+        if (last > size) {
+            last = size;
+        }
+
+        while (first < last &&
+               eeprom_read(pHandle, virtual_address + first, &stored_value) &&
+               stored_value == data[first]) {
+            first++;
+        }
+
+        while (last > first &&
+               eeprom_read(pHandle, virtual_address + last - 1, &stored_value) &&
+               stored_value == data[last - 1]) {
+            last--;
+        }
+
+        if (first == last) {
+            continue;
+        }
+
+        packer.buffer = pHandle->record_buffer;
+        eeprom_packer_start(&packer, virtual_address + first);
+        for (uint16_t j = first; j < last; j++) {
+            eeprom_packer_add(&packer, data[j]);
+        }
+
+        if (!eeprom_record_write(pHandle, packer.buffer, eeprom_packer_finish(&packer))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Delete every copy of a virtual address from a page.  Single variables are
+ * cleared in place, a byte inside a packed record gets a tombstone appended.
+ * Returns false if there is no room left for the tombstone. */
+static bool eeprom_page_delete(eeprom_page_t *page, uint32_t **ppFree,
+                               uint16_t virtual_address, bool *pbDeleted)
+{
+    eeprom_location_t location;
+
+    uint32_t data = 0x0000FFFF;
+    uint32_t *address = page->pui32StartAddress + 1;
+
+    while (address < *ppFree)
     {
-        eeprom_write(pHandle, virtual_address + i, data[i]);
+        if (!RECORD_IS_PACKED(*address) && (uint16_t)(*address >> 16) == virtual_address)
+        {
+            *pbDeleted = true;
+            am_hal_flash_program_main(
+                  AM_HAL_FLASH_PROGRAM_KEY,
+                  &data, address,
+                  SIZE_OF_VARIABLE >> 2);
+        }
+        address = eeprom_record_next(address);
+    }
+
+    if (eeprom_page_find(page, *ppFree, virtual_address, &location))
+    {
+        uint32_t tombstone = RECORD_HEADER(virtual_address, 0);
+
+        *pbDeleted = true;
+        if (eeprom_page_write(page, ppFree, &tombstone, 1) == NULL)
+        {
+            return false;
+        }
     }
 
     return true;
@@ -556,20 +1180,36 @@ uint32_t eeprom_delete(eeprom_handle_t *pHandle, uint16_t virtual_address)
 
     bool bDeleted = false;
 
-    uint32_t data = 0x0000FFFF;
-    uint32_t *address = pHandle->pages[pHandle->active_page].pui32EndAddress;
+    // 0x0000 and 0xFFFF are illegal addresses.
+    if (virtual_address == 0x0000 || virtual_address == 0xFFFF)
+    {
+        return false;
+    }
 
-    while (address > pHandle->pages[pHandle->active_page].pui32StartAddress)
+    /* Values already copied by a transfer in progress must not come back.  If
+     * the receiving page has no room for a tombstone, complete the transfer. */
+    if (pHandle->receiving_page != -1)
     {
-        if ((uint16_t)(*address >> 16) == virtual_address)
+        if (!eeprom_page_delete(&(pHandle->pages[pHandle->receiving_page]),
+                                &(pHandle->receiving_free_address), virtual_address,
+                                &bDeleted))
         {
-            bDeleted = true;
-            am_hal_flash_program_main(
-                  AM_HAL_FLASH_PROGRAM_KEY,
-                  &data, address,
-                  SIZE_OF_VARIABLE >> 2);
+            eeprom_page_transfer(pHandle, false);
         }
-        address--;
+    }
+
+    if (!eeprom_page_delete(&(pHandle->pages[pHandle->active_page]),
+                            &(pHandle->free_address), virtual_address, &bDeleted))
+    {
+        /* A transfer drops the cleared single variables, retry on the new page. */
+        eeprom_page_transfer(pHandle, false);
+        eeprom_page_delete(&(pHandle->pages[pHandle->active_page]),
+                           &(pHandle->free_address), virtual_address, &bDeleted);
+    }
+
+    if (eeprom_index_covers(pHandle, virtual_address))
+    {
+        pHandle->index[virtual_address] = 0;
     }
 
     return bDeleted;
@@ -596,6 +1236,51 @@ uint32_t eeprom_delete_array(eeprom_handle_t *pHandle, uint16_t virtual_address)
     return bDeleted;
 }
 
+uint32_t eeprom_compact_pending(eeprom_handle_t *pHandle)
+{
+    eeprom_page_t *page;
+
+    if (!pHandle->allocated || pHandle->active_page == -1) {
+        return false;
+    }
+
+    if (pHandle->receiving_page != -1) {
+        return true;
+    }
+
+    page = &(pHandle->pages[pHandle->active_page]);
+
+    return (uint32_t)(page->pui32EndAddress + 1 - pHandle->free_address) <
+           pHandle->compaction_threshold;
+}
+
+uint32_t eeprom_compact_step(eeprom_handle_t *pHandle, uint32_t ui32Budget)
+{
+    if (!eeprom_compact_pending(pHandle)) {
+        return false;
+    }
+
+    if (pHandle->receiving_page == -1) {
+        return eeprom_transfer_start(pHandle) == 0;
+    }
+
+    if (!eeprom_transfer_copy(pHandle, ui32Budget, false)) {
+        /* Out of room on the receiving page, fall back to a full transfer. */
+        eeprom_page_transfer(pHandle, false);
+        return false;
+    }
+
+    /* Writes in between steps move the end of the active page, so finish as
+     * soon as the copy has caught up. */
+    if (pHandle->transfer_address < pHandle->free_address) {
+        return true;
+    }
+
+    eeprom_transfer_finish(pHandle);
+
+    return false;
+}
+
 uint32_t eeprom_erase_counter(eeprom_handle_t *pHandle)
 {
     if (pHandle->active_page == -1)
@@ -615,3 +1300,35 @@ uint32_t eeprom_erase_counter(eeprom_handle_t *pHandle)
 
     return eraseCount;
 }
+
+uint32_t eeprom_stats(eeprom_handle_t *pHandle, eeprom_stats_t *pStats)
+{
+    eeprom_page_t *page;
+
+    if (!pHandle->allocated || pHandle->active_page == -1 || pStats == NULL) {
+        return false;
+    }
+
+    page = &(pHandle->pages[pHandle->active_page]);
+
+    pStats->erase_count = eeprom_erase_counter(pHandle);
+    pStats->page_erases = pHandle->page_erases;
+    pStats->free_bytes = (uint32_t)(page->pui32EndAddress + 1 - pHandle->free_address) * sizeof(uint32_t);
+    pStats->page_bytes = AM_HAL_FLASH_PAGE_SIZE - sizeof(uint32_t);
+
+    return true;
+}
+
+void eeprom_lock(eeprom_handle_t *pHandle)
+{
+    if (pHandle->lock != NULL) {
+        pHandle->lock();
+    }
+}
+
+void eeprom_unlock(eeprom_handle_t *pHandle)
+{
+    if (pHandle->unlock != NULL) {
+        pHandle->unlock();
+    }
+}
@@ -39,19 +39,64 @@ extern "C" {
 #define EEPROM_STATUS_OK          0
 #define EEPROM_STATUS_ERROR       1
 
+/* Largest payload of a packed record written by eeprom_write_array_len(), at
+ * most 1023 bytes.  Longer arrays are split over
+ * several records.  Virtual addresses 0xF000 and above are reserved for packed
+ * record headers and are rejected by eeprom_write() and eeprom_write_array(). */
+#ifndef EEPROM_RECORD_MAX_SIZE
+#define EEPROM_RECORD_MAX_SIZE    256
+#endif
+
+/* A packed record in words: header, payload and trailer. */
+#define EEPROM_RECORD_BUFFER_WORDS (2 + ((EEPROM_RECORD_MAX_SIZE + 3) >> 2))
+
 typedef struct {
     uint32_t *pui32StartAddress;
     uint32_t *pui32EndAddress;
 } eeprom_page_t;
 
+/* Optional RAM index of the active page.  When index is not NULL, it must
+ * point to index_size entries before eeprom_init() is called.  Entry n locates
+ * virtual address n within the active page, or is 0 if the variable is not
+ * stored.  Virtual addresses at or above index_size fall back to scanning the
+ * page.
+ *
+ * compaction_threshold is the number of free words in the active page below
+ * which eeprom_compact_pending() requests a background page transfer, 0 leaves
+ * transfers to the write that fills the page.
+ *
+ * lock and unlock, when set, are called by eeprom_lock() and eeprom_unlock().
+ * A handle shared by several tasks must be used between these calls.
+ *
+ * The remaining members are private to eeprom_emulation.c: page_erases counts
+ * the pages erased since eeprom_init(), and records are assembled in the
+ * buffers before being programmed in one go. */
 typedef struct {
     uint8_t allocated;
     int16_t active_page;
     int16_t receiving_page;
     int16_t allocated_pages;
     eeprom_page_t *pages;
+    uint16_t *index;
+    uint16_t index_size;
+    uint16_t compaction_threshold;
+    uint32_t *free_address;
+    uint32_t *receiving_free_address;
+    uint32_t *transfer_address;
+    void (*lock)(void);
+    void (*unlock)(void);
+    uint32_t page_erases;
+    uint32_t record_buffer[EEPROM_RECORD_BUFFER_WORDS];
+    uint32_t transfer_buffer[EEPROM_RECORD_BUFFER_WORDS];
 } eeprom_handle_t;
 
+typedef struct {
+    uint32_t erase_count; /* completed cycles through all pages */
+    uint32_t page_erases; /* pages erased since eeprom_init() */
+    uint32_t free_bytes;  /* room left in the active page */
+    uint32_t page_bytes;  /* room in an empty page */
+} eeprom_stats_t;
+
 uint32_t eeprom_init(uint32_t ui32StartAddress, uint32_t ui32NumberOfPages, eeprom_handle_t *pHandle);
 uint32_t eeprom_format(eeprom_handle_t *pHandle);
 
@@ -65,7 +110,17 @@ uint32_t eeprom_write_array_len(eeprom_handle_t *pHandle, uint16_t address, uint
 uint32_t eeprom_delete(eeprom_handle_t *pHandle, uint16_t virtual_address);
 uint32_t eeprom_delete_array(eeprom_handle_t *pHandle, uint16_t virtual_address);
 
+/* Incremental page transfer.  eeprom_compact_step() copies at most ui32Budget
+ * words of the active page per call, erases the old page once everything is
+ * copied, and returns true while the transfer is still in progress. */
+uint32_t eeprom_compact_pending(eeprom_handle_t *pHandle);
+uint32_t eeprom_compact_step(eeprom_handle_t *pHandle, uint32_t ui32Budget);
+
 uint32_t eeprom_erase_counter(eeprom_handle_t *pHandle);
+uint32_t eeprom_stats(eeprom_handle_t *pHandle, eeprom_stats_t *pStats);
+
+void eeprom_lock(eeprom_handle_t *pHandle);
+void eeprom_unlock(eeprom_handle_t *pHandle);
 
 #ifdef __cplusplus
 }
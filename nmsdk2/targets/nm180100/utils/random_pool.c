@@ -0,0 +1,305 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(RANDOM_POOL_STUB_ENTROPY)
+#define RANDOM_POOL_CRITICAL_BEGIN
+#define RANDOM_POOL_CRITICAL_END
+#else
+#include <am_mcu_apollo.h>
+#include <am_util_id.h>
+#define RANDOM_POOL_CRITICAL_BEGIN AM_CRITICAL_BEGIN
+#define RANDOM_POOL_CRITICAL_END   AM_CRITICAL_END
+#endif
+
+#include "random_pool.h"
+
+#define RANDOM_POOL_KEY_SIZE    32
+#define RANDOM_POOL_BLOCK_WORDS 16
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTER_ROUND(a, b, c, d)                                                                  \
+    do {                                                                                           \
+        a += b; d ^= a; d = ROTL32(d, 16);                                                         \
+        c += d; b ^= c; b = ROTL32(b, 12);                                                         \
+        a += b; d ^= a; d = ROTL32(d, 8);                                                          \
+        c += d; b ^= c; b = ROTL32(b, 7);                                                          \
+    } while (0)
+
+/* The first half of every block replaces the key, the second half is handed
+ * out from random_pool_buffer and erased as it goes. */
+static uint32_t random_pool_key[RANDOM_POOL_KEY_SIZE / 4];
+static uint8_t random_pool_buffer[RANDOM_POOL_KEY_SIZE];
+static uint32_t random_pool_available;
+static uint32_t random_pool_blocks;
+static bool random_pool_is_seeded;
+
+/* Written by the entropy collector in interrupt context, folded into the key
+ * by the next caller. */
+static uint8_t random_pool_entropy[RANDOM_POOL_SEED_SIZE];
+static volatile bool random_pool_entropy_ready;
+static volatile bool random_pool_collecting;
+
+static void random_pool_block(uint32_t *pui32Output)
+{
+    static const uint32_t sigma[4] = {0x61707865, 0x3320646E, 0x79622D32, 0x6B206574};
+    uint32_t x[RANDOM_POOL_BLOCK_WORDS];
+    uint32_t i;
+
+    /* The key never encrypts two blocks, so the counter and nonce stay zero. */
+    memcpy(&x[0], sigma, sizeof(sigma));
+    memcpy(&x[4], random_pool_key, sizeof(random_pool_key));
+    memset(&x[12], 0, 4 * sizeof(uint32_t));
+    memcpy(pui32Output, x, sizeof(x));
+
+    for (i = 0; i < 10; i++)
+    {
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+
+    for (i = 0; i < RANDOM_POOL_BLOCK_WORDS; i++)
+    {
+        pui32Output[i] += x[i];
+    }
+    memset(x, 0, sizeof(x));
+}
+
+static void random_pool_rekey(void)
+{
+    uint32_t block[RANDOM_POOL_BLOCK_WORDS];
+
+    random_pool_block(block);
+    memcpy(random_pool_key, &block[0], RANDOM_POOL_KEY_SIZE);
+    memcpy(random_pool_buffer, &block[8], RANDOM_POOL_KEY_SIZE);
+    memset(block, 0, sizeof(block));
+
+    random_pool_available = RANDOM_POOL_KEY_SIZE;
+    random_pool_blocks++;
+}
+
+static void random_pool_mix(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    uint8_t *pui8Key = (uint8_t *)random_pool_key;
+    uint32_t i;
+
+    while (ui32Length)
+    {
+        for (i = 0; (i < RANDOM_POOL_KEY_SIZE) && ui32Length; i++, ui32Length--)
+        {
+            pui8Key[i] ^= *pui8Data++;
+        }
+        random_pool_rekey();
+    }
+
+    /* Nothing drawn after this point may come from the old key. */
+    memset(random_pool_buffer, 0, sizeof(random_pool_buffer));
+    random_pool_available = 0;
+}
+
+#if defined(RANDOM_POOL_STUB_ENTROPY)
+static void random_pool_collect(void)
+{
+    static uint32_t ui32State = 0x2545F491;
+    uint32_t i;
+
+    for (i = 0; i < RANDOM_POOL_SEED_SIZE; i++)
+    {
+        ui32State ^= ui32State << 13;
+        ui32State ^= ui32State >> 17;
+        ui32State ^= ui32State << 5;
+        random_pool_entropy[i] = (uint8_t)ui32State;
+    }
+    random_pool_entropy_ready = true;
+}
+#else
+static void random_pool_entropy_done(void *pvContext)
+{
+    (void)pvContext;
+
+    am_hal_entropy_disable();
+    random_pool_collecting = false;
+    random_pool_entropy_ready = true;
+}
+
+static void random_pool_collect(void)
+{
+    if (random_pool_collecting || random_pool_entropy_ready)
+    {
+        return;
+    }
+
+    random_pool_collecting = true;
+    am_hal_entropy_enable();
+    if (am_hal_entropy_get_values(random_pool_entropy, RANDOM_POOL_SEED_SIZE,
+                                  random_pool_entropy_done, NULL) != AM_HAL_STATUS_SUCCESS)
+    {
+        am_hal_entropy_disable();
+        random_pool_collecting = false;
+    }
+}
+#endif
+
+/* Must be called with interrupts masked.  Until the first seed is in, a
+ * collection that failed to start is retried on every call. */
+static void random_pool_update(void)
+{
+    if (random_pool_entropy_ready)
+    {
+        random_pool_mix(random_pool_entropy, RANDOM_POOL_SEED_SIZE);
+        memset(random_pool_entropy, 0, sizeof(random_pool_entropy));
+        random_pool_entropy_ready = false;
+        random_pool_is_seeded = true;
+        random_pool_blocks = 0;
+    }
+    else if (!random_pool_is_seeded || (random_pool_blocks >= RANDOM_POOL_RESEED_INTERVAL))
+    {
+        random_pool_collect();
+    }
+}
+
+void random_pool_init(void)
+{
+    memset(random_pool_key, 0, sizeof(random_pool_key));
+    memset(random_pool_buffer, 0, sizeof(random_pool_buffer));
+    random_pool_available = 0;
+    random_pool_blocks = 0;
+    random_pool_is_seeded = false;
+    random_pool_entropy_ready = false;
+    random_pool_collecting = false;
+
+#if !defined(RANDOM_POOL_STUB_ENTROPY)
+    /* Until the first seed is in, outputs at least differ between devices. */
+    am_util_id_t sId;
+
+    am_util_id_device(&sId);
+    random_pool_add((const uint8_t *)&sId.sMcuCtrlDevice, sizeof(sId.sMcuCtrlDevice));
+
+    am_hal_entropy_init();
+#endif
+
+    random_pool_collect();
+}
+
+bool random_pool_seeded(void)
+{
+    bool bSeeded;
+
+    RANDOM_POOL_CRITICAL_BEGIN
+    random_pool_update();
+    bSeeded = random_pool_is_seeded;
+    RANDOM_POOL_CRITICAL_END
+
+    return bSeeded;
+}
+
+void random_pool_add(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    RANDOM_POOL_CRITICAL_BEGIN
+    random_pool_mix(pui8Data, ui32Length);
+    RANDOM_POOL_CRITICAL_END
+}
+
+void random_pool_reseed(void)
+{
+    RANDOM_POOL_CRITICAL_BEGIN
+    random_pool_collect();
+    RANDOM_POOL_CRITICAL_END
+}
+
+/* The collector drops every sample whose 10 ms period spans a sleep, so its
+ * timer is stopped while the core sleeps instead of waking it for nothing.
+ * Both are called from the sleep path with interrupts masked. */
+void random_pool_sleep(void)
+{
+#if !defined(RANDOM_POOL_STUB_ENTROPY)
+    if (random_pool_collecting)
+    {
+        am_hal_entropy_disable();
+    }
+#endif
+}
+
+void random_pool_wakeup(void)
+{
+#if !defined(RANDOM_POOL_STUB_ENTROPY)
+    if (random_pool_collecting)
+    {
+        am_hal_entropy_enable();
+    }
+#endif
+}
+
+void random_pool_get(uint8_t *pui8Output, uint32_t ui32Length)
+{
+    uint8_t *pui8Buffer;
+    uint32_t ui32Count;
+
+    RANDOM_POOL_CRITICAL_BEGIN
+    random_pool_update();
+
+    while (ui32Length)
+    {
+        if (random_pool_available == 0)
+        {
+            random_pool_rekey();
+        }
+
+        ui32Count = (ui32Length < random_pool_available) ? ui32Length : random_pool_available;
+        pui8Buffer = &random_pool_buffer[RANDOM_POOL_KEY_SIZE - random_pool_available];
+        memcpy(pui8Output, pui8Buffer, ui32Count);
+        memset(pui8Buffer, 0, ui32Count);
+
+        random_pool_available -= ui32Count;
+        pui8Output += ui32Count;
+        ui32Length -= ui32Count;
+    }
+    RANDOM_POOL_CRITICAL_END
+}
+
+uint32_t random_pool_get_u32(void)
+{
+    uint32_t ui32Value;
+
+    random_pool_get((uint8_t *)&ui32Value, sizeof(ui32Value));
+
+    return ui32Value;
+}
@@ -0,0 +1,84 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _RANDOM_POOL_H_
+#define _RANDOM_POOL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Random number pool shared by the LoRaWAN stack and the BLE host.
+ *
+ * The pool is a ChaCha20 based generator that erases its key after every
+ * block, so earlier outputs cannot be recovered from the state.  It is seeded
+ * from the entropy collector of the HAL, which compares the LFRC with the HFRC
+ * and yields one byte every 10 ms while the core is awake, and it reseeds in
+ * the background after RANDOM_POOL_RESEED_INTERVAL blocks of output.  Drawing
+ * numbers never touches the radio or the BLE controller.
+ *
+ * random_pool_sleep() and random_pool_wakeup() must bracket every sleep of the
+ * core.  They pause a background collection, which then only progresses while
+ * the core stays awake, rather than waking the core every 10 ms.
+ *
+ * Building with RANDOM_POOL_STUB_ENTROPY replaces the entropy collector with a
+ * deterministic source that completes at once, for host builds and tests. */
+
+/* Entropy bytes collected for each seed, one every 10 ms. */
+#ifndef RANDOM_POOL_SEED_SIZE
+#define RANDOM_POOL_SEED_SIZE       16
+#endif
+
+/* 32 byte blocks of output between background reseeds. */
+#ifndef RANDOM_POOL_RESEED_INTERVAL
+#define RANDOM_POOL_RESEED_INTERVAL 256
+#endif
+
+void random_pool_init(void);
+bool random_pool_seeded(void);
+
+void random_pool_add(const uint8_t *pui8Data, uint32_t ui32Length);
+void random_pool_reseed(void);
+
+void random_pool_sleep(void);
+void random_pool_wakeup(void);
+
+void random_pool_get(uint8_t *pui8Output, uint32_t ui32Length);
+uint32_t random_pool_get_u32(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RANDOM_POOL_H_ */
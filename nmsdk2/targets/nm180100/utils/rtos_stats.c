@@ -0,0 +1,150 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(RTOS_STATS_STUB_CLOCK)
+#define RTOS_STATS_CRITICAL_BEGIN
+#define RTOS_STATS_CRITICAL_END
+#define RTOS_STATS_COUNTER()       rtos_stats_stub_counter()
+#define RTOS_STATS_CYCLES()        rtos_stats_stub_cycles()
+#else
+#include <am_mcu_apollo.h>
+#define RTOS_STATS_CRITICAL_BEGIN AM_CRITICAL_BEGIN
+#define RTOS_STATS_CRITICAL_END   AM_CRITICAL_END
+#define RTOS_STATS_COUNTER()       am_hal_stimer_counter_get()
+#define RTOS_STATS_CYCLES()        (DWT->CYCCNT)
+#endif
+
+#include "rtos_stats.h"
+
+#if defined(RTOS_STATS_ENABLED)
+
+static rtos_stats_t rtos_stats;
+static uint32_t rtos_stats_task_last;
+static uint32_t rtos_stats_sleep_start;
+static uint32_t rtos_stats_isr_start[RTOS_STATS_ISRS];
+
+// Set when TRCENA was enabled here rather than by a debugger.
+static bool rtos_stats_trace_owned;
+
+static void rtos_stats_cycles_enable(void)
+{
+#if !defined(RTOS_STATS_STUB_CLOCK)
+    if (rtos_stats_trace_owned)
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    }
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+void rtos_stats_init(void)
+{
+    memset(&rtos_stats, 0, sizeof(rtos_stats));
+    rtos_stats_task_last = 0;
+
+#if !defined(RTOS_STATS_STUB_CLOCK)
+    rtos_stats_trace_owned = !(CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk);
+#endif
+    rtos_stats_cycles_enable();
+}
+
+uint32_t rtos_stats_counter_get(void)
+{
+    return RTOS_STATS_COUNTER();
+}
+
+/* Called by the kernel with the scheduler locked each time it selects a task,
+ * which may be the task that was already running. */
+void rtos_stats_task_switched_in(uint32_t ui32TaskNumber)
+{
+    if (ui32TaskNumber == rtos_stats_task_last)
+    {
+        return;
+    }
+    rtos_stats_task_last = ui32TaskNumber;
+
+    rtos_stats.ui32Switches++;
+    if (ui32TaskNumber < RTOS_STATS_MAX_TASKS)
+    {
+        rtos_stats.ui32TaskSwitches[ui32TaskNumber]++;
+    }
+}
+
+/* Called by the tickless idle with interrupts disabled around the sleep. */
+void rtos_stats_sleep_enter(void)
+{
+    rtos_stats_sleep_start = RTOS_STATS_COUNTER();
+
+#if !defined(RTOS_STATS_STUB_CLOCK)
+    // The cycle counter does not run in deep sleep, and TRCENA would keep the
+    // debug domain powered.
+    if (rtos_stats_trace_owned)
+    {
+        CoreDebug->DEMCR &= ~CoreDebug_DEMCR_TRCENA_Msk;
+    }
+#endif
+}
+
+void rtos_stats_sleep_exit(void)
+{
+    rtos_stats.ui64SleepTicks += RTOS_STATS_COUNTER() - rtos_stats_sleep_start;
+    rtos_stats.ui32Sleeps++;
+
+    // The cycle counter belongs to the debug unit, enable it again as it was
+    // turned off or reset for deep sleep.
+    rtos_stats_cycles_enable();
+}
+
+/* An interrupt does not preempt another of the same bucket, the handlers
+ * measured share the kernel interrupt priority. */
+void rtos_stats_isr_enter(rtos_stats_isr_e eIsr)
+{
+    rtos_stats_isr_start[eIsr] = RTOS_STATS_CYCLES();
+}
+
+void rtos_stats_isr_exit(rtos_stats_isr_e eIsr)
+{
+    rtos_stats.sIsr[eIsr].ui64Cycles += RTOS_STATS_CYCLES() - rtos_stats_isr_start[eIsr];
+    rtos_stats.sIsr[eIsr].ui32Count++;
+}
+
+void rtos_stats_get(rtos_stats_t *psStats)
+{
+    RTOS_STATS_CRITICAL_BEGIN
+    memcpy(psStats, &rtos_stats, sizeof(rtos_stats));
+    RTOS_STATS_CRITICAL_END
+}
+
+#endif /* RTOS_STATS_ENABLED */
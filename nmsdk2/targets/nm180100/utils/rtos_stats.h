@@ -0,0 +1,124 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _RTOS_STATS_H_
+#define _RTOS_STATS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Run-time statistics of the RTOS.
+ *
+ * The FreeRTOS run-time counter is the 32768 Hz STIMER.  It keeps counting in
+ * deep sleep, so the idle task is charged for the time asleep and the task
+ * percentages add up over any interval.  Interrupt handlers only run while the
+ * core is awake and take a few microseconds, so they are timed with the DWT
+ * cycle counter instead.  Context switches are counted per task number and
+ * the tickless idle adds the STIMER ticks spent in deep sleep.
+ *
+ * The statistics are only gathered when building with RTOS_STATS_ENABLED,
+ * which also turns on the FreeRTOS trace facility and run-time counters.
+ * Otherwise the hooks compile to nothing.  The cycle counter needs TRCENA,
+ * which keeps the debug domain powered, so TRCENA is cleared for deep sleep
+ * unless a debugger had set it.
+ *
+ * Building with RTOS_STATS_STUB_CLOCK replaces the STIMER and DWT reads with
+ * the rtos_stats_stub_counter() and rtos_stats_stub_cycles() functions of the
+ * host build. */
+
+/* Frequency of the run-time counter. */
+#define RTOS_STATS_COUNTER_HZ 32768
+
+/* Context switches are counted for the tasks numbered below this, the
+ * FreeRTOS task numbers start at 1 in order of creation. */
+#ifndef RTOS_STATS_MAX_TASKS
+#define RTOS_STATS_MAX_TASKS  16
+#endif
+
+typedef enum
+{
+    RTOS_STATS_ISR_STIMER,
+    RTOS_STATS_ISR_GPIO,
+    RTOS_STATS_ISR_CTIMER,
+    RTOS_STATS_ISR_UART,
+    RTOS_STATS_ISR_BLE,
+    RTOS_STATS_ISRS
+} rtos_stats_isr_e;
+
+typedef struct
+{
+    uint32_t ui32Count;
+    uint64_t ui64Cycles;
+} rtos_stats_isr_t;
+
+typedef struct
+{
+    uint32_t ui32Switches;
+    uint32_t ui32TaskSwitches[RTOS_STATS_MAX_TASKS];
+    uint32_t ui32Sleeps;
+    uint64_t ui64SleepTicks;
+    rtos_stats_isr_t sIsr[RTOS_STATS_ISRS];
+} rtos_stats_t;
+
+#if defined(RTOS_STATS_ENABLED)
+void rtos_stats_init(void);
+uint32_t rtos_stats_counter_get(void);
+
+void rtos_stats_task_switched_in(uint32_t ui32TaskNumber);
+
+void rtos_stats_sleep_enter(void);
+void rtos_stats_sleep_exit(void);
+
+void rtos_stats_isr_enter(rtos_stats_isr_e eIsr);
+void rtos_stats_isr_exit(rtos_stats_isr_e eIsr);
+
+void rtos_stats_get(rtos_stats_t *psStats);
+#else
+static inline void rtos_stats_sleep_enter(void) {}
+static inline void rtos_stats_sleep_exit(void) {}
+
+static inline void rtos_stats_isr_enter(rtos_stats_isr_e eIsr) { (void)eIsr; }
+static inline void rtos_stats_isr_exit(rtos_stats_isr_e eIsr) { (void)eIsr; }
+#endif
+
+#ifdef RTOS_STATS_STUB_CLOCK
+uint32_t rtos_stats_stub_counter(void);
+uint32_t rtos_stats_stub_cycles(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTOS_STATS_H_ */
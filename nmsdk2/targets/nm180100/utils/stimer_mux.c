@@ -0,0 +1,227 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2021, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+
+#include "rtos_stats.h"
+#include "stimer_mux.h"
+
+#define STIMER_MUX_INT (AM_HAL_STIMER_INT_COMPAREA | AM_HAL_STIMER_INT_COMPAREB)
+
+typedef struct
+{
+    stimer_mux_handler_t pfnHandler;
+    uint32_t ui32Deadline;
+    uint32_t ui32Tolerance;
+    bool bArmed;
+} stimer_mux_entry_t;
+
+static stimer_mux_entry_t stimer_mux_entries[STIMER_MUX_CLIENTS];
+static stimer_mux_stats_t stimer_mux_stats;
+static bool stimer_mux_initialized;
+
+/* Set while the interrupt serves the clients, which program the compare once
+ * at the end rather than on every deadline set by a handler. */
+static bool stimer_mux_dispatching;
+
+static void stimer_mux_program(void)
+{
+    uint32_t ui32Now = am_hal_stimer_counter_get();
+    uint32_t ui32Delta = UINT32_MAX;
+    bool bArmed = false;
+
+    for (uint32_t i = 0; i < STIMER_MUX_CLIENTS; i++)
+    {
+        stimer_mux_entry_t *psEntry = &stimer_mux_entries[i];
+        int32_t i32Left;
+
+        if (!psEntry->bArmed)
+        {
+            continue;
+        }
+
+        i32Left = (int32_t)(psEntry->ui32Deadline + psEntry->ui32Tolerance - ui32Now);
+        if (i32Left < STIMER_MUX_MIN_DELTA)
+        {
+            i32Left = STIMER_MUX_MIN_DELTA;
+        }
+
+        if ((uint32_t)i32Left < ui32Delta)
+        {
+            ui32Delta = (uint32_t)i32Left;
+        }
+        bArmed = true;
+    }
+
+    am_hal_stimer_int_clear(STIMER_MUX_INT);
+
+    if (!bArmed)
+    {
+        am_hal_stimer_int_disable(STIMER_MUX_INT);
+        return;
+    }
+
+    am_hal_stimer_compare_delta_set(0, ui32Delta);
+    am_hal_stimer_compare_delta_set(1, ui32Delta + 1);
+    am_hal_stimer_int_enable(STIMER_MUX_INT);
+}
+
+static void stimer_mux_dispatch(void)
+{
+    uint32_t ui32Now;
+    uint32_t ui32Served = 0;
+
+    rtos_stats_isr_enter(RTOS_STATS_ISR_STIMER);
+
+    am_hal_stimer_int_clear(STIMER_MUX_INT);
+    stimer_mux_stats.ui32Wakeups++;
+
+    stimer_mux_dispatching = true;
+
+    ui32Now = am_hal_stimer_counter_get();
+    for (uint32_t i = 0; i < STIMER_MUX_CLIENTS; i++)
+    {
+        stimer_mux_entry_t *psEntry = &stimer_mux_entries[i];
+        bool bDue;
+
+        AM_CRITICAL_BEGIN
+        bDue = psEntry->bArmed && ((int32_t)(ui32Now - psEntry->ui32Deadline) >= 0);
+        if (bDue)
+        {
+            psEntry->bArmed = false;
+        }
+        AM_CRITICAL_END
+
+        if (bDue)
+        {
+            stimer_mux_stats.ui32Served[i]++;
+            if (ui32Served++ > 0)
+            {
+                stimer_mux_stats.ui32Saved++;
+            }
+            psEntry->pfnHandler();
+        }
+    }
+
+    AM_CRITICAL_BEGIN
+    stimer_mux_dispatching = false;
+    stimer_mux_program();
+    AM_CRITICAL_END
+
+    rtos_stats_isr_exit(RTOS_STATS_ISR_STIMER);
+}
+
+void am_stimer_cmpr0_isr(void) { stimer_mux_dispatch(); }
+
+void am_stimer_cmpr1_isr(void) { stimer_mux_dispatch(); }
+
+void stimer_mux_init(void)
+{
+    uint32_t ui32Config;
+
+    AM_CRITICAL_BEGIN
+    if (!stimer_mux_initialized)
+    {
+        am_hal_stimer_int_disable(STIMER_MUX_INT);
+        am_hal_stimer_int_clear(STIMER_MUX_INT);
+
+        NVIC_SetPriority(STIMER_CMPR0_IRQn, STIMER_MUX_IRQ_PRIORITY);
+        NVIC_SetPriority(STIMER_CMPR1_IRQn, STIMER_MUX_IRQ_PRIORITY);
+        NVIC_EnableIRQ(STIMER_CMPR0_IRQn);
+        NVIC_EnableIRQ(STIMER_CMPR1_IRQn);
+
+        ui32Config = am_hal_stimer_config(AM_HAL_STIMER_CFG_FREEZE);
+        am_hal_stimer_config((ui32Config & ~(AM_HAL_STIMER_CFG_FREEZE | CTIMER_STCFG_CLKSEL_Msk)) |
+                             STIMER_MUX_CLOCK_SOURCE | AM_HAL_STIMER_CFG_COMPARE_A_ENABLE |
+                             AM_HAL_STIMER_CFG_COMPARE_B_ENABLE);
+
+        stimer_mux_initialized = true;
+    }
+    AM_CRITICAL_END
+}
+
+void stimer_mux_register(stimer_mux_client_e eClient, stimer_mux_handler_t pfnHandler,
+                         uint32_t ui32Tolerance)
+{
+    AM_CRITICAL_BEGIN
+    stimer_mux_entries[eClient].pfnHandler = pfnHandler;
+    stimer_mux_entries[eClient].ui32Tolerance = ui32Tolerance;
+    stimer_mux_entries[eClient].bArmed = false;
+    AM_CRITICAL_END
+}
+
+void stimer_mux_tolerance_set(stimer_mux_client_e eClient, uint32_t ui32Tolerance)
+{
+    AM_CRITICAL_BEGIN
+    stimer_mux_entries[eClient].ui32Tolerance = ui32Tolerance;
+    if (!stimer_mux_dispatching)
+    {
+        stimer_mux_program();
+    }
+    AM_CRITICAL_END
+}
+
+void stimer_mux_set(stimer_mux_client_e eClient, uint32_t ui32Deadline)
+{
+    AM_CRITICAL_BEGIN
+    stimer_mux_entries[eClient].ui32Deadline = ui32Deadline;
+    stimer_mux_entries[eClient].bArmed = true;
+    if (!stimer_mux_dispatching)
+    {
+        stimer_mux_program();
+    }
+    AM_CRITICAL_END
+}
+
+void stimer_mux_clear(stimer_mux_client_e eClient)
+{
+    AM_CRITICAL_BEGIN
+    if (stimer_mux_entries[eClient].bArmed)
+    {
+        stimer_mux_entries[eClient].bArmed = false;
+        if (!stimer_mux_dispatching)
+        {
+            stimer_mux_program();
+        }
+    }
+    AM_CRITICAL_END
+}
+
+void stimer_mux_stats_get(stimer_mux_stats_t *psStats)
+{
+    AM_CRITICAL_BEGIN
+    memcpy(psStats, &stimer_mux_stats, sizeof(stimer_mux_stats));
+    AM_CRITICAL_END
+}
@@ -0,0 +1,114 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2022, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _STIMER_MUX_H_
+#define _STIMER_MUX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Deadline multiplexer for the system timer.
+ *
+ * The FreeRTOS tick, the LoRaMac RTC and the WSF timers each hand their next
+ * deadline, in absolute STIMER ticks, to the multiplexer, which programs the
+ * earliest of them on STIMER compare A, with compare B one tick later as the
+ * backup against a missed compare.  A client may be served up to its
+ * tolerance after its deadline, so the compare is set to the earliest
+ * deadline plus tolerance and every client that is due by then is served by
+ * the same wake-up.  Handlers run in the compare interrupt at the kernel
+ * interrupt priority and may set a new deadline. */
+
+typedef enum
+{
+    STIMER_MUX_RTOS,
+    STIMER_MUX_LORAWAN,
+    STIMER_MUX_BLE,
+    STIMER_MUX_CLIENTS
+} stimer_mux_client_e;
+
+typedef void (*stimer_mux_handler_t)(void);
+
+typedef struct
+{
+    uint32_t ui32Wakeups;
+    uint32_t ui32Served[STIMER_MUX_CLIENTS];
+    uint32_t ui32Saved; /* clients served by the wake-up of another one */
+} stimer_mux_stats_t;
+
+/* Tolerances in STIMER ticks.  The RTOS tick and the LoRaWAN receive windows
+ * are served on time, the WSF timers count in 10 ms ticks and accept being
+ * served one tick late. */
+#ifndef STIMER_MUX_TOLERANCE_RTOS
+#define STIMER_MUX_TOLERANCE_RTOS    0
+#endif
+
+#ifndef STIMER_MUX_TOLERANCE_LORAWAN
+#define STIMER_MUX_TOLERANCE_LORAWAN 0
+#endif
+
+#ifndef STIMER_MUX_TOLERANCE_BLE
+#define STIMER_MUX_TOLERANCE_BLE     327
+#endif
+
+#ifndef STIMER_MUX_CLOCK_SOURCE
+#define STIMER_MUX_CLOCK_SOURCE      AM_HAL_STIMER_XTAL_32KHZ
+#endif
+
+/* Same as NVIC_configKERNEL_INTERRUPT_PRIORITY, so handlers may use the
+ * FromISR API. */
+#ifndef STIMER_MUX_IRQ_PRIORITY
+#define STIMER_MUX_IRQ_PRIORITY      7
+#endif
+
+/* Shortest compare delta, the wake-up from deep sleep takes about one tick. */
+#ifndef STIMER_MUX_MIN_DELTA
+#define STIMER_MUX_MIN_DELTA         3
+#endif
+
+void stimer_mux_init(void);
+void stimer_mux_register(stimer_mux_client_e eClient, stimer_mux_handler_t pfnHandler,
+                         uint32_t ui32Tolerance);
+void stimer_mux_tolerance_set(stimer_mux_client_e eClient, uint32_t ui32Tolerance);
+
+void stimer_mux_set(stimer_mux_client_e eClient, uint32_t ui32Deadline);
+void stimer_mux_clear(stimer_mux_client_e eClient);
+
+void stimer_mux_stats_get(stimer_mux_stats_t *psStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _STIMER_MUX_H_ */
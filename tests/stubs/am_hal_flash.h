@@ -0,0 +1,62 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _AM_HAL_FLASH_H_
+#define _AM_HAL_FLASH_H_
+
+#include <setjmp.h>
+#include <stdint.h>
+
+/* Host stand-in for the Apollo3 flash HAL.  The flash is a RAM mapping at
+ * FLASH_STUB_BASE, so that the 32 bit addresses used by the code under test
+ * are valid pointers. */
+#define FLASH_STUB_BASE                 0x10000000u
+#define FLASH_STUB_PAGES                8
+
+#define AM_HAL_FLASH_PAGE_SIZE          (8 * 1024)
+#define AM_HAL_FLASH_PROGRAM_KEY        0x12344321
+#define AM_HAL_FLASH_LARGEST_VALID_ADDR (FLASH_STUB_BASE + FLASH_STUB_PAGES * AM_HAL_FLASH_PAGE_SIZE - 1)
+#define AM_HAL_FLASH_ADDR2INST(addr)    0
+#define AM_HAL_FLASH_ADDR2PAGE(addr)    (((addr) - FLASH_STUB_BASE) / AM_HAL_FLASH_PAGE_SIZE)
+
+int am_hal_flash_program_main(uint32_t ui32Value, uint32_t *pui32Src, uint32_t *pui32Dst,
+                              uint32_t ui32NumWords);
+int am_hal_flash_page_erase(uint32_t ui32ProgramKey, uint32_t ui32FlashInst, uint32_t ui32PageNum);
+
+/* Maps the flash and erases it. */
+void flash_stub_setup(void);
+
+/* Programmed words and erased pages before a simulated power cut, which
+ * longjmp()s to flash_stub_power_cut.  -1 never cuts. */
+extern long flash_stub_fail_after;
+extern jmp_buf flash_stub_power_cut;
+
+#endif /* _AM_HAL_FLASH_H_ */
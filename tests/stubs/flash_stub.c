@@ -0,0 +1,103 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "am_hal_flash.h"
+
+long flash_stub_fail_after = -1;
+jmp_buf flash_stub_power_cut;
+
+static void flash_stub_tick(void)
+{
+    if (flash_stub_fail_after == 0)
+    {
+        flash_stub_fail_after = -1;
+        longjmp(flash_stub_power_cut, 1);
+    }
+    if (flash_stub_fail_after > 0)
+    {
+        flash_stub_fail_after--;
+    }
+}
+
+void flash_stub_setup(void)
+{
+    static void *pvFlash;
+    size_t size = FLASH_STUB_PAGES * AM_HAL_FLASH_PAGE_SIZE;
+
+    if (pvFlash == NULL)
+    {
+        pvFlash = mmap((void *)(uintptr_t)FLASH_STUB_BASE, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        if (pvFlash == MAP_FAILED)
+        {
+            abort();
+        }
+    }
+    memset(pvFlash, 0xFF, size);
+    flash_stub_fail_after = -1;
+}
+
+int am_hal_flash_program_main(uint32_t ui32Value, uint32_t *pui32Src, uint32_t *pui32Dst,
+                              uint32_t ui32NumWords)
+{
+    (void)ui32Value;
+
+    // Programming only clears bits, like NOR flash.
+    for (uint32_t i = 0; i < ui32NumWords; i++)
+    {
+        flash_stub_tick();
+        pui32Dst[i] &= pui32Src[i];
+    }
+
+    return 0;
+}
+
+int am_hal_flash_page_erase(uint32_t ui32ProgramKey, uint32_t ui32FlashInst, uint32_t ui32PageNum)
+{
+    (void)ui32ProgramKey;
+    (void)ui32FlashInst;
+
+    flash_stub_tick();
+    if (ui32PageNum >= FLASH_STUB_PAGES)
+    {
+        abort();
+    }
+    memset((void *)(uintptr_t)(FLASH_STUB_BASE + ui32PageNum * AM_HAL_FLASH_PAGE_SIZE), 0xFF,
+           AM_HAL_FLASH_PAGE_SIZE);
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crc32_table.h"
+#include "wsf_types.h"
+#include "util/crc32.h"
+
+#include "test.h"
+
+// Built once per CRC32_METHOD and once per WSF CalcCrc32() implementation.
+
+static uint32_t crc32(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    return crc32_update(0xFFFFFFFF, pui8Data, ui32Length) ^ 0xFFFFFFFF;
+}
+
+static uint32_t crc32_bitwise(const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    uint32_t ui32Crc = 0xFFFFFFFF;
+
+    while (ui32Length--)
+    {
+        ui32Crc ^= *pui8Data++;
+        for (int i = 0; i < 8; i++)
+        {
+            ui32Crc = (ui32Crc >> 1) ^ ((ui32Crc & 1) ? 0xEDB88320 : 0);
+        }
+    }
+
+    return ui32Crc ^ 0xFFFFFFFF;
+}
+
+int main(void)
+{
+    static const struct
+    {
+        const char *pcData;
+        uint32_t ui32Crc;
+    } kat[] = {
+        {"", 0x00000000},
+        {"a", 0xE8B7BE43},
+        {"abc", 0x352441C2},
+        {"123456789", 0xCBF43926},
+        {"message digest", 0x20159D7F},
+        {"The quick brown fox jumps over the lazy dog", 0x414FA339},
+    };
+    uint8_t aui8Data[1031];
+
+    for (uint32_t i = 0; i < sizeof(kat) / sizeof(kat[0]); i++)
+    {
+        const uint8_t *pui8Data = (const uint8_t *)kat[i].pcData;
+        uint32_t ui32Length = strlen(kat[i].pcData);
+
+        CHECK(crc32(pui8Data, ui32Length) == kat[i].ui32Crc);
+        CHECK(CalcCrc32(0xFFFFFFFF, ui32Length, pui8Data) == kat[i].ui32Crc);
+    }
+
+    // Every length and alignment the sliced loops special-case, and updates
+    // split at every point.
+    srand(1);
+    for (uint32_t i = 0; i < sizeof(aui8Data); i++)
+    {
+        aui8Data[i] = rand();
+    }
+
+    for (uint32_t ui32Offset = 0; ui32Offset < 8; ui32Offset++)
+    {
+        for (uint32_t ui32Length = 0; ui32Length + ui32Offset <= sizeof(aui8Data); ui32Length += 7)
+        {
+            CHECK(crc32(&aui8Data[ui32Offset], ui32Length) ==
+                  crc32_bitwise(&aui8Data[ui32Offset], ui32Length));
+        }
+    }
+
+    for (uint32_t ui32Split = 0; ui32Split <= 64; ui32Split++)
+    {
+        uint32_t ui32Crc = crc32_update(0xFFFFFFFF, aui8Data, ui32Split);
+
+        ui32Crc = crc32_update(ui32Crc, &aui8Data[ui32Split], 64 - ui32Split);
+        CHECK((ui32Crc ^ 0xFFFFFFFF) == crc32_bitwise(aui8Data, 64));
+    }
+
+    // WsfNvm seeds the CRC with its own initial value.
+    CHECK(CalcCrc32(0xFEDCBA98, sizeof(aui8Data), aui8Data) ==
+          (crc32_update(0xFEDCBA98, aui8Data, sizeof(aui8Data)) ^ 0xFFFFFFFF));
+
+    return TEST_RESULT();
+}
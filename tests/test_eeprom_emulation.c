@@ -0,0 +1,258 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "am_hal_flash.h"
+#include "eeprom_emulation.h"
+
+#include "test.h"
+
+#define PAGES          2
+#define ADDRESSES      1600
+#define INDEX_SIZE     2048
+#define MAX_ARRAY      64
+
+// Reference model: the value of every virtual address, before and after the
+// operation in progress.
+static uint16_t model[ADDRESSES + 1];
+static bool model_set[ADDRESSES + 1];
+static uint16_t previous[ADDRESSES + 1];
+static bool previous_set[ADDRESSES + 1];
+
+static eeprom_page_t pages[PAGES];
+static uint16_t eeprom_index[INDEX_SIZE];
+
+static void open_handle(eeprom_handle_t *pHandle, bool bIndex, uint16_t ui16Threshold)
+{
+    memset(pHandle, 0, sizeof(*pHandle));
+    pHandle->pages = pages;
+    if (bIndex)
+    {
+        pHandle->index = eeprom_index;
+        pHandle->index_size = INDEX_SIZE;
+    }
+    pHandle->compaction_threshold = ui16Threshold;
+
+    if (!eeprom_init(FLASH_STUB_BASE, PAGES, pHandle))
+    {
+        eeprom_format(pHandle);
+    }
+}
+
+static bool matches_model(eeprom_handle_t *pHandle, uint32_t ui32Address)
+{
+    uint16_t ui16Value;
+    uint32_t ui32Found = eeprom_read(pHandle, ui32Address, &ui16Value);
+
+    return (ui32Found == model_set[ui32Address]) &&
+           (!ui32Found || (ui16Value == model[ui32Address]));
+}
+
+// Random writes, array writes, deletes and re-initialisations against the
+// reference model.
+static void randomized(bool bIndex, uint16_t ui16Threshold)
+{
+    eeprom_handle_t sHandle;
+    uint8_t aui8Buffer[MAX_ARRAY];
+
+    flash_stub_setup();
+    memset(model_set, 0, sizeof(model_set));
+    open_handle(&sHandle, bIndex, ui16Threshold);
+
+    srand(1);
+    for (int iteration = 0; iteration < 6000 && !test_failures; iteration++)
+    {
+        uint32_t ui32Address = 1 + rand() % (ADDRESSES - MAX_ARRAY);
+        uint32_t ui32Length = 1 + rand() % MAX_ARRAY;
+        int operation = rand() % 20;
+
+        if (operation < 12)
+        {
+            for (uint32_t i = 0; i < ui32Length; i++)
+            {
+                aui8Buffer[i] = rand() % 4;
+                model[ui32Address + i] = aui8Buffer[i];
+                model_set[ui32Address + i] = true;
+            }
+            CHECK(eeprom_write_array_len(&sHandle, ui32Address, aui8Buffer, ui32Length));
+        }
+        else if (operation < 16)
+        {
+            model[ui32Address] = 0x100 + rand() % 0xE000;
+            model_set[ui32Address] = true;
+            CHECK(eeprom_write(&sHandle, ui32Address, model[ui32Address]));
+        }
+        else if (operation < 19)
+        {
+            model_set[ui32Address] = false;
+            eeprom_delete(&sHandle, ui32Address);
+        }
+        else
+        {
+            open_handle(&sHandle, bIndex, ui16Threshold);
+        }
+
+        if (ui16Threshold && eeprom_compact_pending(&sHandle))
+        {
+            eeprom_compact_step(&sHandle, 64);
+        }
+
+        for (int i = 0; i < 20; i++)
+        {
+            CHECK(matches_model(&sHandle, 1 + rand() % ADDRESSES));
+        }
+    }
+
+    // A long array is split over several records and read back in one go.
+    uint8_t aui8Image[ADDRESSES - 1];
+    uint8_t aui8Read[ADDRESSES - 1];
+
+    for (uint32_t i = 0; i < sizeof(aui8Image); i++)
+    {
+        aui8Image[i] = rand();
+    }
+    CHECK(eeprom_write_array_len(&sHandle, 1, aui8Image, sizeof(aui8Image)));
+    open_handle(&sHandle, bIndex, ui16Threshold);
+    CHECK(eeprom_read_array_len(&sHandle, 1, aui8Read, sizeof(aui8Read)));
+    CHECK(memcmp(aui8Image, aui8Read, sizeof(aui8Image)) == 0);
+}
+
+// Power cuts at random points of random operations.  After a cut, every
+// address holds either its value before or its value after the operation.
+static void power_cuts(bool bIndex, uint16_t ui16Threshold)
+{
+    eeprom_handle_t sHandle;
+    uint8_t aui8Buffer[MAX_ARRAY];
+    int cuts = 0;
+
+    flash_stub_setup();
+    memset(model_set, 0, sizeof(model_set));
+    open_handle(&sHandle, bIndex, ui16Threshold);
+
+    srand(42);
+    for (int iteration = 0; iteration < 6000 && !test_failures; iteration++)
+    {
+        uint32_t ui32Address = 1 + rand() % (ADDRESSES - MAX_ARRAY);
+        uint32_t ui32Length = 1 + rand() % MAX_ARRAY;
+        int operation = rand() % 20;
+        uint16_t ui16Value = 0x100 + rand() % 0xE000;
+
+        for (uint32_t i = 0; i < ui32Length; i++)
+        {
+            aui8Buffer[i] = rand() % 5;
+        }
+
+        memcpy(previous, model, sizeof(model));
+        memcpy(previous_set, model_set, sizeof(model_set));
+        if (rand() % 50 == 0)
+        {
+            flash_stub_fail_after = rand() % 300;
+        }
+
+        if (setjmp(flash_stub_power_cut) == 0)
+        {
+            if (operation == 0)
+            {
+                model_set[ui32Address] = false;
+                eeprom_delete(&sHandle, ui32Address);
+            }
+            else if (operation == 1)
+            {
+                model[ui32Address] = ui16Value;
+                model_set[ui32Address] = true;
+                eeprom_write(&sHandle, ui32Address, ui16Value);
+            }
+            else
+            {
+                for (uint32_t i = 0; i < ui32Length; i++)
+                {
+                    model[ui32Address + i] = aui8Buffer[i];
+                    model_set[ui32Address + i] = true;
+                }
+                eeprom_write_array_len(&sHandle, ui32Address, aui8Buffer, ui32Length);
+            }
+
+            if (ui16Threshold && eeprom_compact_pending(&sHandle))
+            {
+                eeprom_compact_step(&sHandle, 64);
+            }
+            flash_stub_fail_after = -1;
+        }
+        else
+        {
+            cuts++;
+            memset(&sHandle, 0, sizeof(sHandle));
+            sHandle.pages = pages;
+            sHandle.index = bIndex ? eeprom_index : NULL;
+            sHandle.index_size = bIndex ? INDEX_SIZE : 0;
+            sHandle.compaction_threshold = ui16Threshold;
+            CHECK(eeprom_init(FLASH_STUB_BASE, PAGES, &sHandle));
+
+            for (uint32_t x = 1; x <= ADDRESSES; x++)
+            {
+                uint16_t ui16Read;
+                bool bFound = eeprom_read(&sHandle, x, &ui16Read);
+                bool bNew = (bFound == model_set[x]) && (!bFound || (ui16Read == model[x]));
+                bool bOld = (bFound == previous_set[x]) && (!bFound || (ui16Read == previous[x]));
+
+                CHECK(bNew || bOld);
+                model[x] = ui16Read;
+                model_set[x] = bFound;
+            }
+            continue;
+        }
+
+        for (int i = 0; i < 10; i++)
+        {
+            CHECK(matches_model(&sHandle, 1 + rand() % ADDRESSES));
+        }
+    }
+
+    CHECK(cuts > 0);
+}
+
+int main(void)
+{
+    for (int mode = 0; mode < 4; mode++)
+    {
+        bool bIndex = mode & 1;
+        uint16_t ui16Threshold = (mode & 2) ? 600 : 0;
+
+        randomized(bIndex, ui16Threshold);
+        power_cuts(bIndex, ui16Threshold);
+    }
+
+    return TEST_RESULT();
+}
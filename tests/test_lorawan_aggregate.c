@@ -0,0 +1,140 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lorawan_aggregate.h"
+
+#include "test.h"
+
+#define FRAME_SIZE 242
+
+int main(void)
+{
+    uint8_t aui8Frame[FRAME_SIZE];
+    uint8_t aui8Messages[32][FRAME_SIZE];
+    uint32_t aui32Lengths[32];
+    lorawan_aggregate_reader_t sReader;
+    const uint8_t *pui8Message;
+    uint32_t ui32Offset;
+    uint32_t ui32Count;
+    int32_t i32Length;
+
+    // Random batches of messages survive a round trip through a container.
+    srand(1);
+    for (int iteration = 0; iteration < 10000; iteration++)
+    {
+        ui32Offset = 0;
+        ui32Count = 0;
+        while (ui32Count < 32)
+        {
+            uint32_t ui32Length = rand() % 40;
+
+            for (uint32_t i = 0; i < ui32Length; i++)
+            {
+                aui8Messages[ui32Count][i] = rand();
+            }
+
+            uint32_t ui32Next = lorawan_aggregate_append(aui8Frame, ui32Offset, sizeof(aui8Frame),
+                                                         aui8Messages[ui32Count], ui32Length);
+            if (ui32Next == 0)
+            {
+                // Rejected only when the message and its header do not fit.
+                CHECK(ui32Offset + LORAWAN_AGGREGATE_HEADER_SIZE + ui32Length > sizeof(aui8Frame));
+                break;
+            }
+            CHECK(ui32Next == ui32Offset + LORAWAN_AGGREGATE_HEADER_SIZE + ui32Length);
+            aui32Lengths[ui32Count++] = ui32Length;
+            ui32Offset = ui32Next;
+        }
+
+        lorawan_aggregate_reader_init(&sReader, aui8Frame, ui32Offset);
+        for (uint32_t i = 0; i < ui32Count; i++)
+        {
+            i32Length = lorawan_aggregate_next(&sReader, &pui8Message);
+            CHECK(i32Length == (int32_t)aui32Lengths[i]);
+            if (i32Length == (int32_t)aui32Lengths[i])
+            {
+                CHECK(memcmp(pui8Message, aui8Messages[i], i32Length) == 0);
+            }
+        }
+        CHECK(lorawan_aggregate_next(&sReader, &pui8Message) == -1);
+
+        if (test_failures)
+        {
+            break;
+        }
+    }
+
+    // A buffer becomes the first message of its own container.
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        aui8Frame[i] = i;
+    }
+    CHECK(lorawan_aggregate_append(aui8Frame, 0, sizeof(aui8Frame), aui8Frame, 10) == 11);
+    CHECK(aui8Frame[0] == 10);
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        CHECK(aui8Frame[1 + i] == i);
+    }
+
+    // Limits of the one byte length.
+    CHECK(lorawan_aggregate_append(aui8Frame, 0, sizeof(aui8Frame), aui8Messages[0],
+                                   sizeof(aui8Frame)) == 0);
+    CHECK(lorawan_aggregate_append(aui8Frame, 0, sizeof(aui8Frame), aui8Messages[0],
+                                   sizeof(aui8Frame) - 1) == sizeof(aui8Frame));
+    CHECK(lorawan_aggregate_append(aui8Frame, sizeof(aui8Frame), sizeof(aui8Frame),
+                                   aui8Messages[0], 0) == 0);
+    CHECK(lorawan_aggregate_append(aui8Frame, sizeof(aui8Frame) + 1, sizeof(aui8Frame),
+                                   aui8Messages[0], 0) == 0);
+
+    // Longer messages do not fit the length byte.
+    static uint8_t aui8Large[LORAWAN_AGGREGATE_MAX_MESSAGE + 2];
+    CHECK(lorawan_aggregate_append(aui8Large, 0, sizeof(aui8Large), aui8Large,
+                                   LORAWAN_AGGREGATE_MAX_MESSAGE + 1) == 0);
+    CHECK(lorawan_aggregate_append(aui8Large, 0, sizeof(aui8Large), aui8Large,
+                                   LORAWAN_AGGREGATE_MAX_MESSAGE) == sizeof(aui8Large) - 1);
+
+    // Empty and truncated containers.
+    lorawan_aggregate_reader_init(&sReader, aui8Frame, 0);
+    CHECK(lorawan_aggregate_next(&sReader, &pui8Message) == -1);
+
+    aui8Frame[0] = 3;
+    aui8Frame[4] = 5;
+    lorawan_aggregate_reader_init(&sReader, aui8Frame, 8);
+    CHECK(lorawan_aggregate_next(&sReader, &pui8Message) == 3);
+    CHECK(pui8Message == &aui8Frame[1]);
+    CHECK(lorawan_aggregate_next(&sReader, &pui8Message) == -2);
+
+    return TEST_RESULT();
+}
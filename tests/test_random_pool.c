@@ -0,0 +1,125 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <string.h>
+
+// Built with RANDOM_POOL_STUB_ENTROPY.  The source is included to reach the
+// generator state.
+#include "random_pool.c"
+
+#include "test.h"
+
+// RFC 8439 appendix A.1, test vector #1: ChaCha20 block with an all zero key,
+// nonce and counter.
+static const uint8_t chacha20_kat[64] = {
+    0x76, 0xB8, 0xE0, 0xAD, 0xA0, 0xF1, 0x3D, 0x90, 0x40, 0x5D, 0x6A, 0xE5, 0x53, 0x86, 0xBD, 0x28,
+    0xBD, 0xD2, 0x19, 0xB8, 0xA0, 0x8D, 0xED, 0x1A, 0xA8, 0x36, 0xEF, 0xCC, 0x8B, 0x77, 0x0D, 0xC7,
+    0xDA, 0x41, 0x59, 0x7C, 0x51, 0x57, 0x48, 0x8D, 0x77, 0x24, 0xE0, 0x3F, 0xB8, 0xD8, 0x4A, 0x37,
+    0x6A, 0x43, 0xB8, 0xF4, 0x15, 0x18, 0xA1, 0x1C, 0xC3, 0x87, 0xB6, 0x69, 0xB2, 0xEE, 0x65, 0x86,
+};
+
+static const uint8_t zero[RANDOM_POOL_KEY_SIZE];
+
+// Puts the pool in the seeded state with an all zero key.
+static void zero_key(void)
+{
+    random_pool_init();
+    CHECK(random_pool_seeded());
+    memset(random_pool_key, 0, sizeof(random_pool_key));
+    memset(random_pool_buffer, 0, sizeof(random_pool_buffer));
+    random_pool_available = 0;
+    random_pool_blocks = 0;
+}
+
+int main(void)
+{
+    uint32_t aui32Block[RANDOM_POOL_BLOCK_WORDS];
+    uint8_t aui8First[64];
+    uint8_t aui8Second[64];
+
+    memset(random_pool_key, 0, sizeof(random_pool_key));
+    random_pool_block(aui32Block);
+    CHECK(memcmp(aui32Block, chacha20_kat, sizeof(chacha20_kat)) == 0);
+
+    // The first half of the block becomes the next key, the second half is
+    // the output.
+    zero_key();
+    random_pool_get(aui8First, 32);
+    CHECK(memcmp(aui8First, &chacha20_kat[32], 32) == 0);
+    CHECK(memcmp(random_pool_key, chacha20_kat, sizeof(random_pool_key)) == 0);
+
+    // Output is erased from the buffer as it is handed out, whatever the
+    // split of the draws.
+    zero_key();
+    random_pool_get(aui8First, 5);
+    random_pool_get(&aui8First[5], 11);
+    CHECK(memcmp(random_pool_buffer, zero, 16) == 0);
+    random_pool_get(&aui8First[16], 48);
+    CHECK(memcmp(aui8First, &chacha20_kat[32], 32) == 0);
+    CHECK(memcmp(random_pool_buffer, zero, 16) == 0);
+
+    zero_key();
+    random_pool_get(aui8Second, 64);
+    CHECK(memcmp(aui8First, aui8Second, 64) == 0);
+
+    // Added data changes every later output and drops what was buffered.
+    zero_key();
+    random_pool_get(aui8First, 8);
+    random_pool_add((const uint8_t *)"nm180100", 8);
+    CHECK(random_pool_available == 0);
+    random_pool_get(aui8Second, 24);
+    CHECK(memcmp(aui8Second, &chacha20_kat[40], 24) != 0);
+
+    // Each seed from the entropy source gives a different stream.
+    random_pool_init();
+    CHECK(random_pool_seeded());
+    random_pool_get(aui8First, 64);
+    random_pool_init();
+    random_pool_get(aui8Second, 64);
+    CHECK(memcmp(aui8First, aui8Second, 64) != 0);
+
+    // A reseed is collected once RANDOM_POOL_RESEED_INTERVAL blocks were drawn.
+    random_pool_init();
+    CHECK(random_pool_seeded());
+    for (uint32_t i = 0; i < RANDOM_POOL_RESEED_INTERVAL; i++)
+    {
+        random_pool_get(aui8First, RANDOM_POOL_KEY_SIZE);
+    }
+    CHECK(random_pool_blocks == RANDOM_POOL_RESEED_INTERVAL);
+    random_pool_get(aui8First, 1);
+    CHECK(random_pool_entropy_ready);
+    random_pool_get(aui8First, 1);
+    CHECK(!random_pool_entropy_ready);
+    CHECK(random_pool_blocks == 1);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,287 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "am_mcu_apollo.h"
+#include "wsf_types.h"
+#include "wsf_nvm.h"
+#include "util/crc32.h"
+#include "ble_config.h"
+
+#include "test.h"
+
+#define IDS        24
+#define MAX_LEN    200
+
+#define SECTOR_SIZE ((WSF_NVM_NUM_OF_PAGES / 2) * WSF_NVM_PAGE_SIZE)
+
+static uint8_t model[IDS][MAX_LEN];
+static uint16_t model_len[IDS];
+static uint8_t previous[IDS][MAX_LEN];
+static uint16_t previous_len[IDS];
+
+static bool stored(uint32_t id, const uint8_t *pui8Data, uint16_t ui16Length)
+{
+    uint8_t aui8Read[MAX_LEN];
+
+    if (ui16Length == 0)
+    {
+        return !WsfNvmReadData(id, aui8Read, 1, NULL);
+    }
+
+    return WsfNvmReadData(id, aui8Read, ui16Length, NULL) &&
+           (memcmp(aui8Read, pui8Data, ui16Length) == 0);
+}
+
+// Random writes and erases, cut at random points of programming or erasing.
+// After a cut, the ID being written holds its old or its new data and every
+// other ID is intact.
+static void power_cuts(void)
+{
+    uint8_t aui8Buffer[MAX_LEN];
+    int cuts = 0;
+
+    flash_stub_setup();
+    memset(model_len, 0, sizeof(model_len));
+    WsfNvmInit();
+
+    srand(3);
+    for (int iteration = 0; iteration < 30000 && !test_failures; iteration++)
+    {
+        uint32_t k = rand() % IDS;
+        uint16_t ui16Length = 1 + rand() % MAX_LEN;
+
+        for (uint32_t i = 0; i < ui16Length; i++)
+        {
+            aui8Buffer[i] = rand();
+        }
+
+        memcpy(previous, model, sizeof(model));
+        memcpy(previous_len, model_len, sizeof(model_len));
+        if (rand() % 40 == 0)
+        {
+            flash_stub_fail_after = rand() % 80;
+        }
+
+        if (setjmp(flash_stub_power_cut) == 0)
+        {
+            if (rand() % 8 == 0)
+            {
+                model_len[k] = 0;
+                WsfNvmEraseData(k + 1, NULL);
+            }
+            else
+            {
+                memcpy(model[k], aui8Buffer, ui16Length);
+                model_len[k] = ui16Length;
+                CHECK(WsfNvmWriteData(k + 1, aui8Buffer, ui16Length, NULL));
+            }
+            flash_stub_fail_after = -1;
+        }
+        else
+        {
+            cuts++;
+            WsfNvmInit();
+
+            for (uint32_t j = 0; j < IDS; j++)
+            {
+                if (stored(j + 1, model[j], model_len[j]))
+                {
+                    continue;
+                }
+                CHECK((j == k) && stored(j + 1, previous[j], previous_len[j]));
+                memcpy(model[j], previous[j], sizeof(model[j]));
+                model_len[j] = previous_len[j];
+            }
+            continue;
+        }
+
+        if (iteration % 97 == 0)
+        {
+            for (uint32_t j = 0; j < IDS; j++)
+            {
+                CHECK(stored(j + 1, model[j], model_len[j]));
+            }
+        }
+    }
+
+    CHECK(cuts > 0);
+}
+
+// Writes a record of the legacy layout: a single log from WSF_NVM_START_ADDR
+// without sector status, earlier copies scratched out, and the data tail past
+// the last whole word left unprogrammed.
+static void legacy_write(uint32_t id, const uint8_t *pui8Data, uint32_t ui32Length)
+{
+    uint32_t *pui32Record = (uint32_t *)(uintptr_t)WSF_NVM_START_ADDR;
+    uint32_t aui32Header[4];
+
+    while (pui32Record[0] != 0xFFFFFFFF)
+    {
+        if (pui32Record[0] == id)
+        {
+            pui32Record[0] = 0;
+            pui32Record[2] = 0;
+            pui32Record[3] = 0;
+        }
+        pui32Record += 4 + (pui32Record[1] + 3) / 4;
+    }
+
+    aui32Header[0] = id;
+    aui32Header[1] = ui32Length;
+    aui32Header[2] = CalcCrc32(0xFEDCBA98, 8, (const uint8_t *)aui32Header);
+    aui32Header[3] = CalcCrc32(0xFEDCBA98, ui32Length, pui8Data);
+    memcpy(pui32Record, aui32Header, sizeof(aui32Header));
+    memcpy(&pui32Record[4], pui8Data, ui32Length & ~3u);
+}
+
+// IDs 2 to 7 are live, ID 1 was erased and ID 8 has an unaligned length,
+// which the legacy layout never stored whole.
+static void legacy_setup(bool bScratchedFirst)
+{
+    flash_stub_setup();
+    memset(model_len, 0, sizeof(model_len));
+
+    if (bScratchedFirst)
+    {
+        legacy_write(1, model[0], 64);
+    }
+    for (int round = 0; round < 3; round++)
+    {
+        for (uint32_t k = 1; k < 7; k++)
+        {
+            for (uint32_t i = 0; i < 64; i++)
+            {
+                model[k][i] = rand();
+            }
+            model_len[k] = 64;
+            legacy_write(k + 1, model[k], 64);
+        }
+    }
+    legacy_write(8, model[7], 63);
+
+    if (bScratchedFirst)
+    {
+        // The first word of the area now reads as a superseded sector.
+        uint32_t *pui32Record = (uint32_t *)(uintptr_t)WSF_NVM_START_ADDR;
+
+        pui32Record[0] = 0;
+        pui32Record[2] = 0;
+        pui32Record[3] = 0;
+    }
+}
+
+static void check_model(void)
+{
+    for (uint32_t k = 0; k < 8; k++)
+    {
+        CHECK(stored(k + 1, model[k], model_len[k]));
+    }
+}
+
+static void legacy_migration(void)
+{
+    int cuts = 0;
+
+    srand(5);
+    legacy_setup(true);
+    WsfNvmInit();
+    check_model();
+    WsfNvmInit();
+    check_model();
+
+    // The migrated storage keeps working through compactions.
+    for (int i = 0; i < 2000; i++)
+    {
+        uint32_t k = 1 + rand() % 6;
+
+        for (uint32_t j = 0; j < 64; j++)
+        {
+            model[k][j] = rand();
+        }
+        WsfNvmWriteData(k + 1, model[k], 64, NULL);
+    }
+    check_model();
+
+    // A migration cut at any point is redone at the next init.
+    for (long step = 0; !test_failures; step++)
+    {
+        legacy_setup(false);
+        flash_stub_fail_after = step;
+        if (setjmp(flash_stub_power_cut) == 0)
+        {
+            WsfNvmInit();
+            flash_stub_fail_after = -1;
+            check_model();
+            break;
+        }
+        cuts++;
+        WsfNvmInit();
+        check_model();
+    }
+
+    CHECK(cuts > 0);
+}
+
+static void erase_sector(void)
+{
+    uint8_t aui8Data[16] = "erase sector";
+    uint32_t ui32Sector1 = WSF_NVM_START_ADDR + SECTOR_SIZE;
+
+    // Compactions move the active sector back and forth, erasing the first
+    // sector keeps the records when the second one is active.
+    flash_stub_setup();
+    WsfNvmInit();
+    while (*(const uint32_t *)(uintptr_t)ui32Sector1 == 0xFFFFFFFF)
+    {
+        CHECK(WsfNvmWriteData(1, aui8Data, sizeof(aui8Data), NULL));
+    }
+    WsfNvmEraseSector(WSF_NVM_NUM_OF_PAGES / 2, NULL);
+    CHECK(stored(1, aui8Data, sizeof(aui8Data)));
+
+    WsfNvmEraseSector(WSF_NVM_NUM_OF_PAGES, NULL);
+    CHECK(stored(1, aui8Data, 0));
+    CHECK(WsfNvmWriteData(1, aui8Data, sizeof(aui8Data), NULL));
+    CHECK(stored(1, aui8Data, sizeof(aui8Data)));
+}
+
+int main(void)
+{
+    power_cuts();
+    legacy_migration();
+    erase_sector();
+
+    return TEST_RESULT();
+}